@@ -0,0 +1,268 @@
+/*------------------------------------------------------------------------------
+-> File         : addressbook.c
+-> Description  : Library interface over the contact store (addressbook.h),
+                  for programs that keep a book open instead of running the
+                  menu or shelling out to the command line.
+
+                  addressbook_open does what the program used to do at
+                  start: map data.snap, or import data.txt when there is
+                  no snapshot yet (or it is damaged) or an import is asked
+                  for, then replay and keep the change log. A log that an
+                  import leaves behind is moved aside, never emptied. Changes are checked against the same rules
+                  and uniqueness as the menu, and name contacts by mobile
+                  number or mail ID, since contact indices change as the
+                  store compacts. Lookups fill in a Contact_data whose
+                  Name and Mail_ID point into the book's string arena:
+                  valid until the next change or close, not copies.
+
+                  Nothing is prompted or printed. The warnings the loader
+                  and change log used to print (skipped lines, a torn log)
+                  go through report_problem, which drops them unless a
+                  stream is chosen with addressbook_set_diagnostics.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include vfprintf for diagnostics, snprintf
+#include <stdlib.h>     // Include memory functions (malloc, free)
+#include <string.h>     // Include string handling functions (strchr, strcmp, strlen)
+#include <stdarg.h>     // Include va_list for report_problem
+#include <fcntl.h>      // Include open for text imports
+#include <unistd.h>     // Include close
+#include <sys/stat.h>   // Include stat to find data.snap
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "stats.h"      // Include operation counters
+
+static FILE *diagnostics; // Stream for report_problem, NULL to drop its warnings
+
+/*------------------- Diagnostics -------------------*/
+void addressbook_set_diagnostics(FILE *stream)
+{
+    diagnostics = stream;
+}
+
+void report_problem(const char *format, ...)
+{
+    if (diagnostics == NULL)
+        return;
+    va_list args;
+    va_start(args, format);
+    vfprintf(diagnostics, format, args);
+    va_end(args);
+}
+
+const char *addressbook_message(int result)
+{
+    switch (result)
+    {
+        case ADDRESSBOOK_OK:           return "Done";
+        case ADDRESSBOOK_NOT_FOUND:    return "No contact has that mobile number or mail ID";
+        case ADDRESSBOOK_NO_MEMORY:    return "Not enough memory";
+        case ADDRESSBOOK_IO_ERROR:     return "Could not read or write the address book files";
+        case ADDRESSBOOK_BAD_ARGUMENT: return "Bad argument";
+    }
+    return result > 0 ? validation_message(result) : "Unknown error";
+}
+
+/*------------------- Open / Close -------------------*/
+static char *join_path(const char *directory, const char *name) // malloc'd "directory/name", NULL if out of memory
+{
+    size_t length = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(length);
+    if (path != NULL && strcmp(directory, ".") == 0)
+        snprintf(path, length, "%s", name); // Plain names in messages, as before the library
+    else if (path != NULL)
+        snprintf(path, length, "%s/%s", directory, name);
+    return path;
+}
+
+static int import_text(struct Address_book *addressbook, const char *path) // Append, sort and index a data.txt-format file
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return ADDRESSBOOK_IO_ERROR;
+    uint64_t start = stats_begin();
+    int bad = load_contacts_fd(fd, addressbook, path); // Bad lines are skipped and reported
+    close(fd);
+    if (bad < 0)
+        return ADDRESSBOOK_NO_MEMORY;
+    sort_contacts_by_name(addressbook); // Loads in name order help the index build and the next save
+    int status = rebuild_indexes(addressbook) == 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+    stats_end(STAT_LOAD, start);
+    return status;
+}
+
+static int open_files(struct Address_book *addressbook, const char *directory, const char *import_path) // Fill an empty book, ADDRESSBOOK_OK or an error
+{
+    if (directory == NULL) // In memory: nothing is read but the import, nothing is logged
+        return import_path != NULL ? import_text(addressbook, import_path) : ADDRESSBOOK_OK;
+
+    char *data = join_path(directory, DATA_FILE);
+    char *snapshot = join_path(directory, SNAPSHOT_FILE);
+    char *log = join_path(directory, LOG_FILE);
+    int status = data != NULL && snapshot != NULL && log != NULL ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+    long long generation = -1; // Text import: the change log starts afresh
+    uint64_t snapshot_generation;
+    struct stat snap;
+    if (status == ADDRESSBOOK_OK && import_path == NULL && stat(snapshot, &snap) == 0) // data.txt only when asked for, or on first use
+    {
+        if (open_snapshot(snapshot, addressbook, &snapshot_generation) == 0) // Mapped, nothing parsed
+            generation = (long long)snapshot_generation;
+        else
+            report_problem("Warning: %s is damaged or from another version, importing %s\n", snapshot, data);
+    }
+    if (status == ADDRESSBOOK_OK && generation < 0)
+        status = import_text(addressbook, import_path != NULL ? import_path : data);
+    if (status == ADDRESSBOOK_OK && wal_open(addressbook, log, snapshot, generation) < 0) // Redo changes made since the snapshot, log the rest (an import sets an older log aside)
+        status = ADDRESSBOOK_IO_ERROR;
+    free(data);
+    free(snapshot);
+    free(log);
+    return status;
+}
+
+struct Address_book *addressbook_open(const char *directory, const char *import_path, int *error)
+{
+    struct Address_book *addressbook = malloc(sizeof(*addressbook));
+    int status = addressbook != NULL ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+    if (addressbook != NULL)
+    {
+        init_address_book(addressbook);
+        status = open_files(addressbook, directory, import_path);
+        if (status != ADDRESSBOOK_OK)
+        {
+            destroy_address_book(addressbook); // Also closes a change log already opened
+            free(addressbook);
+            addressbook = NULL;
+        }
+    }
+    if (error != NULL)
+        *error = status;
+    return addressbook;
+}
+
+int addressbook_close(struct Address_book *addressbook)
+{
+    if (addressbook == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int status = addressbook->wal != NULL && wal_close(addressbook) != 0 ? ADDRESSBOOK_IO_ERROR : ADDRESSBOOK_OK;
+    destroy_address_book(addressbook);
+    free(addressbook);
+    return status;
+}
+
+int addressbook_sync(struct Address_book *addressbook)
+{
+    if (addressbook == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    return addressbook->wal != NULL && wal_sync(addressbook) != 0 ? ADDRESSBOOK_IO_ERROR : ADDRESSBOOK_OK;
+}
+
+/*------------------- Changes -------------------*/
+int find_by_key(const struct Address_book *addressbook, const char *key) // A key with '@' is a mail ID, anything else a mobile number
+{
+    return strchr(key, '@') != NULL ? find_by_mail(addressbook, key) : find_by_mobile(addressbook, key);
+}
+
+int check_change(const struct Address_book *addressbook, const struct Contact_data *contact, int index) // The one place the rules and uniqueness are checked
+{
+    int error = check_contact(contact);
+    int mobile_owner = error == VALID ? find_by_mobile(addressbook, contact->Mobile_number) : -1;
+    int mail_owner = error == VALID ? find_by_mail(addressbook, contact->Mail_ID) : -1;
+    if (error == VALID && mobile_owner != -1 && mobile_owner != index)
+        error = DUPLICATE_MOBILE;
+    if (error == VALID && mail_owner != -1 && mail_owner != index)
+        error = DUPLICATE_MAIL;
+    return error;
+}
+
+int addressbook_insert(struct Address_book *addressbook, const struct Contact_data *contact)
+{
+    if (addressbook == NULL || contact == NULL || contact->Name == NULL || contact->Mail_ID == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int error = check_change(addressbook, contact, -1);
+    if (error != VALID)
+        return error;
+    return insert_contact(addressbook, contact) >= 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+}
+
+int addressbook_update(struct Address_book *addressbook, const char *key, const struct Contact_data *contact)
+{
+    if (addressbook == NULL || key == NULL || contact == NULL || contact->Name == NULL || contact->Mail_ID == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int index = find_by_key(addressbook, key);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    int error = check_change(addressbook, contact, index);
+    if (error != VALID)
+        return error;
+    return update_contact(addressbook, index, contact) == 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+}
+
+int addressbook_delete(struct Address_book *addressbook, const char *key)
+{
+    if (addressbook == NULL || key == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int index = find_by_key(addressbook, key);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    remove_contact(addressbook, index);
+    return ADDRESSBOOK_OK;
+}
+
+/*------------------- Lookups -------------------*/
+int addressbook_get_by_mobile(const struct Address_book *addressbook, const char *mobile_number, struct Contact_data *contact)
+{
+    if (addressbook == NULL || mobile_number == NULL || contact == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int index = find_by_mobile(addressbook, mobile_number);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    get_contact(addressbook, index, contact);
+    return ADDRESSBOOK_OK;
+}
+
+int addressbook_get_by_mail(const struct Address_book *addressbook, const char *mail_id, struct Contact_data *contact)
+{
+    if (addressbook == NULL || mail_id == NULL || contact == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int index = find_by_mail(addressbook, mail_id);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    get_contact(addressbook, index, contact);
+    return ADDRESSBOOK_OK;
+}
+
+int addressbook_count(const struct Address_book *addressbook)
+{
+    return addressbook != NULL ? count_contacts(addressbook) : 0;
+}
+
+int addressbook_each(const struct Address_book *addressbook, int (*visit)(const struct Contact_data *contact, void *context),
+                     void *context) // Walks the name index, nothing is copied or sorted
+{
+    if (addressbook == NULL || visit == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int visited = 0;
+    for (int i = first_contact(addressbook); i != -1; i = next_contact(addressbook, i))
+    {
+        visited++;
+        struct Contact_data contact;
+        get_contact(addressbook, i, &contact);
+        if (visit(&contact, context) != 0)
+            break;
+    }
+    return visited;
+}
+
+int addressbook_query(struct Address_book *addressbook, const char *text, int offset, int limit,
+                      struct Contact_data *contacts, int *total) // Ranked partial search (text_search) on both fields
+{
+    if (addressbook == NULL || text == NULL || offset < 0 || limit < 0 || (limit > 0 && contacts == NULL) || total == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    struct Search_hit *hits = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(*hits));
+    if (hits == NULL)
+        return ADDRESSBOOK_NO_MEMORY;
+    int found = text_search(addressbook, text, SEARCH_NAME | SEARCH_MAIL, offset, limit, hits, total);
+    for (int i = 0; i < found; i++)
+        get_contact(addressbook, hits[i].index, &contacts[i]);
+    free(hits);
+    return found >= 0 ? found : ADDRESSBOOK_NO_MEMORY;
+}
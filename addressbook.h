@@ -0,0 +1,52 @@
+#ifndef ADDRESSBOOK_H       // Header guard start, prevents multiple inclusion
+#define ADDRESSBOOK_H
+
+#include <stdio.h>          // FILE for diagnostics
+#include "validate.h"       // Validation error codes (VALID, NAME_EMPTY, ... DUPLICATE_MAIL)
+
+/* Library interface (addressbook.c), built as libaddressbook.a / libaddressbook.so.
+   Nothing here prompts or prints: every function reports through its return value.
+   A book is used by one thread at a time (shared.h serves many readers).
+   Contacts handed out point into the book: their Name and Mail_ID stay valid
+   until the book is next changed or closed. */
+
+#define ADDRESSBOOK_OK 0                // Same value as VALID
+#define ADDRESSBOOK_NOT_FOUND -1        // No contact has that mobile number or mail ID
+#define ADDRESSBOOK_NO_MEMORY -2        // Out of memory, the book is unchanged
+#define ADDRESSBOOK_IO_ERROR -3         // A file could not be read or written
+#define ADDRESSBOOK_BAD_ARGUMENT -4     // Missing pointer or negative count
+/* Positive results are validate.h codes: the contact breaks that rule and was not stored */
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Contact_data       // Structure to pass individual contact information
+{
+    const char *Name;     // Name of contact, any length
+    char Mobile_number[11]; // Mobile number (10 digits + null terminator)
+    const char *Mail_ID;  // Email ID of contact, any length
+};
+
+struct Address_book;      // Opaque to library users, defined in contact.h
+
+/*------------------ Function Declarations ------------------*/
+
+struct Address_book *addressbook_open(const char *directory, const char *import_path, int *error); // Book kept in 'directory' (data.snap + data.wal, else data.txt) or imported from 'import_path'; NULL directory = in memory only. NULL and *error on failure
+int addressbook_close(struct Address_book *addressbook); // Make every change durable and free the book, ADDRESSBOOK_OK or ADDRESSBOOK_IO_ERROR
+int addressbook_sync(struct Address_book *addressbook); // Wait until every change so far is on disk, ADDRESSBOOK_OK or ADDRESSBOOK_IO_ERROR
+
+int addressbook_insert(struct Address_book *addressbook, const struct Contact_data *contact); // Add a contact, ADDRESSBOOK_OK, a validate.h code or an error
+int addressbook_update(struct Address_book *addressbook, const char *key, const struct Contact_data *contact); // Replace the contact with this mobile or mail, same results
+int addressbook_delete(struct Address_book *addressbook, const char *key); // Delete the contact with this mobile or mail, ADDRESSBOOK_OK or ADDRESSBOOK_NOT_FOUND
+
+int addressbook_get_by_mobile(const struct Address_book *addressbook, const char *mobile_number, struct Contact_data *contact); // Fill in the contact, ADDRESSBOOK_OK or ADDRESSBOOK_NOT_FOUND
+int addressbook_get_by_mail(const struct Address_book *addressbook, const char *mail_id, struct Contact_data *contact); // Same, by mail ID
+int addressbook_count(const struct Address_book *addressbook); // Number of contacts
+int addressbook_each(const struct Address_book *addressbook, int (*visit)(const struct Contact_data *contact, void *context),
+                     void *context); // Visit contacts in name order until 'visit' returns non-zero (no changes meanwhile), contacts visited
+int addressbook_query(struct Address_book *addressbook, const char *text, int offset, int limit,
+                      struct Contact_data *contacts, int *total); // Contacts whose Name or Mail ID holds 'text', best first, paged; written or an error
+
+const char *addressbook_message(int result); // Text for any result above
+void addressbook_set_diagnostics(FILE *stream); // Where skipped-line and change-log warnings go (default NULL: dropped)
+
+#endif // ADDRESSBOOK_H      // End of header guard
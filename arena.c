@@ -0,0 +1,132 @@
+/*------------------------------------------------------------------------------
+-> File         : arena.c
+-> Description  : String arena for variable-length text (contact names and
+                  mail IDs, folded index keys). Every string has an 8-byte
+                  slot: a string of up to 7 characters sits inside the slot
+                  and allocates nothing, a longer one is bump-allocated in
+                  one growable block and the slot holds its offset and
+                  length. The top byte of the slot tells the two apart (an
+                  inline string is zero padded, so that byte is its NUL).
+
+                  Strings are never moved one at a time: a changed string
+                  is stored anew and the old bytes are counted as garbage.
+                  The owner compacts by copying its live strings into a
+                  fresh arena with arena_move once arena_wasteful says the
+                  garbage is worth it (store.c, name_index.c), or when it
+                  writes a snapshot (snapshot.c).
+
+                  An arena may borrow its bytes from a snapshot mapping;
+                  the first growth copies them to the heap.
+------------------------------------------------------------------------------*/
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free)
+#include <string.h>     // Include string handling functions (memcpy, memset)
+#include "arena.h"      // Include arena declarations
+
+#define ARENA_MIN_CAPACITY 4096 // First block allocated
+
+/*------------------- Initialise / Free -------------------*/
+void arena_init(struct Text_arena *arena) // No bytes yet
+{
+    memset(arena, 0, sizeof(*arena));
+}
+
+void arena_free(struct Text_arena *arena) // Release the bytes, if they are ours
+{
+    if (!arena->borrowed)
+        free(arena->bytes);
+    arena_init(arena);
+}
+
+/*------------------- Slot Lengths -------------------*/
+size_t arena_length(const union Text_slot *slot) // Inline strings are measured, arena strings carry their length
+{
+    if (!slot->far.tag)
+        return strnlen(slot->text, TEXT_INLINE_SIZE);
+    return (size_t)slot->far.length[0] | (size_t)slot->far.length[1] << 8 | (size_t)slot->far.length[2] << 16;
+}
+
+size_t arena_need(size_t length) // The string and its NUL, unless it fits the slot
+{
+    return length < TEXT_INLINE_SIZE ? 0 : length + 1;
+}
+
+int arena_wasteful(const struct Text_arena *arena) // Half the arena is garbage, and enough of it to matter
+{
+    return arena->garbage >= ARENA_COMPACT_MIN && arena->garbage * 2 >= arena->used;
+}
+
+/*------------------- Reserve Room -------------------*/
+int arena_reserve(struct Text_arena *arena, size_t bytes, const char **texts, int count) // Grow once for several strings
+{
+    if (arena->used + bytes <= arena->capacity)
+        return 0;
+    if (arena->used + bytes > UINT32_MAX) // Offsets are 32-bit
+        return -1;
+
+    size_t capacity = arena->capacity > ARENA_MIN_CAPACITY / 2 ? arena->capacity * 2 : ARENA_MIN_CAPACITY;
+    if (capacity < arena->used + bytes) // A bulk reservation gets exactly what it asks for
+        capacity = arena->used + bytes;
+    if (capacity > (size_t)UINT32_MAX + 1)
+        capacity = (size_t)UINT32_MAX + 1;
+
+    char *old = arena->bytes, *bytes_new;
+    if (arena->borrowed) // First growth of a mapped arena: copy it out, the mapping stays as it is
+    {
+        bytes_new = malloc(capacity);
+        if (bytes_new != NULL && arena->used > 0)
+            memcpy(bytes_new, old, arena->used);
+    }
+    else
+        bytes_new = realloc(old, capacity);
+    if (bytes_new == NULL)
+        return -1;
+
+    for (int i = 0; i < count; i++) // Strings read from this arena move with it
+        if (texts[i] != NULL && old != NULL && texts[i] >= old && texts[i] < old + arena->used)
+            texts[i] = bytes_new + (texts[i] - old);
+    arena->bytes = bytes_new;
+    arena->capacity = capacity;
+    arena->borrowed = 0;
+    return 0;
+}
+
+/*------------------- Store / Drop -------------------*/
+int arena_store(struct Text_arena *arena, union Text_slot *slot, const char *text, size_t length) // Fill a slot, 0 or -1
+{
+    if (length < TEXT_INLINE_SIZE) // Short string: no allocation
+    {
+        char inline_text[TEXT_INLINE_SIZE] = { 0 }; // Zero padding included, so the tag byte is 0
+        memcpy(inline_text, text, length);
+        memcpy(slot->text, inline_text, TEXT_INLINE_SIZE); // 'text' may be this very slot
+        return 0;
+    }
+    if (length > TEXT_MAX_LENGTH || arena_reserve(arena, length + 1, &text, 1) != 0)
+        return -1;
+    memcpy(arena->bytes + arena->used, text, length);
+    arena->bytes[arena->used + length] = '\0';
+    slot->far.offset = (uint32_t)arena->used;
+    slot->far.length[0] = (uint8_t)length;
+    slot->far.length[1] = (uint8_t)(length >> 8);
+    slot->far.length[2] = (uint8_t)(length >> 16);
+    slot->far.tag = 1;
+    arena->used += length + 1;
+    return 0;
+}
+
+void arena_drop(struct Text_arena *arena, union Text_slot *slot) // The slot becomes an empty string
+{
+    if (slot->far.tag)
+        arena->garbage += arena_length(slot) + 1;
+    memset(slot, 0, sizeof(*slot));
+}
+
+/*------------------- Compaction -------------------*/
+void arena_move(struct Text_arena *to, const struct Text_arena *from, union Text_slot *slot) // One live string into the fresh arena
+{
+    if (!slot->far.tag)
+        return; // Inline: nothing to copy
+    size_t size = arena_length(slot) + 1;
+    memcpy(to->bytes + to->used, from->bytes + slot->far.offset, size);
+    slot->far.offset = (uint32_t)to->used;
+    to->used += size;
+}
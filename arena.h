@@ -0,0 +1,50 @@
+#ifndef ARENA_H             // Header guard start, prevents multiple inclusion
+#define ARENA_H
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint32_t arena offsets
+
+#define TEXT_INLINE_SIZE 8          // Strings shorter than this are kept in their slot, longer ones in the arena
+#define TEXT_MAX_LENGTH 0xffffff    // Longest string a slot can refer to (24-bit length)
+#define ARENA_COMPACT_MIN 65536     // Garbage bytes tolerated before compaction is considered
+
+/*------------------ Structure Declarations ------------------*/
+
+union Text_slot             // One string: the text itself, or where it sits in an arena
+{
+    char text[TEXT_INLINE_SIZE]; // Short string, NUL-terminated and zero padded (so text[7] is '\0')
+    struct
+    {
+        uint32_t offset;    // Arena offset of the NUL-terminated string
+        uint8_t length[3];  // Its strlen, low byte first
+        uint8_t tag;        // Non-zero: the string is in the arena
+    } far;
+};
+
+struct Text_arena           // Longer strings, bump-allocated back to back
+{
+    char *bytes;            // The strings, each followed by its NUL
+    size_t used;            // Bytes handed out
+    size_t capacity;        // Bytes allocated
+    size_t garbage;         // Bytes of strings since dropped, reclaimed by compaction
+    int borrowed;           // 'bytes' belong to a snapshot mapping: copied out on the first growth, never freed here
+};
+
+/*------------------ Function Declarations ------------------*/
+
+static inline const char *arena_text(const struct Text_arena *arena, const union Text_slot *slot) // The string a slot holds
+{
+    return slot->far.tag ? arena->bytes + slot->far.offset : slot->text;
+}
+
+void arena_init(struct Text_arena *arena); // Empty arena
+void arena_free(struct Text_arena *arena); // Release the bytes (unless borrowed), leave it empty
+size_t arena_length(const union Text_slot *slot); // strlen of the string a slot holds
+size_t arena_need(size_t length); // Arena bytes a string of this length takes (0 when it fits its slot)
+int arena_reserve(struct Text_arena *arena, size_t bytes, const char **texts, int count); // Room for 'bytes' more without moving; texts[] pointing into the arena follow it, 0 or -1
+int arena_store(struct Text_arena *arena, union Text_slot *slot, const char *text, size_t length); // Keep 'length' bytes of text (plus a NUL) for a slot, 0 or -1
+void arena_drop(struct Text_arena *arena, union Text_slot *slot); // Forget a slot's string, its arena bytes become garbage
+void arena_move(struct Text_arena *to, const struct Text_arena *from, union Text_slot *slot); // Copy a slot's string from 'from' into 'to' (room reserved) and point the slot there
+int arena_wasteful(const struct Text_arena *arena); // Enough garbage that compaction pays?
+
+#endif // ARENA_H            // End of header guard
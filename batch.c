@@ -0,0 +1,306 @@
+/*------------------------------------------------------------------------------
+-> File         : batch.c
+-> Description  : Non-interactive batch mode: runs a stream of records or
+                  commands through the same library calls as the menu
+                  (addressbook_insert, addressbook_update,
+                  addressbook_delete and the index lookups), with no
+                  prompts and no per-record output, so records meet the
+                  same rules and uniqueness checks. Bad lines are reported on stderr with their line
+                  number (up to MAX_REPORTED) and skipped; the run ends
+                  with one summary line.
+
+                  import   one "Name,Mobile,Mail" record per line ('#' lines skipped)
+                  delete   one mobile number or mail ID per line (removed in
+                           blocks of DELETE_BLOCK through remove_contacts)
+                  query    one mobile number, mail ID or name per line, or a
+                           mobile prefix ending in '*' (98765*)
+                  batch    one command per line:
+                             add Name,Mobile,Mail
+                             edit KEY Name,Mobile,Mail   (KEY = mobile or mail)
+                             delete KEY
+                             find KEY                    (KEY may also be a name or 98765*)
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (getline, printf)
+#include <stdlib.h>     // Include free, realloc
+#include <string.h>     // Include string handling functions (strchr, strcmp)
+#include <strings.h>    // Include strcasecmp for names in any case
+#include <sys/types.h>  // Include ssize_t for getline
+#include <time.h>       // Include clock_gettime for the summary
+#include "contact.h"    // Include structure definitions and function prototypes
+
+#define MAX_REPORTED 20         // Bad lines printed before only counting them
+#define DELETE_BLOCK 4096       // Keys of a delete stream removed per remove_contacts call
+#define MOBILE_MATCHES 1024     // Mobile prefix matches collected without allocating
+
+struct Batch_stats              // Totals printed in the summary
+{
+    long line;                  // Current line number
+    long added, edited, deleted, found, missing, duplicate, bad;
+    int shown;                  // Bad lines printed so far
+};
+
+/*------------------- Helpers -------------------*/
+static void report(struct Batch_stats *stats, const char *source, const char *reason) // Count and maybe print a skipped line
+{
+    stats->bad++;
+    if (stats->shown++ < MAX_REPORTED)
+        fprintf(stderr, "%s:%ld: %s, line skipped\n", source, stats->line, reason);
+}
+
+static int find_match(const struct Address_book *addressbook, const char *key) // Contact named by a mobile, mail or name
+{
+    if (strchr(key, '@') != NULL)
+        return find_by_mail(addressbook, key);
+    if (key[0] >= '0' && key[0] <= '9')
+        return find_by_mobile(addressbook, key);
+    return find_by_name(addressbook, key);
+}
+
+static int count_result(int result, struct Batch_stats *stats, const char *source) // Tally a library result, 0 or -1 (out of memory)
+{
+    if (result == ADDRESSBOOK_NO_MEMORY)
+        return -1;
+    if (result == ADDRESSBOOK_NOT_FOUND)
+        stats->missing++;
+    else if (result == DUPLICATE_MOBILE || result == DUPLICATE_MAIL)
+        stats->duplicate++; // Mobile or mail belongs to another contact
+    else if (result != ADDRESSBOOK_OK)
+        report(stats, source, addressbook_message(result)); // Broken rule, same as the menu prompts
+    return 0;
+}
+
+static void print_contact(const struct Address_book *addressbook, int index) // One match, in data.txt format
+{
+    printf("%s,%s,%s\n", contact_name(addressbook, index), contact_mobile(addressbook, index), contact_mail(addressbook, index));
+}
+
+/*------------------- Operations -------------------*/
+static int batch_add(struct Address_book *addressbook, char *text, size_t length, struct Batch_stats *stats, const char *source)
+{
+    struct Contact_data contact;
+    const char *reason = parse_record(text, length, &contact);
+    if (reason != NULL)
+    {
+        report(stats, source, reason);
+        return 0;
+    }
+    int result = addressbook_insert(addressbook, &contact);
+    if (result == ADDRESSBOOK_OK)
+        stats->added++;
+    return count_result(result, stats, source);
+}
+
+static int batch_edit(struct Address_book *addressbook, char *text, struct Batch_stats *stats, const char *source)
+{
+    char *space = strchr(text, ' '); // KEY, then the new record
+    if (space == NULL)
+    {
+        report(stats, source, "edit needs a key and a record");
+        return 0;
+    }
+    *space = '\0';
+    struct Contact_data contact;
+    const char *reason = parse_record(space + 1, strlen(space + 1), &contact);
+    if (reason != NULL)
+    {
+        report(stats, source, reason);
+        return 0;
+    }
+    int result = addressbook_update(addressbook, text, &contact);
+    if (result == ADDRESSBOOK_OK)
+        stats->edited++;
+    return count_result(result, stats, source);
+}
+
+static void batch_delete(struct Address_book *addressbook, const char *key, struct Batch_stats *stats)
+{
+    if (addressbook_delete(addressbook, key) == ADDRESSBOOK_OK)
+        stats->deleted++;
+    else
+        stats->missing++;
+}
+
+struct Delete_block             // Keys of a delete stream, handed to remove_contacts in one call
+{
+    char *text;                 // The keys back to back, each with its NUL
+    size_t used, capacity;
+    size_t offsets[DELETE_BLOCK]; // Where each key starts in 'text'
+    const char *pointers[DELETE_BLOCK];
+    int count;
+};
+
+static void flush_deletes(struct Address_book *addressbook, struct Delete_block *block, struct Batch_stats *stats)
+{
+    for (int k = 0; k < block->count; k++) // 'text' is final now
+        block->pointers[k] = block->text + block->offsets[k];
+    int removed = remove_contacts(addressbook, block->pointers, block->count); // One pass, at most one compaction
+    stats->deleted += removed;
+    stats->missing += block->count - removed;
+    block->count = 0;
+    block->used = 0;
+}
+
+static int queue_delete(struct Address_book *addressbook, const char *key, size_t length, struct Delete_block *block,
+                        struct Batch_stats *stats) // 0 or -1 (out of memory)
+{
+    if (block->used + length + 1 > block->capacity)
+    {
+        size_t capacity = block->capacity ? block->capacity : 4096;
+        while (capacity < block->used + length + 1)
+            capacity *= 2;
+        char *text = realloc(block->text, capacity);
+        if (text == NULL)
+            return -1;
+        block->text = text;
+        block->capacity = capacity;
+    }
+    memcpy(block->text + block->used, key, length + 1);
+    block->offsets[block->count] = block->used;
+    block->used += length + 1;
+    if (++block->count == DELETE_BLOCK)
+        flush_deletes(addressbook, block, stats);
+    return 0;
+}
+
+static int batch_find_range(struct Address_book *addressbook, const char *key, size_t length, int print, struct Batch_stats *stats)
+{
+    char prefix[12]; // "98765*": every mobile starting with 98765, from the packed mobile column
+    int some[MOBILE_MATCHES], *matches = some;
+    if (length > sizeof(prefix))
+    {
+        stats->missing++;
+        return 0;
+    }
+    memcpy(prefix, key, length - 1);
+    prefix[length - 1] = '\0';
+    int total = find_by_mobile_prefix(addressbook, prefix, matches, MOBILE_MATCHES);
+    if (total > MOBILE_MATCHES && print) // Rare: scan again with room for all of them
+    {
+        if ((matches = malloc((size_t)total * sizeof(int))) == NULL)
+            return -1;
+        find_by_mobile_prefix(addressbook, prefix, matches, total);
+    }
+    if (total <= 0)
+        stats->missing++;
+    else
+        stats->found++;
+    for (int k = 0; print && k < total; k++)
+        print_contact(addressbook, matches[k]);
+    if (matches != some)
+        free(matches);
+    return total < 0 ? -1 : 0;
+}
+
+static int batch_find(struct Address_book *addressbook, const char *key, int print, struct Batch_stats *stats)
+{
+    size_t length = strlen(key);
+    if (length > 0 && key[length - 1] == '*')
+        return batch_find_range(addressbook, key, length, print, stats);
+    int index = find_match(addressbook, key);
+    if (index == -1)
+    {
+        stats->missing++;
+        return 0;
+    }
+    stats->found++;
+    if (!print)
+        return 0;
+    if (strchr(key, '@') != NULL || (key[0] >= '0' && key[0] <= '9'))
+    {
+        print_contact(addressbook, index);
+        return 0;
+    }
+    const char *name = contact_name(addressbook, index); // Every contact with this name (any case) sits together
+    for (int i = index; i != -1 && strcasecmp(contact_name(addressbook, i), name) == 0;
+         i = next_contact(addressbook, i))
+        print_contact(addressbook, i);
+    return 0;
+}
+
+/*------------------- Run Batch -------------------*/
+int run_batch(struct Address_book *addressbook, const char *command, FILE *in, const char *source, int print) // Whole stream, then one summary
+{
+    int mode = strcmp(command, "import") == 0 ? 'i' : strcmp(command, "delete") == 0 ? 'd'
+             : strcmp(command, "query") == 0 ? 'q' : strcmp(command, "batch") == 0 ? 'b' : 0;
+    if (mode == 0)
+        return -1;
+
+    struct Batch_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    struct Delete_block *block = NULL; // Delete streams go through the bulk API
+    if (mode == 'd' && (block = malloc(sizeof(*block))) == NULL)
+    {
+        printf("Error: not enough memory\n");
+        return -1;
+    }
+    if (block != NULL)
+    {
+        block->text = NULL; // No keys yet
+        block->used = block->capacity = 0;
+        block->count = 0;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    int status = 0;
+    while (status == 0 && (length = getline(&line, &capacity, in)) != -1)
+    {
+        stats.line++;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        if (length == 0 || line[0] == '#') // Blank line, header or comment
+            continue;
+
+        if (mode == 'i')
+            status = batch_add(addressbook, line, (size_t)length, &stats, source);
+        else if (mode == 'd')
+            status = queue_delete(addressbook, line, (size_t)length, block, &stats);
+        else if (mode == 'q')
+            status = batch_find(addressbook, line, print, &stats);
+        else // Command stream: verb, one space, argument
+        {
+            char *argument = strchr(line, ' ');
+            if (argument == NULL)
+            {
+                report(&stats, source, "missing argument");
+                continue;
+            }
+            *argument++ = '\0';
+            if (strcmp(line, "add") == 0)
+                status = batch_add(addressbook, argument, strlen(argument), &stats, source);
+            else if (strcmp(line, "edit") == 0)
+                status = batch_edit(addressbook, argument, &stats, source);
+            else if (strcmp(line, "delete") == 0)
+                batch_delete(addressbook, argument, &stats);
+            else if (strcmp(line, "find") == 0)
+                status = batch_find(addressbook, argument, print, &stats);
+            else
+                report(&stats, source, "unknown command");
+        }
+    }
+    free(line);
+    if (block != NULL)
+    {
+        flush_deletes(addressbook, block, &stats);
+        free(block->text);
+        free(block);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    long ops = stats.added + stats.edited + stats.deleted + stats.found + stats.missing + stats.duplicate;
+    if (stats.shown > MAX_REPORTED)
+        fprintf(stderr, "%s: %d more bad lines not shown\n", source, stats.shown - MAX_REPORTED);
+    fprintf(print ? stderr : stdout, // Keep printed matches alone on stdout
+            "%s: %ld added, %ld edited, %ld deleted, %ld found, %ld not found, %ld duplicate, %ld bad lines; "
+            "%d contacts; %.3f s (%.0f ops/s)\n",
+            command, stats.added, stats.edited, stats.deleted, stats.found, stats.missing, stats.duplicate, stats.bad,
+            count_contacts(addressbook), elapsed, elapsed > 0 ? ops / elapsed : 0.0);
+    if (status != 0)
+        printf("Error: not enough memory, stopped at line %ld\n", stats.line);
+    return status;
+}
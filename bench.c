@@ -0,0 +1,998 @@
+/*------------------------------------------------------------------------------
+-> File         : bench.c
+-> Description  : Throughput benchmark for the address book store.
+                  For each size N it measures appending N contacts to an
+                  empty book, loading a data.txt file of N contacts with
+                  load_contact, and parsing the same bytes from memory,
+                  then saving and reopening the book as a binary snapshot,
+                  logging N adds to the change log, deleting half of N
+                  contacts one by one and in bulk, and validating N
+                  records with the batch validator and the scalar rules,
+                  answering mobile prefix queries from the packed
+                  mobile column and from the records, and answering
+                  misspelled name searches with fuzzy_search.
+
+-> Build        : make bench
+-> Usage        : ./bench [N ...]       (default: 10000 1000000 10000000)
+                  ./bench threads [N]   load scaling over 1, 2, 4 ... threads (default N: 1000000)
+                  ./bench durability [N] save and commit latency at each durability level (default N: 100000)
+                  ./bench concurrent [N] read QPS over 1, 2, 4 ... reader threads with a writer running (default N: 1000000)
+                  ./bench generate N [SEED] print a data.txt of N realistic contacts (skewed names and mail domains)
+                  ./bench json [--seed S] [N ...] load, sort, lookups, partial, fuzzy and sound-alike search, create, delete and
+                                        save on such books, as JSON with ops/sec, latency percentiles and
+                                        peak RSS per size (default N: 10^3 to 10^7), for tracking regressions
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (printf, fopen, etc.)
+#include <stdlib.h>     // Include standard library functions (atol, exit, etc.)
+#include <string.h>     // Include string handling functions
+#include <ctype.h>      // Include tolower for generated mail IDs
+#include <time.h>       // Include clock_gettime for timing
+#include <unistd.h>     // Include close, rmdir for temporary files, fork, chdir
+#include <sys/resource.h> // Include getrusage for peak RSS
+#include <sys/wait.h>   // Include waitpid for the per-size suite processes
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "workers.h"    // Include the thread-count knob
+#include "durability.h" // Include the durability knob
+#include "shared.h"     // Include the thread-safe book
+
+static double now_seconds(void) // Monotonic wall clock in seconds
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct Generated                // A generated contact and the text its fields point at
+{
+    struct Contact_data data;
+    char name[48], mail[48];
+};
+
+static void make_contact(struct Generated *contact, long i) // Build a unique, valid contact from a number
+{
+    char letters[8];
+    long n = i;
+    for (int k = 6; k >= 0; k--) // Spell the number in base 26 so names stay alphabetic
+    {
+        letters[k] = 'a' + n % 26;
+        n /= 26;
+    }
+    letters[7] = '\0';
+    letters[0] = 'A' + (letters[0] - 'a'); // Capitalise the first letter
+    snprintf(contact->name, sizeof(contact->name), "%s Kumar", letters);
+    snprintf(contact->data.Mobile_number, sizeof(contact->data.Mobile_number), "%010ld", 6000000000L + i % 1000000000L);
+    snprintf(contact->mail, sizeof(contact->mail), "user%07ld@mail.com", i);
+    contact->data.Name = contact->name;
+    contact->data.Mail_ID = contact->mail;
+}
+
+/*------------------- Append Benchmark -------------------*/
+static void bench_append(long n) // Time n appends into an empty book
+{
+    struct Address_book addressbook;
+    struct Generated contact;
+    init_address_book(&addressbook);
+
+    double start = now_seconds();
+    for (long i = 0; i < n; i++)
+    {
+        make_contact(&contact, i);
+        if (append_contact(&addressbook, &contact.data) == -1)
+        {
+            printf("append: out of memory at %ld contacts\n", i);
+            break;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("append   %10ld contacts  %8.3f s  %12.0f contacts/s\n",
+           n, elapsed, n / elapsed);
+    destroy_address_book(&addressbook);
+}
+
+static FILE *make_data_file(long n, long *bytes) // Temporary data.txt with n contacts
+{
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("could not create temporary file\n");
+        return NULL;
+    }
+
+    struct Generated contact;
+    fprintf(fp, "#%ld\n", n);
+    for (long i = 0; i < n; i++) // Same format save_contacts writes
+    {
+        make_contact(&contact, i);
+        fprintf(fp, "%s,%s,%s\n", contact.name, contact.data.Mobile_number, contact.mail);
+    }
+    *bytes = ftell(fp);
+    fflush(fp);
+    rewind(fp);
+    return fp;
+}
+
+/*------------------- Load Benchmark -------------------*/
+static void bench_load(long n) // Write a data file of n contacts and time load_contact on it
+{
+    long bytes;
+    FILE *fp = make_data_file(n, &bytes);
+    if (fp == NULL)
+        return;
+
+    struct Address_book addressbook;
+    init_address_book(&addressbook);
+
+    double start = now_seconds();
+    load_contact(fp, &addressbook);
+    double elapsed = now_seconds() - start;
+
+    printf("load     %10ld contacts  %8.3f s  %12.0f contacts/s  %8.1f MB/s\n",
+           (long)addressbook.contact_count, elapsed,
+           addressbook.contact_count / elapsed, bytes / elapsed / 1e6);
+    destroy_address_book(&addressbook);
+
+    // Parse only: same bytes already in memory, no sort or index build
+    char *text = malloc(bytes);
+    rewind(fp);
+    if (text != NULL && fread(text, 1, bytes, fp) == (size_t)bytes)
+    {
+        init_address_book(&addressbook);
+        reserve_contacts(&addressbook, (int)n);
+        start = now_seconds();
+        parse_contacts(text, bytes, &addressbook, "bench");
+        elapsed = now_seconds() - start;
+        printf("parse    %10ld contacts  %8.3f s  %12.0f contacts/s  %8.1f MB/s\n",
+               (long)addressbook.contact_count, elapsed,
+               addressbook.contact_count / elapsed, bytes / elapsed / 1e6);
+        destroy_address_book(&addressbook);
+    }
+    free(text);
+    fclose(fp);
+}
+
+/*------------------- Snapshot Benchmark -------------------*/
+static void bench_snapshot(long n) // Time save_snapshot and open_snapshot on a book of n contacts
+{
+    struct Address_book addressbook;
+    struct Generated contact;
+    init_address_book(&addressbook);
+    for (long i = 0; i < n; i++)
+    {
+        make_contact(&contact, i);
+        if (append_contact(&addressbook, &contact.data) == -1)
+            break;
+    }
+    rebuild_indexes(&addressbook); // make_contact names come out in order
+
+    char path[] = "/tmp/bench_snapshot_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        printf("could not create temporary file\n");
+        destroy_address_book(&addressbook);
+        return;
+    }
+    close(fd);
+
+    double start = now_seconds();
+    int saved = save_snapshot(&addressbook, path, 0);
+    double elapsed = now_seconds() - start;
+    destroy_address_book(&addressbook);
+    if (saved != 0)
+    {
+        printf("snapshot: could not save %ld contacts\n", n);
+        remove(path);
+        return;
+    }
+    printf("snapsave %10ld contacts  %8.3f s  %12.0f contacts/s\n", n, elapsed, n / elapsed);
+
+    init_address_book(&addressbook);
+    start = now_seconds();
+    uint64_t generation;
+    int opened = open_snapshot(path, &addressbook, &generation);
+    elapsed = now_seconds() - start;
+    if (opened == 0)
+        printf("snapopen %10ld contacts  %8.3f s  %12.0f contacts/s\n",
+               (long)addressbook.contact_count, elapsed, addressbook.contact_count / elapsed);
+    else
+        printf("snapshot: could not reopen %s\n", path);
+    destroy_address_book(&addressbook);
+    remove(path);
+}
+
+/*------------------- Change Log Benchmark -------------------*/
+static void bench_log(long n) // Time n inserts with a change log attached, including the final commit
+{
+    char dir[] = "/tmp/bench_log_XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        printf("could not create temporary directory\n");
+        return;
+    }
+    char log_path[64], snapshot_path[64];
+    snprintf(log_path, sizeof(log_path), "%s/data.wal", dir);
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s/data.snap", dir);
+
+    struct Address_book addressbook;
+    struct Generated contact;
+    init_address_book(&addressbook);
+    if (wal_open(&addressbook, log_path, snapshot_path, -1) < 0)
+    {
+        printf("log: could not open %s\n", log_path);
+        rmdir(dir);
+        return;
+    }
+
+    double start = now_seconds();
+    for (long i = 0; i < n; i++)
+    {
+        make_contact(&contact, i);
+        if (insert_contact(&addressbook, &contact.data) == -1)
+            break;
+    }
+    int status = wal_close(&addressbook); // Waits for compaction and the last group commit
+    double elapsed = now_seconds() - start;
+    printf("logged   %10ld contacts  %8.3f s  %12.0f contacts/s%s\n",
+           n, elapsed, n / elapsed, status == 0 ? "" : "  (write failed)");
+
+    destroy_address_book(&addressbook);
+    remove(log_path);
+    remove(snapshot_path);
+    rmdir(dir);
+}
+
+/*------------------- Delete Benchmark -------------------*/
+static int make_book(struct Address_book *addressbook, long n) // Indexed book of n contacts, 0 or -1
+{
+    struct Generated contact;
+    init_address_book(addressbook);
+    for (long i = 0; i < n; i++)
+    {
+        make_contact(&contact, i);
+        if (append_contact(addressbook, &contact.data) == -1)
+            return -1;
+    }
+    return rebuild_indexes(addressbook);
+}
+
+static void bench_delete(long n) // Delete every other contact one at a time, then as one bulk call
+{
+    struct Address_book addressbook;
+    struct Generated contact;
+    if (make_book(&addressbook, n) != 0)
+    {
+        printf("delete: out of memory\n");
+        destroy_address_book(&addressbook);
+        return;
+    }
+    double start = now_seconds();
+    for (long i = 0; i < n; i += 2)
+    {
+        make_contact(&contact, i);
+        remove_contact(&addressbook, find_by_mobile(&addressbook, contact.data.Mobile_number));
+    }
+    double elapsed = now_seconds() - start;
+    printf("delete   %10ld contacts  %8.3f s  %12.0f contacts/s  (%d left)\n",
+           (n + 1) / 2, elapsed, (n + 1) / 2 / elapsed, count_contacts(&addressbook));
+    destroy_address_book(&addressbook);
+
+    long half = (n + 1) / 2;
+    char (*mobiles)[sizeof(contact.data.Mobile_number)] = malloc((size_t)half * sizeof(*mobiles));
+    const char **keys = malloc((size_t)half * sizeof(*keys));
+    if (mobiles == NULL || keys == NULL || make_book(&addressbook, n) != 0)
+    {
+        printf("bulkdel: out of memory\n");
+        free(mobiles);
+        free(keys);
+        destroy_address_book(&addressbook);
+        return;
+    }
+    for (long k = 0; k < half; k++)
+    {
+        make_contact(&contact, 2 * k);
+        memcpy(mobiles[k], contact.data.Mobile_number, sizeof(mobiles[k]));
+        keys[k] = mobiles[k];
+    }
+    start = now_seconds();
+    int removed = remove_contacts(&addressbook, keys, (int)half);
+    elapsed = now_seconds() - start;
+    printf("bulkdel  %10d contacts  %8.3f s  %12.0f contacts/s  (%d left)\n",
+           removed, elapsed, removed / elapsed, count_contacts(&addressbook));
+    free(mobiles);
+    free(keys);
+    destroy_address_book(&addressbook);
+}
+
+/*------------------- Validation Benchmark -------------------*/
+static void bench_validate(long n) // Time validate_contacts against check_contact record by record
+{
+    struct Generated *generated = malloc((size_t)n * sizeof(*generated));
+    struct Contact_data *records = malloc((size_t)n * sizeof(*records)); // The views validate_contacts takes
+    unsigned char *errors = malloc((size_t)n);
+    if (generated == NULL || records == NULL || errors == NULL)
+    {
+        printf("validate: out of memory\n");
+        free(generated);
+        free(records);
+        free(errors);
+        return;
+    }
+    for (long i = 0; i < n; i++)
+    {
+        make_contact(&generated[i], i);
+        records[i] = generated[i].data;
+    }
+
+    double start = now_seconds();
+    int invalid = validate_contacts(records, (int)n, errors);
+    double batch = now_seconds() - start;
+    start = now_seconds();
+    long scalar_invalid = 0;
+    for (long i = 0; i < n; i++)
+        scalar_invalid += check_contact(&records[i]) != VALID;
+    double scalar = now_seconds() - start;
+
+    printf("validate %10ld contacts  batch %8.3f s (%6.1f M/s)  scalar %8.3f s (%6.1f M/s)  invalid %d/%ld\n",
+           n, batch, n / batch / 1e6, scalar, n / scalar / 1e6, invalid, scalar_invalid);
+    free(generated);
+    free(records);
+    free(errors);
+}
+
+/*------------------- Mobile Scan Benchmark -------------------*/
+static void bench_scan(long n) // Time mobile prefix queries on the packed column against a scan of the records
+{
+    struct Address_book addressbook;
+    if (make_book(&addressbook, n) != 0)
+    {
+        printf("scan: out of memory\n");
+        destroy_address_book(&addressbook);
+        return;
+    }
+
+    int matches[1024], queries = 20;
+    double start = now_seconds();
+    long column_hits = 0;
+    for (int q = 0; q < queries; q++) // First query also builds the column
+    {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "6%04d", q * 37 % 10000);
+        column_hits += find_by_mobile_prefix(&addressbook, prefix, matches, 1024);
+    }
+    double column = now_seconds() - start;
+    start = now_seconds();
+    long record_hits = 0;
+    for (int q = 0; q < queries; q++) // Same queries, reading every 78-byte record
+    {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "6%04d", q * 37 % 10000);
+        for (int i = 0; i < addressbook.contact_count; i++)
+            record_hits += strncmp(addressbook.contact_details[i].Mobile_number, prefix, 5) == 0;
+    }
+    double records = now_seconds() - start;
+
+    printf("scan     %10ld contacts  column %8.3f s (%6.1f M/s)  records %8.3f s (%6.1f M/s)  hits %ld/%ld\n",
+           n, column, n * queries / column / 1e6, records, n * queries / records / 1e6, column_hits, record_hits);
+    destroy_address_book(&addressbook);
+}
+
+/*------------------- Fuzzy Search Benchmark -------------------*/
+static void bench_fuzzy(long n) // Latency of misspelled name searches (two typos each)
+{
+    struct Address_book addressbook;
+    if (make_book(&addressbook, n) != 0)
+    {
+        printf("fuzzy: out of memory\n");
+        destroy_address_book(&addressbook);
+        return;
+    }
+
+    struct Search_hit hits[10];
+    int queries = 200, total;
+    long found = 0;
+    double start = now_seconds();
+    if (fuzzy_search(&addressbook, "x", 0, 0, 10, hits, &total) < 0) // Build the trigram index outside the timing
+    {
+        printf("fuzzy: out of memory\n");
+        destroy_address_book(&addressbook);
+        return;
+    }
+    double build = now_seconds() - start;
+    double worst = 0;
+    start = now_seconds();
+    for (int q = 0; q < queries; q++)
+    {
+        struct Generated contact;
+        make_contact(&contact, (long)q * 7919 % n);
+        char name[sizeof(contact.name)];
+        strcpy(name, contact.name);
+        char swap = name[2]; // "Aabcdef Kumar" -> "Aacbdef Kumer"
+        name[2] = name[3];
+        name[3] = swap;
+        name[strlen(name) - 2] = 'e';
+        double one = now_seconds();
+        found += fuzzy_search(&addressbook, name, 2, 0, 10, hits, &total) > 0;
+        one = now_seconds() - one;
+        if (one > worst)
+            worst = one;
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("fuzzy    %10ld contacts  index %8.3f s  %8.3f ms/query (worst %.3f ms)  found %ld/%d\n",
+           n, build, elapsed / queries * 1e3, worst * 1e3, found, queries);
+    destroy_address_book(&addressbook);
+}
+
+/*------------------- Realistic Generator -------------------*/
+static const char *first_names[] = { // Most common first: picks lean towards the front of each list
+    "Ravi", "Priya", "Rahul", "Anjali", "Suresh", "Lakshmi", "Amit", "Sneha", "Ramesh", "Divya",
+    "Vijay", "Kavya", "Arjun", "Pooja", "Kiran", "Deepa", "Sainath", "Haritha", "Bharath", "Aruna",
+    "Mahesh", "Swathi", "Naveen", "Padmavathi", "Srinivas", "Meena", "Ganesh", "Revathi", "Mohan", "Keerthi",
+    "Deva", "Sravani", "Venkat", "Bhavana", "Harish", "Nandini", "Prakash", "Usha", "Karthik", "Geetha",
+    "John", "Mary", "David", "Sarah", "Michael", "Emma", "Daniel", "Olivia", "Ahmed", "Fatima",
+    "Wei", "Mei", "Carlos", "Lucia", "Yuki", "Hana", "Omar", "Aisha", "Ivan", "Elena" };
+static const char *surnames[] = {
+    "Reddy", "Kumar", "Sharma", "Rao", "Naidu", "Patel", "Singh", "Gupta", "Iyer", "Nair",
+    "Chowdary", "Varma", "Menon", "Pillai", "Joshi", "Das", "Mehta", "Shetty", "Yadav", "Simha",
+    "Smith", "Johnson", "Brown", "Garcia", "Wang", "Li", "Khan", "Ali", "Silva", "Tanaka",
+    "Muller", "Rossi", "Ivanova", "Kowalski", "Nguyen", "Kim", "Cohen", "Fernandes", "Lopez", "Martin" };
+static const char *domains[] = { // Repeated entries are the weights: gmail.com is about half
+    "gmail.com", "gmail.com", "gmail.com", "gmail.com", "gmail.com", "gmail.com", "gmail.com", "gmail.com",
+    "yahoo.com", "yahoo.com", "outlook.com", "outlook.com", "hotmail.com", "rediffmail.com",
+    "icloud.com", "company.co.in" };
+
+#define COUNT_OF(array) ((int)(sizeof(array) / sizeof((array)[0])))
+#define BENCH_SEED 20240601UL   // Default generator seed: same seed, same file
+#define SUITE_QUERIES 10000     // Timed calls per lookup, create and delete
+#define SEARCH_QUERIES 1000     // Timed partial and fuzzy searches (each costs milliseconds at 10^6)
+
+static uint64_t mix(uint64_t x) // splitmix64 finalizer: any number to well-spread random bits
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static int skewed(uint64_t bits, int count) // Index in 0..count-1, low ones likelier (smaller of two draws)
+{
+    int a = (int)(bits % (uint64_t)count), b = (int)((bits >> 32) % (uint64_t)count);
+    return a < b ? a : b;
+}
+
+static void make_realistic_contact(struct Generated *contact, long i, uint64_t seed) // Contact number i of a generated book
+{
+    uint64_t r1 = mix(seed ^ mix((uint64_t)i)), r2 = mix(r1), r3 = mix(r2);
+    const char *first = first_names[skewed(r1, COUNT_OF(first_names))];
+    const char *middle = r2 % 5 == 0 ? first_names[skewed(r3, COUNT_OF(first_names))] : NULL; // One in five
+    const char *last = r2 % 10 != 1 ? surnames[skewed(r2 >> 8, COUNT_OF(surnames))] : NULL;   // One in ten has none
+    if (middle != NULL && last != NULL)
+        snprintf(contact->name, sizeof(contact->name), "%s %s %s", first, middle, last);
+    else if (last != NULL)
+        snprintf(contact->name, sizeof(contact->name), "%s %s", first, last);
+    else
+        snprintf(contact->name, sizeof(contact->name), "%s", first);
+
+    // Unique mobile: i -> i * 3^18 + c is a bijection modulo 10^9, the leading digit is free
+    static const char leading[] = "9999888777766"; // 9 most common, 6 least
+    uint64_t rest = ((uint64_t)i * 387420489ULL + 123456789ULL) % 1000000000ULL;
+    snprintf(contact->data.Mobile_number, sizeof(contact->data.Mobile_number), "%c%09llu",
+             leading[r3 % (sizeof(leading) - 1)], (unsigned long long)rest);
+
+    // Unique mail: letters of the name, then i (letters never end in a digit, so i splits off)
+    char local[16];
+    int length = 0;
+    for (const char *c = first; *c != '\0' && length < 11; c++)
+        local[length++] = (char)tolower((unsigned char)*c);
+    for (const char *c = last; c != NULL && *c != '\0' && length < 11 && r3 % 3 != 0; c++)
+        local[length++] = (char)tolower((unsigned char)*c);
+    local[length] = '\0';
+    snprintf(contact->mail, sizeof(contact->mail), "%s%ld@%s", local, i, domains[(r3 >> 16) % COUNT_OF(domains)]);
+    contact->data.Name = contact->name;
+    contact->data.Mail_ID = contact->mail;
+}
+
+static int write_generated(FILE *fp, long n, uint64_t seed) // data.txt format: "#N", then one record per line, 0 or -1
+{
+    struct Generated contact;
+    fprintf(fp, "#%ld\n", n);
+    for (long i = 0; i < n; i++)
+    {
+        make_realistic_contact(&contact, i, seed);
+        fprintf(fp, "%s,%s,%s\n", contact.name, contact.data.Mobile_number, contact.mail);
+    }
+    return fflush(fp) == 0 && !ferror(fp) ? 0 : -1;
+}
+
+/*------------------- JSON Suite -------------------*/
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void put_bulk(const char *name, long count, double seconds, int *first) // One timed call over 'count' contacts
+{
+    printf("%s\n      \"%s\": {\"count\": %ld, \"seconds\": %.6f, \"ops_per_sec\": %.1f}",
+           *first ? "" : ",", name, count, seconds, seconds > 0 ? count / seconds : 0.0);
+    *first = 0;
+}
+
+static void put_timed(const char *name, double *samples, int count, int *first) // Separately timed calls: rate and latency percentiles
+{
+    double total = 0;
+    for (int i = 0; i < count; i++)
+        total += samples[i];
+    qsort(samples, count, sizeof(double), compare_doubles);
+    double p[4] = { 0.50, 0.90, 0.99, 0.999 }, at[4];
+    for (int k = 0; k < 4; k++)
+        at[k] = count > 0 ? samples[(int)(p[k] * (count - 1))] * 1e6 : 0;
+    printf("%s\n      \"%s\": {\"count\": %d, \"seconds\": %.6f, \"ops_per_sec\": %.1f, "
+           "\"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f, \"max_us\": %.3f}",
+           *first ? "" : ",", name, count, total, total > 0 ? count / total : 0.0,
+           at[0], at[1], at[2], at[3], count > 0 ? samples[count - 1] * 1e6 : 0);
+    *first = 0;
+}
+
+static int suite_size(long n, uint64_t seed) // Every measurement at one size, as one JSON object, 0 or -1
+{
+    char dir[] = "/tmp/bench_suite_XXXXXX", path[64];
+    if (mkdtemp(dir) == NULL)
+        return -1;
+    snprintf(path, sizeof(path), "%s/%s", dir, DATA_FILE);
+    FILE *fp = fopen(path, "w+");
+    if (fp == NULL || write_generated(fp, n, seed) != 0)
+    {
+        if (fp != NULL)
+            fclose(fp);
+        remove(path);
+        rmdir(dir);
+        return -1;
+    }
+    rewind(fp);
+
+    int queries = n < SUITE_QUERIES ? (int)n : SUITE_QUERIES;
+    double *samples = malloc(SUITE_QUERIES * sizeof(double));
+    struct Search_hit hits[10];
+    struct Generated contact;
+    struct Address_book addressbook;
+    int first = 1, total;
+    printf("    {\"contacts\": %ld, \"operations\": {", n);
+
+    init_address_book(&addressbook); // load_contact: parse, sort and index the whole file
+    double start = now_seconds();
+    load_contact(fp, &addressbook);
+    put_bulk("load_contact", addressbook.contact_count, now_seconds() - start, &first);
+    destroy_address_book(&addressbook);
+    fclose(fp);
+
+    init_address_book(&addressbook); // The book the rest runs on, appended in generated (random) name order
+    for (long i = 0; i < n; i++)
+    {
+        make_realistic_contact(&contact, i, seed);
+        if (append_contact(&addressbook, &contact.data) == -1)
+            break;
+    }
+    start = now_seconds();
+    sort_contacts_by_name(&addressbook);
+    put_bulk("sort_contacts_by_name", addressbook.contact_count, now_seconds() - start, &first);
+    start = now_seconds();
+    int indexed = rebuild_indexes(&addressbook);
+    put_bulk("rebuild_indexes", addressbook.contact_count, now_seconds() - start, &first);
+
+    for (int kind = 0; kind < 3 && samples != NULL && indexed == 0; kind++) // Cores of search_name, search_Mobile_Number, search_mail_id
+    {
+        static const char *names[] = { "find_by_name", "find_by_mobile", "find_by_mail" };
+        for (int q = 0; q < queries; q++)
+        {
+            make_realistic_contact(&contact, (long)(mix(seed + (uint64_t)q) % (uint64_t)n), seed);
+            double one = now_seconds();
+            int found = kind == 0 ? find_by_name(&addressbook, contact.name)
+                      : kind == 1 ? find_by_mobile(&addressbook, contact.data.Mobile_number)
+                                  : find_by_mail(&addressbook, contact.mail);
+            samples[q] = now_seconds() - one;
+            if (found == -1)
+                fprintf(stderr, "suite: %s missed a generated contact\n", names[kind]);
+        }
+        put_timed(names[kind], samples, queries, &first);
+    }
+
+    start = now_seconds(); // First partial search builds the trigram index
+    int searchable = samples != NULL && indexed == 0 && text_search(&addressbook, "xyz", SEARCH_NAME, 0, 0, hits, &total) >= 0;
+    int searches = queries < SEARCH_QUERIES ? queries : SEARCH_QUERIES;
+    if (searchable)
+    {
+        put_bulk("text_index_build", addressbook.contact_count, now_seconds() - start, &first);
+        for (int q = 0; q < searches; q++) // Core of search_partial: four letters from inside a name, first page
+        {
+            make_realistic_contact(&contact, (long)(mix(seed ^ (uint64_t)q) % (uint64_t)n), seed);
+            size_t length = strlen(contact.name);
+            char part[5] = { 0 };
+            memcpy(part, contact.name + (length > 4 ? mix((uint64_t)q) % (length - 3) : 0), length < 4 ? length : 4);
+            double one = now_seconds();
+            text_search(&addressbook, part, SEARCH_NAME | SEARCH_MAIL, 0, 10, hits, &total);
+            samples[q] = now_seconds() - one;
+        }
+        put_timed("text_search", samples, searches, &first);
+
+        for (int q = 0; q < searches; q++) // Fallback of search_name: a name with two letters swapped
+        {
+            make_realistic_contact(&contact, (long)(mix(seed - (uint64_t)q) % (uint64_t)n), seed);
+            size_t length = strlen(contact.name), at = length > 2 ? mix((uint64_t)q) % (length - 1) : 0;
+            char swap = contact.name[at];
+            contact.name[at] = contact.name[at + 1];
+            contact.name[at + 1] = swap;
+            double one = now_seconds();
+            fuzzy_search(&addressbook, contact.name, FUZZY_DISTANCE, 0, 10, hits, &total);
+            samples[q] = now_seconds() - one;
+        }
+        put_timed("fuzzy_search", samples, searches, &first);
+
+        start = now_seconds(); // First sound-alike search keys every name
+        if (phonetic_search(&addressbook, "x", 0, 0, 0, hits, &total) >= 0)
+        {
+            put_bulk("phonetic_index_build", addressbook.contact_count, now_seconds() - start, &first);
+            for (int q = 0; q < searches; q++) // Core of search_sounds_like: a name spelt as heard
+            {
+                make_realistic_contact(&contact, (long)(mix(seed + 7 * (uint64_t)q) % (uint64_t)n), seed);
+                char *h = strchr(contact.name, 'h');
+                if (h != NULL) // "Bharath" -> "Barath"
+                    memmove(h, h + 1, strlen(h));
+                else if (strlen(contact.name) + 1 < sizeof(contact.name)) // "Ravi" -> "Rhavi"
+                {
+                    memmove(contact.name + 2, contact.name + 1, strlen(contact.name));
+                    contact.name[1] = 'h';
+                }
+                double one = now_seconds();
+                phonetic_search(&addressbook, contact.name, PHONETIC_DISTANCE, 0, 10, hits, &total);
+                samples[q] = now_seconds() - one;
+            }
+            put_timed("phonetic_search", samples, searches, &first);
+        }
+    }
+
+    if (samples != NULL && indexed == 0)
+    {
+        for (int q = 0; q < queries; q++) // Core of create_contact: contacts n, n+1 ... are new
+        {
+            make_realistic_contact(&contact, n + q, seed);
+            double one = now_seconds();
+            insert_contact(&addressbook, &contact.data);
+            samples[q] = now_seconds() - one;
+        }
+        put_timed("insert_contact", samples, queries, &first);
+
+        int deleted = 0;
+        for (int q = 0; q < queries; q++) // Core of delete_contact: random existing contacts
+        {
+            make_realistic_contact(&contact, (long)(mix(seed * 31 + (uint64_t)q) % (uint64_t)n), seed);
+            int index = find_by_mobile(&addressbook, contact.data.Mobile_number);
+            if (index == -1)
+                continue; // Drawn twice
+            double one = now_seconds();
+            remove_contact(&addressbook, index);
+            samples[deleted++] = now_seconds() - one;
+        }
+        put_timed("remove_contact", samples, deleted, &first);
+    }
+
+    char here[4096];
+    if (getcwd(here, sizeof(here)) != NULL && chdir(dir) == 0) // save_contacts writes SNAPSHOT_FILE in the current directory
+    {
+        start = now_seconds();
+        save_contacts(&addressbook);
+        put_bulk("save_contacts", count_contacts(&addressbook), now_seconds() - start, &first);
+        remove(SNAPSHOT_FILE);
+        if (chdir(here) != 0)
+            fprintf(stderr, "suite: could not return to %s\n", here);
+    }
+    destroy_address_book(&addressbook);
+    free(samples);
+    remove(path);
+    rmdir(dir);
+
+    struct rusage usage; // Each size runs in its own process, so this peak is its own
+    getrusage(RUSAGE_SELF, &usage);
+    printf("\n    }, \"peak_rss_kb\": %ld}", usage.ru_maxrss);
+    return 0;
+}
+
+static int bench_suite(long *sizes, int count, uint64_t seed) // JSON report over every size, 0 or -1
+{
+    printf("{\n  \"benchmark\": \"addressbook\", \"seed\": %llu, \"threads\": %d,\n  \"results\": [\n",
+           (unsigned long long)seed, worker_threads());
+    int status = 0;
+    for (int i = 0; i < count; i++)
+    {
+        fflush(stdout); // The child must not print our buffered output again
+        pid_t child = fork();
+        if (child == 0)
+        {
+            if (i > 0)
+                printf(",\n");
+            int result = suite_size(sizes[i], seed);
+            fflush(stdout);
+            _exit(result == 0 ? 0 : 1);
+        }
+        int child_status = 0;
+        if (child < 0 || waitpid(child, &child_status, 0) != child || !WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0)
+        {
+            fprintf(stderr, "suite: size %ld failed\n", sizes[i]);
+            status = -1;
+            break;
+        }
+    }
+    printf("\n  ]\n}\n");
+    return status;
+}
+
+/*------------------- Thread Scaling Benchmark -------------------*/
+static void bench_scaling(long n) // Time load_contact on the same file with 1, 2, 4 ... threads
+{
+    long bytes;
+    FILE *fp = make_data_file(n, &bytes);
+    if (fp == NULL)
+        return;
+
+    int most = worker_threads() * 2; // Go a little past the CPU count
+    double base = 0;
+    for (int threads = 1; threads <= most && threads <= MAX_WORKERS; threads *= 2)
+    {
+        struct Address_book addressbook;
+        init_address_book(&addressbook);
+        set_worker_threads(threads);
+        rewind(fp);
+
+        double start = now_seconds();
+        load_contact(fp, &addressbook);
+        double elapsed = now_seconds() - start;
+        if (threads == 1)
+            base = elapsed;
+
+        printf("threads %3d  %10d contacts  %8.3f s  %8.1f MB/s  speedup %5.2fx\n",
+               threads, addressbook.contact_count, elapsed, bytes / elapsed / 1e6, base / elapsed);
+        destroy_address_book(&addressbook);
+    }
+    set_worker_threads(0);
+    fclose(fp);
+}
+
+/*------------------- Concurrency Benchmark -------------------*/
+struct Concurrent_job           // One reader or the writer of bench_concurrent
+{
+    struct Shared_book *shared;
+    const char (*mobiles)[11];  // Key of every contact, read-only
+    long n;
+    unsigned int seed;
+    atomic_int *stop;
+    long operations, misses, torn; // Reads (or writes) done, keys not found, wrong records returned
+};
+
+static void *concurrent_reader(void *arg) // Look up random mobiles until told to stop
+{
+    struct Concurrent_job *job = arg;
+    struct Contact_data contact;
+    unsigned int x = job->seed;
+    while (!atomic_load_explicit(job->stop, memory_order_relaxed))
+    {
+        for (int k = 0; k < 256; k++)
+        {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5; // xorshift32
+            const char *key = job->mobiles[x % job->n];
+            if (shared_find_by_mobile(job->shared, key, &contact) != 1)
+                job->misses++; // Removed by the writer just now
+            else if (strcmp(contact.Mobile_number, key) != 0 || contact.Name[0] == '\0')
+                job->torn++;
+        }
+        job->operations += 256;
+    }
+    return NULL;
+}
+
+static void *concurrent_writer(void *arg) // Rename, remove and re-add random contacts until told to stop
+{
+    struct Concurrent_job *job = arg;
+    struct Generated contact;
+    unsigned int x = job->seed;
+    while (!atomic_load_explicit(job->stop, memory_order_relaxed))
+    {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        long i = x % job->n;
+        make_contact(&contact, i);
+        memcpy(contact.name + 8, "Reddy", 6); // Same length as "Kumar"
+        shared_update(job->shared, contact.data.Mobile_number, &contact.data);
+        shared_remove(job->shared, contact.data.Mobile_number);
+        make_contact(&contact, i);
+        shared_insert(job->shared, &contact.data);
+        job->operations += 3;
+    }
+    return NULL;
+}
+
+static void bench_concurrent(long n) // Read QPS over 1, 2, 4 ... reader threads while one writer keeps changing the book
+{
+    struct Address_book addressbook;
+    char (*mobiles)[11] = malloc((size_t)n * sizeof(*mobiles));
+    if (mobiles == NULL || make_book(&addressbook, n) != 0)
+    {
+        printf("concurrent: out of memory\n");
+        free(mobiles);
+        destroy_address_book(&addressbook);
+        return;
+    }
+    for (long i = 0; i < n; i++)
+        memcpy(mobiles[i], addressbook.contact_details[i].Mobile_number, sizeof(mobiles[i]));
+    struct Shared_book *shared = shared_book_open(&addressbook);
+    if (shared == NULL)
+    {
+        printf("concurrent: out of memory\n");
+        free(mobiles);
+        destroy_address_book(&addressbook);
+        return;
+    }
+
+    int most = worker_threads() * 2; // Go a little past the CPU count
+    double base = 0;
+    for (int readers = 1; readers <= most && readers < MAX_WORKERS; readers *= 2)
+    {
+        struct Concurrent_job jobs[MAX_WORKERS];
+        pthread_t threads[MAX_WORKERS];
+        atomic_int stop;
+        atomic_init(&stop, 0);
+        for (int t = 0; t <= readers; t++) // jobs[readers] is the writer
+            jobs[t] = (struct Concurrent_job){ shared, (const char (*)[11])mobiles, n, 2463534242u + 7919u * t, &stop, 0, 0, 0 };
+        for (int t = 0; t <= readers; t++)
+            pthread_create(&threads[t], NULL, t < readers ? concurrent_reader : concurrent_writer, &jobs[t]);
+        double start = now_seconds();
+        struct timespec run = { 0, 500000000 }; // Half a second per step
+        nanosleep(&run, NULL);
+        atomic_store(&stop, 1);
+        for (int t = 0; t <= readers; t++)
+            pthread_join(threads[t], NULL);
+        double elapsed = now_seconds() - start;
+
+        long reads = 0, misses = 0, torn = 0;
+        for (int t = 0; t < readers; t++)
+        {
+            reads += jobs[t].operations;
+            misses += jobs[t].misses;
+            torn += jobs[t].torn;
+        }
+        if (readers == 1)
+            base = reads / elapsed;
+        printf("readers %3d  %12.0f reads/s  %10.0f per reader  scaling %5.2fx  %9.0f writes/s  %ld misses  %ld torn\n",
+               readers, reads / elapsed, reads / elapsed / readers, reads / elapsed / base,
+               jobs[readers].operations / elapsed, misses, torn);
+    }
+    shared_book_close(shared, &addressbook);
+    destroy_address_book(&addressbook);
+    free(mobiles);
+}
+
+/*------------------- Durability Benchmark -------------------*/
+static void bench_durability(long n) // Save and commit latency of a book of n contacts at every level
+{
+    static const char *names[] = { "none", "data", "full" };
+    struct Address_book addressbook;
+    struct Generated contact;
+    char dir[] = "/tmp/bench_durability_XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        printf("could not create temporary directory\n");
+        return;
+    }
+    char log_path[64], snapshot_path[64], text_path[64];
+    snprintf(log_path, sizeof(log_path), "%s/data.wal", dir);
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s/data.snap", dir);
+    snprintf(text_path, sizeof(text_path), "%s/data.txt", dir);
+
+    for (int level = DURABILITY_NONE; level <= DURABILITY_FULL; level++)
+    {
+        set_durability(level);
+        init_address_book(&addressbook);
+        for (long i = 0; i < n; i++)
+        {
+            make_contact(&contact, i);
+            append_contact(&addressbook, &contact.data);
+        }
+        rebuild_indexes(&addressbook);
+
+        double start = now_seconds();
+        save_snapshot(&addressbook, snapshot_path, 0);
+        double snapshot = now_seconds() - start;
+
+        start = now_seconds();
+        export_contacts(&addressbook, text_path);
+        double text = now_seconds() - start;
+
+        int commits = 200; // One change, then wait until it is durable
+        wal_open(&addressbook, log_path, snapshot_path, -1);
+        start = now_seconds();
+        for (int c = 0; c < commits; c++)
+        {
+            make_contact(&contact, n + c);
+            insert_contact(&addressbook, &contact.data);
+            wal_sync(&addressbook);
+        }
+        double commit = (now_seconds() - start) / commits;
+
+        printf("%-4s  %10ld contacts  snapshot %8.3f s  text %8.3f s  commit %8.3f ms\n",
+               names[level], n, snapshot, text, commit * 1e3);
+        destroy_address_book(&addressbook);
+    }
+    set_durability(-1);
+    remove(log_path);
+    remove(snapshot_path);
+    remove(text_path);
+    rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "generate") == 0) // Realistic data.txt on stdout
+    {
+        if (argc < 3 || atol(argv[2]) <= 0)
+        {
+            printf("Usage: %s generate N [SEED]\n", argv[0]);
+            return 1;
+        }
+        return write_generated(stdout, atol(argv[2]), argc > 3 ? strtoull(argv[3], NULL, 10) : BENCH_SEED) == 0 ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "json") == 0) // Machine-readable suite
+    {
+        long sizes[16] = { 1000, 10000, 100000, 1000000, 10000000 };
+        int count = 5, arg = 2;
+        uint64_t seed = BENCH_SEED;
+        if (argc > 3 && strcmp(argv[2], "--seed") == 0)
+        {
+            seed = strtoull(argv[3], NULL, 10);
+            arg = 4;
+        }
+        if (arg < argc)
+            for (count = 0; arg < argc && count < 16; arg++)
+                if ((sizes[count++] = atol(argv[arg])) <= 0)
+                {
+                    printf("Invalid size: %s\n", argv[arg]);
+                    return 1;
+                }
+        return bench_suite(sizes, count, seed) == 0 ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "durability") == 0) // Durability levels
+    {
+        bench_durability(argc > 2 ? atol(argv[2]) : 100000);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "concurrent") == 0) // Readers against a writer
+    {
+        bench_concurrent(argc > 2 ? atol(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "threads") == 0) // Scaling mode
+    {
+        bench_scaling(argc > 2 ? atol(argv[2]) : 1000000);
+        return 0;
+    }
+
+    long defaults[] = { 10000, 1000000, 10000000 }; // Sizes used when none are given
+    int count = argc > 1 ? argc - 1 : 3;
+
+    for (int i = 0; i < count; i++)
+    {
+        long n = argc > 1 ? atol(argv[i + 1]) : defaults[i];
+        if (n <= 0)
+        {
+            printf("Invalid size: %s\n", argv[i + 1]);
+            return 1;
+        }
+        bench_append(n);
+        bench_load(n);
+        bench_snapshot(n);
+        bench_log(n);
+        bench_delete(n);
+        bench_validate(n);
+        bench_scan(n);
+        bench_fuzzy(n);
+    }
+    return 0;
+}
@@ -20,14 +20,16 @@
         -> Listing contacts: Display all stored contacts in a well-formatted table for easy readability.
 
     -> Searching contacts: Search by Name, Mobile Number, or Mail ID with case-insensitive matching.
-        Handles multiple results and allows user selection.
+        Handles multiple results and allows user selection. Partial search finds prefixes and
+        parts of a Name or Mail ID ("reddy" finds "Sainath reddy"), best matches first, page by page.
+        Sound-alike search finds names spelt as heard ("Barath" finds "Bharath"), closest spelling first.
 
     -> Editing contacts: Update any individual field or all fields of a contact. Ensures input validation after editing.
 
     -> Deleting contacts: Remove contacts from the address book with confirmation to avoid accidental deletions.
 
-    -> Saving contacts: Automatically or manually save contacts to a file (data.txt) for persistent storage,
-    allowing data retrieval on program restart.
+    -> Saving contacts: Every add, edit and delete is appended to a change log (data.wal) as it happens, and the
+    log is folded into a snapshot file (data.snap) in the background, allowing data retrieval on program restart. data.txt stays available for import and export.
 
     Input validation:
 
@@ -45,94 +47,65 @@ Features     :
 
     -> Handles multiple search results and allows selection of correct contact for editing or deleting.
 
-    -> Supports up to 100 contacts with persistent file storage.
+    -> Stores any number of contacts (growable array) with persistent file storage.
 
     -> Detailed success and error messages for user guidance.
 
 Usage Notes :
 
-    -> Ensure the data file (data.txt) exists in the same directory or the program will start with an empty address book.
+    -> Ensure the data file (data.snap or data.txt) exists in the same directory. data.txt is read only when there is
+       no data.snap yet; pick up a hand-edited text file with "--import data.txt".
+    -> "--import FILE" starts from a text file, "--export FILE" writes the book as text and exits.
+    -> "list [--format table|tsv|csv] [--offset N] [--limit N]" prints the book in name order and exits
+       (TSV when the output is not a terminal). The menu pages long lists 50 rows at a time.
+    -> "merge FILE [--on-conflict skip|overwrite|report]" folds another contact file into the book; a record whose
+       mobile number or mail ID is already taken is skipped, replaces that contact, or is listed (merge.c).
+    -> "shard N [--by mobile|name] DIR" splits the book into N books in DIR, one per shard; "shards DIR [search TEXT |
+       save]" opens them all in parallel and searches or saves every shard at once (shard.c).
+    -> ADDRESSBOOK_DURABILITY=none|data|full picks how hard saves are flushed to disk (default full).
     -> Use valid and unique data to avoid errors or duplicates.
     -> Menu options guide the user through all available operations.
 
 ******************************************************************************/
 #include <stdio.h>      // Include standard input/output functions (printf, scanf, etc.)
 #include <string.h>     // Include string handling functions (strcpy, strcmp, strlen, etc.)
-#include <ctype.h>      // Include character functions (tolower, isalpha, etc.)
+#include <strings.h>    // Include strcasecmp for names in any case
 #include <stdlib.h>     // Include standard library functions (exit, atoi, malloc, etc.)
+#include <unistd.h>     // Include isatty, STDOUT_FILENO
 #include "contact.h"    // Include custom header file with structure definitions and function prototypes
-
-int compare_names(const char *a, const char *b)  // Function to compare two strings case-insensitively
-{
-    while (*a && *b) {                            // Loop until either string reaches null character
-        char ca = tolower(*a);                    // Convert current character of string a to lowercase
-        char cb = tolower(*b);                    // Convert current character of string b to lowercase
-        if (ca != cb)                             // Check if characters are different
-            return ca - cb;                       // Return difference if not equal (used for sorting)
-        a++;                                      // Move pointer to next character in string a
-        b++;                                      // Move pointer to next character in string b
-    }
-    return tolower(*a) - tolower(*b);            // If loop ends, return difference of final characters (handles strings of different lengths)
-}
-
-/*---------------- Sort contacts by Name (dictionary order) ----------------*/
-void sort_contacts_by_name(struct Address_book *addressbook) // Sort contacts alphabetically by Name
-{
-    for (int i = 0; i < addressbook->contact_count - 1; i++) // Outer loop through each contact
-    {
-        for (int j = i + 1; j < addressbook->contact_count; j++) // Inner loop to compare with subsequent contacts
-        {
-            if (compare_names(addressbook->contact_details[i].Name,
-                              addressbook->contact_details[j].Name) > 0) // Compare names case-insensitively
-            {
-                struct Contact_data temp = addressbook->contact_details[i]; // Store current contact in temp
-                addressbook->contact_details[i] = addressbook->contact_details[j]; // Swap with next contact
-                addressbook->contact_details[j] = temp; // Complete swap
-            }
-        }
-    }
-}
-
+#include "durability.h" // Include crash-safe file replacement
+#include "render.h"     // Include buffered table output
+#include "stats.h"      // Include operation counters
 
 void load_contact(FILE *fp, struct Address_book *addressbook) // Load contacts from file
 {
-    fscanf(fp,"#%d\n",&addressbook->contact_count);
-    for(int i=0;i<addressbook->contact_count;i++)
-    {
-        fscanf(fp,"%[^,],%[^,],%[^\n]\n", // Parse Name, Mail ID, Mobile
-            addressbook->contact_details[i].Name,
-            addressbook->contact_details[i].Mobile_number,
-            addressbook->contact_details[i].Mail_ID);
-    
-    }
+    uint64_t start = stats_begin();
+    if (load_contacts_fd(fileno(fp), addressbook, DATA_FILE) < 0) // Bulk parse the whole file (loader.c)
+        printf("Error: not enough memory to load all contacts\n");
 
     sort_contacts_by_name(addressbook); // Sort contacts alphabetically by Name
+    if (rebuild_indexes(addressbook) != 0) // Index mobiles and mails of the sorted contacts
+        printf("Error: not enough memory to index contacts\n");
+    stats_end(STAT_LOAD, start);
 }
 
 
 /*------------------- Validate Name -------------------*/
-void valid_name(char *name) // Validate user's input for Name
+char *valid_name(void) // Validate user's input for Name, returns it (caller frees)
 {
-    int repeat;
+    int error;
+    char *name;
     do
     {
-        repeat = 0;
-        scanf(" %[^\n]", name); // Read input including spaces until newline
-        if (!isalpha(name[0])) // Check first character is alphabet
-        {
-            printf("First letter must be an alphabet. Try again: ");
-            repeat = 1; // Repeat input if invalid
-        }
-        for (int i = 0; name[i] != '\0'; i++) // Loop through each character
+        if (scanf(" %m[^\n]", &name) != 1) // Read input including spaces until newline, any length
+            name = NULL;
+        error = name != NULL ? check_name(name) : NAME_EMPTY; // Letters and spaces, first one a letter (validate.c)
+        if (error != VALID)
         {
-            if (!isalpha(name[i]) && name[i] != ' ') // Allow only letters and spaces
-            {
-                printf("Name can contain only alphabets and spaces. Try again: ");
-                repeat = 1; // Repeat input if invalid
-                break; // Exit inner loop
-            }
+            free(name);
+            printf("%s. Try again: ", validation_message(error)); // Repeat input if invalid
         }
-    } while (repeat); // Repeat until valid input
+    } while (error != VALID); // Repeat until valid input
 
     // Display validation success in formatted table
     printf("\n╔════════════════════════════════════════════╗\n");
@@ -141,48 +114,27 @@ void valid_name(char *name) // Validate user's input for Name
 
     printf("║ Name   : %-34s║\n", name); // Display name with padding
     printf("╚════════════════════════════════════════════╝\n\n");
+    return name;
 }
 
 
 /*------------------- Validate Mobile Number -------------------*/
 void valid_mobile_number(char *mobile_number, struct Address_book *addressbook) // Validate user's Mobile Number
 {
-    int duplicate;
+    int error;
     do
     {
-        duplicate = 0;
-        scanf(" %s", mobile_number); // Read mobile number input
-
-        // Length check
-        if (strlen(mobile_number) != 10) // Must be exactly 10 digits
-        {
-            printf("Mobile number must be exactly 10 digits. Try again: ");
-            duplicate = 1; // Repeat input
-            continue;
-        }
-
-        // Digit check
-        for (int i = 0; i < 10; i++)
-        {
-            if (!isdigit(mobile_number[i])) // Ensure all characters are digits
-            {
-                printf("Mobile number must contain only digits.\n Enter Mobile Number:");
-                duplicate = 1; // Repeat input
-                break;
-            }
-        }
-
-        // Uniqueness check
-        for (int i = 0; i < addressbook->contact_count; i++)
-        {
-            if (strcmp(addressbook->contact_details[i].Mobile_number, mobile_number) == 0) // Check duplicate
-            {
-                printf("Mobile number already exists.\nEnter a different one: ");
-                duplicate = 1; // Repeat input
-                break;
-            }
-        }
-    } while (duplicate); // Repeat until valid
+        char input[INPUT_SIZE];
+        if (scanf(" %255s", input) != 1) // Read mobile number input
+            input[0] = '\0';
+        error = check_mobile_number(input); // Exactly 10 digits (validate.c)
+        if (error == VALID)
+            strcpy(mobile_number, input);
+        if (error == VALID && find_by_mobile(addressbook, mobile_number) != -1) // Hash index lookup for a duplicate
+            error = DUPLICATE_MOBILE;
+        if (error != VALID)
+            printf("%s. Try again: ", validation_message(error)); // Repeat input
+    } while (error != VALID); // Repeat until valid
 
     // Display validation success
     printf("\n╔════════════════════════════════════════════╗\n");
@@ -193,101 +145,23 @@ void valid_mobile_number(char *mobile_number, struct Address_book *addressbook)
 }
 
 /*------------------- Validate Mail ID -------------------*/
-void valid_mail_id(char *mail_id, struct Address_book *addressbook) // Validate user's Mail ID
+char *valid_mail_id(struct Address_book *addressbook) // Validate user's Mail ID, returns it (caller frees)
 {
-    int repeat;
+    int error;
+    char *mail_id;
     do
     {
-        repeat = 0;
-        scanf(" %s", mail_id); // Read mail input
-
-        // Must contain exactly one '@'
-        int at_count = 0, at_pos = -1;
-        for (int i = 0; mail_id[i] != '\0'; i++)
-        {
-            if (mail_id[i] == '@') // Count '@'
-            {
-                at_count++;
-                at_pos = i; // Store position
-            }
-        }
-        if (at_count != 1) // Check single '@'
+        if (scanf(" %ms", &mail_id) != 1) // Read mail input, any length
+            mail_id = NULL;
+        error = mail_id != NULL ? check_mail_id(mail_id) : MAIL_AT_COUNT; // One '@', local and domain rules (validate.c)
+        if (error == VALID && find_by_mail(addressbook, mail_id) != -1) // Hash index lookup for an existing email
+            error = DUPLICATE_MAIL;
+        if (error != VALID)
         {
-            printf("Mail must contain exactly one '@'. Try again: ");
-            repeat = 1; // Repeat input
-            continue;
+            free(mail_id);
+            printf("%s. Try again: ", validation_message(error)); // Repeat input
         }
-
-        // At least 5 characters before '@'
-        if (at_pos < 5) // Minimum local part length
-        {
-            printf("At least 5 characters required before '@'. Try again: ");
-            repeat = 1;
-            continue;
-        }
-
-        // First letter lowercase
-        if (!islower(mail_id[0])) // Must start with lowercase
-        {
-            printf("First letter must be lowercase. Try again: ");
-            repeat = 1;
-            continue;
-        }
-
-        // Validate local part
-        for (int i = 0; i < at_pos; i++)
-        {
-            if (!islower(mail_id[i]) && !isdigit(mail_id[i])) // Only lowercase letters/digits
-            {
-                printf("Local part can have only lowercase letters or digits. Try again.\n Enter Mail Id: ");
-                repeat = 1;
-                break;
-            }
-        }
-        if (repeat)
-            continue;
-
-        // Domain validation
-        int has_letter = 0, has_dot = 0;
-        for (int i = at_pos + 1; mail_id[i] != '\0'; i++)
-        {
-            if (isalpha(mail_id[i])) // Must have at least one letter
-                has_letter = 1;
-            if (mail_id[i] == '.') // Must contain '.'
-                has_dot = 1;
-
-            if (!isalnum(mail_id[i]) && mail_id[i] != '.' && mail_id[i] != '-') // Only allowed chars
-            {
-                printf("Domain can have only letters, digits, '.' or '-'. Try again: ");
-                repeat = 1;
-                break;
-            }
-        }
-        if (!has_letter) // Letter check
-        {
-            printf("Domain must have at least one letter. Try again: ");
-            repeat = 1;
-            continue;
-        }
-        if (!has_dot) // Dot check
-        {
-            printf("Domain must contain '.'. Try again: ");
-            repeat = 1;
-            continue;
-        }
-
-        // Duplicate check
-        for (int i = 0; i < addressbook->contact_count; i++)
-        {
-            if (strcmp(addressbook->contact_details[i].Mail_ID, mail_id) == 0) // Existing email
-            {
-                printf("Mail ID already exists. Enter a different one: ");
-                repeat = 1;
-                break;
-            }
-        }
-
-    } while (repeat); // Repeat until valid
+    } while (error != VALID); // Repeat until valid
 
     // Display validation success
     printf("\n╔════════════════════════════════════════════╗\n");
@@ -295,6 +169,7 @@ void valid_mail_id(char *mail_id, struct Address_book *addressbook) // Validate
     printf("╠════════════════════════════════════════════╣\n");
     printf("║ Mail   : %-32s  ║\n", mail_id); // Show validated mail
     printf("╚════════════════════════════════════════════╝\n\n");
+    return mail_id;
 }
 
 /*------------------- Create Contact -------------------*/
@@ -308,10 +183,10 @@ void create_contact(struct Address_book *addressbook) // Function to create new
         printf("How many contacts do you want to add? ");
         scanf("%d", &n); // Read number of contacts to add
 
-        if (addressbook->contact_count + n > 100) // Check maximum limit
+        if (n < 0 || reserve_contacts(addressbook, addressbook->contact_count + n) != 0) // Make room for all new contacts
         {
-            printf("Cannot add %d contacts. Limit exceeded (max 100).\n", n);
-            return; // Exit if limit exceeded
+            printf("Cannot add %d contacts. Not enough memory.\n", n);
+            return; // Exit if storage cannot grow
         }
 
         for (int i = 0; i < n; i++) // Loop for each new contact
@@ -320,24 +195,30 @@ void create_contact(struct Address_book *addressbook) // Function to create new
             printf("\n╔════════════════════════════════════════════╗\n");
             printf("║               ADD CONTACT                  ║\n");
             printf("╠════════════════════════════════════════════╣\n");
-            printf("║ Contact Number:%-28d║\n", addressbook->contact_count + 1);
+            printf("║ Contact Number:%-28d║\n", count_contacts(addressbook) + 1);
             printf("╚════════════════════════════════════════════╝\n\n");
 
-            char name[32], mobile_number[11], mail_id[35]; // Temporary storage
+            char mobile_number[11]; // Temporary storage
+            struct Contact_data contact; // New contact being built
 
             printf("Enter Name: ");
-            valid_name(name); // Validate name input
-            strcpy(addressbook->contact_details[addressbook->contact_count].Name, name); // Store name
+            contact.Name = valid_name(); // Validate name input
 
             printf("Enter Mobile Number: ");
             valid_mobile_number(mobile_number, addressbook); // Validate mobile number
-            strcpy(addressbook->contact_details[addressbook->contact_count].Mobile_number, mobile_number); // Store mobile
+            strcpy(contact.Mobile_number, mobile_number); // Store mobile
 
             printf("Enter Mail ID: ");
-            valid_mail_id(mail_id, addressbook); // Validate mail ID
-            strcpy(addressbook->contact_details[addressbook->contact_count].Mail_ID, mail_id); // Store mail ID
+            contact.Mail_ID = valid_mail_id(addressbook); // Validate mail ID
 
-            addressbook->contact_count++; // Increment contact count
+            int result = addressbook_insert(addressbook, &contact); // Append and index the new contact (addressbook.c), which copies the strings
+            free((char *)contact.Name);
+            free((char *)contact.Mail_ID);
+            if (result != ADDRESSBOOK_OK)
+            {
+                printf("Error: %s\n", addressbook_message(result));
+                return;
+            }
 
             // Display success message
             printf("\n╔════════════════════════════════════════════╗\n");
@@ -354,52 +235,110 @@ void create_contact(struct Address_book *addressbook) // Function to create new
 
 
 /*------------------- List Contacts -------------------*/
+#define LIST_PAGE_SIZE 50 // Rows per page when listing to a terminal
+
 void list_contacts(struct Address_book *addressbook) // Function to display all contacts
 {
-    if (addressbook->contact_count == 0) // No contacts
+    int count = count_contacts(addressbook);
+    if (count == 0) // No contacts
     {
         printf("\nNo contacts available to display.\n");
         return;
     }
 
-    // Print table header
-// Table header
-printf("\n╔══════╦════════════════════╦══════════════╦═══════════════════════════════════════════╗\n");
-printf("║ %-4s ║ %-18s ║ %-12s ║ %-41s ║\n", "No.", "Name", "Mobile", "Mail ID");
-printf("╠══════╬════════════════════╬══════════════╬═══════════════════════════════════════════╣\n");
+    struct Renderer renderer; // Rows are gathered here and written in large blocks
 
-// Table rows
-for (int i = 0; i < addressbook->contact_count; i++)
-{
-    printf("║ %-4d ║ %-18.18s ║ %-12.12s ║ %-41.41s ║\n",
-        i + 1,                                       // No.
-        addressbook->contact_details[i].Name,       // Name
-        addressbook->contact_details[i].Mobile_number, // Mobile
-        addressbook->contact_details[i].Mail_ID     // Mail ID
-    );
-}
+    // Table rows come straight off the name index, already in dictionary order
+    if (count <= LIST_PAGE_SIZE || !isatty(STDOUT_FILENO)) // Fits on a screen, or not a screen: everything at once
+    {
+        render_begin(&renderer, STDOUT_FILENO, RENDER_TABLE, count);
+        render_page(addressbook, &renderer, first_contact(addressbook), 1, -1);
+        render_end(&renderer);
+        return;
+    }
 
-// Table footer
-printf("╚══════╩════════════════════╩══════════════╩═══════════════════════════════════════════╝\n");
+    int pages = (count + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+    int *page_first = malloc((size_t)pages * sizeof(int)); // First contact of each page seen so far, for going back
+    if (page_first == NULL)
+    {
+        printf("Error: not enough memory to list contacts\n");
+        return;
+    }
+    int page = 0;
+    page_first[0] = first_contact(addressbook);
+    while (1)
+    {
+        int shown = page == pages - 1 ? count - page * LIST_PAGE_SIZE : LIST_PAGE_SIZE;
+        render_begin(&renderer, STDOUT_FILENO, RENDER_TABLE, count);
+        int next = render_page(addressbook, &renderer, page_first[page], (long)page * LIST_PAGE_SIZE + 1, LIST_PAGE_SIZE);
+        render_end(&renderer);
+
+        printf("Showing %d-%d of %d. (n = next page, p = previous page, q = quit): ",
+               page * LIST_PAGE_SIZE + 1, page * LIST_PAGE_SIZE + shown, count);
+        char move;
+        if (scanf(" %c", &move) != 1 || move == 'q' || move == 'Q')
+            break;
+        if ((move == 'n' || move == 'N') && page + 1 < pages)
+            page_first[++page] = next; // Next page
+        else if ((move == 'p' || move == 'P') && page > 0)
+            page--; // Previous page
+    }
+    free(page_first);
 }
 
 /*------------------- Search Contact by Name -------------------*/
+#define FUZZY_SUGGESTIONS 10 // Closest names offered when none matches exactly
+
 int search_name(struct Address_book *addressbook) // Function to search contact(s) by name
 {
-    char name[35];
+    char *name;
     printf("Enter Name to search: ");
-    scanf(" %[^\n]", name); // Input search name
+    if (scanf(" %m[^\n]", &name) != 1) // Input search name, any length
+        name = NULL;
 
-    int count = 0; // Counter for matches
-    int index[100]; // Array to store indices of matching contacts
+    int count = 0, capacity = FUZZY_SUGGESTIONS; // Matches found, and room for them (most names match a handful)
+    int *index = malloc(capacity * sizeof(int)); // Indices of matching contacts, grown as needed
+    if (name == NULL || index == NULL)
+    {
+        printf("Error: not enough memory to search\n");
+        free(name);
+        free(index);
+        return -1;
+    }
 
-    // Collect ALL matches (case-insensitive, full match)
-    for (int i = 0; i < addressbook->contact_count; i++)
+    // Collect ALL matches (case-insensitive, full match): equal names (in any case) sit together in the name index
+    uint64_t start = stats_begin();
+    for (int i = name_index_seek(&addressbook->name_index, addressbook, name); // Jump to the first candidate in O(log n)
+         i != -1 && strcasecmp(contact_name(addressbook, i), name) == 0;
+         i = next_contact(addressbook, i))
     {
-        if (strcasecmp(addressbook->contact_details[i].Name, name) == 0) // Compare ignoring case
+        if (count == capacity)
         {
-            index[count++] = i;  // Store matching index
+            int *grown = realloc(index, (size_t)capacity * 2 * sizeof(int));
+            if (grown == NULL)
+            {
+                printf("Error: not enough memory to search\n");
+                free(name);
+                free(index);
+                return -1;
+            }
+            index = grown;
+            capacity *= 2;
         }
+        index[count++] = i;  // Store matching index
+    }
+    stats_add(count > 0 ? COUNT_NAME_HITS : COUNT_NAME_MISSES, 1);
+    stats_end(STAT_FIND_NAME, start);
+
+    int fuzzy = 0; // Set when the list holds near misses rather than the name itself
+    if (count == 0) // No exact match: offer the closest names (typos, swapped letters)
+    {
+        struct Search_hit hits[FUZZY_SUGGESTIONS];
+        int total;
+        int shown = fuzzy_search(addressbook, name, FUZZY_DISTANCE, 0, FUZZY_SUGGESTIONS, hits, &total);
+        for (int k = 0; k < shown; k++)
+            index[count++] = hits[k].index;
+        fuzzy = count > 0;
     }
 
     if (count == 0) // No match found
@@ -407,64 +346,75 @@ int search_name(struct Address_book *addressbook) // Function to search contact(
         printf("\n╔════════════════════════════════════════════╗\n");
         printf("║        NO CONTACT FOUND WITH THIS NAME     ║\n");
         printf("╚════════════════════════════════════════════╝\n\n");
+        free(name);
+        free(index);
         return -1; // Return -1 if not found
     }
 
     // Print all matches in a table
-// Table header
-printf("\n╔═══════╦════════════════════╦══════════════╦════════════════════════════════════════════╗\n");
-printf("║ %-5s ║ %-18s ║ %-12s ║ %-42s ║\n", "No.", "Name", "Mobile", "Mail ID");
-printf("╠═══════╬════════════════════╬══════════════╬════════════════════════════════════════════╣\n");
-
-// Table rows
-for (int k = 0; k < count; k++)
-{
-    int i = index[k];
-    printf("║ %-5d ║ %-18.18s ║ %-12.12s ║ %-42.42s ║\n",
-        k + 1,                                       // No.
-        addressbook->contact_details[i].Name,       // Name
-        addressbook->contact_details[i].Mobile_number, // Mobile
-        addressbook->contact_details[i].Mail_ID     // Mail ID
-    );
-}
-
-// Table footer
-printf("╚═══════╩════════════════════╩══════════════╩════════════════════════════════════════════╝\n");
+    if (fuzzy)
+        printf("\nNo contact named \"%s\". Closest names:\n", name);
+    free(name);
+    struct Renderer renderer; // Rows are gathered here and written in large blocks
+    render_begin(&renderer, STDOUT_FILENO, RENDER_TABLE, count);
+    for (int k = 0; k < count; k++)
+    {
+        struct Contact_data contact;
+        get_contact(addressbook, index[k], &contact);
+        render_contact(&renderer, k + 1, &contact);
+    }
+    render_end(&renderer);
 
-    if (count == 1)
-    return index[0];  // Only one match → return its index
+    int found = index[0];
+    if (count == 1 && !fuzzy)
+    {
+        free(index);
+        return found;  // Only one match → return its index
+    }
     int choice;
-    printf("\nMultiple contacts found. Select a contact (1-%d): ", count);
-    if (scanf("%d", &choice) != 1 || choice < 1 || choice > count) { // Validate input
+    if (fuzzy) // A near miss is never picked without asking
+        printf("\nSelect a contact (1-%d, 0 = none): ", count);
+    else
+        printf("\nMultiple contacts found. Select a contact (1-%d): ", count);
+    if (scanf("%d", &choice) != 1)
+        choice = -1; // Not a number
+    if (fuzzy && choice == 0)
+    {
+        free(index);
+        return -1;
+    }
+    if (choice < 1 || choice > count) { // Validate input
         printf("Invalid choice!\n");
+        free(index);
         return -1;
     }
 
-    return index[choice - 1];  // Return actual index in addressbook
+    found = index[choice - 1];
+    free(index);
+    return found;  // Return actual index in addressbook
 }
 
 
 /*------------------- Search Contact by Mobile -------------------*/
 int search_Mobile_Number(struct Address_book *addressbook) // Function to search contact by mobile number
 {
-    char mobile[11];
+    char mobile[INPUT_SIZE];
     printf("Enter Mobile Number to search: ");
-    scanf(" %s", mobile); // Input mobile number
+    if (scanf(" %255s", mobile) != 1) // Input mobile number (bounded)
+        mobile[0] = '\0';
 
-    for (int i = 0; i < addressbook->contact_count; i++) // Loop through contacts
+    int i = find_by_mobile(addressbook, mobile); // Hash index lookup
+    if (i != -1) // Match found
     {
-        if (strcmp(addressbook->contact_details[i].Mobile_number, mobile) == 0) // Match found
-        {
-            // Display contact details in formatted box
-            printf("\n╔════════════════════════════════════════════╗\n");
-            printf("║              CONTACT FOUND                 ║\n");
-            printf("╠════════════════════════════════════════════╣\n");
-            printf("║ Name   : %-33s ║\n", addressbook->contact_details[i].Name);
-            printf("║ Mail   : %-33s ║\n", addressbook->contact_details[i].Mail_ID);
-            printf("║ Mobile : %-33s ║\n", addressbook->contact_details[i].Mobile_number);
-            printf("╚════════════════════════════════════════════╝\n\n");
-            return i; // Return index of found contact
-        }
+        // Display contact details in formatted box
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║              CONTACT FOUND                 ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ Name   : %-33s ║\n", contact_name(addressbook, i));
+        printf("║ Mail   : %-33s ║\n", contact_mail(addressbook, i));
+        printf("║ Mobile : %-33s ║\n", contact_mobile(addressbook, i));
+        printf("╚════════════════════════════════════════════╝\n\n");
+        return i; // Return index of found contact
     }
 
     // No match found
@@ -478,24 +428,23 @@ int search_Mobile_Number(struct Address_book *addressbook) // Function to search
 /*------------------- Search Contact by Mail -------------------*/
 int search_mail_id(struct Address_book *addressbook) // Function to search contact by Mail ID
 {
-    char mail[35]; // Buffer to store input Mail ID
+    char mail[INPUT_SIZE]; // Buffer to store input Mail ID
     printf("Enter Mail ID to search: ");
-    scanf(" %s", mail); // Input Mail ID
+    if (scanf(" %255s", mail) != 1) // Input Mail ID (bounded)
+        mail[0] = '\0';
 
-    for (int i = 0; i < addressbook->contact_count; i++) // Loop through all contacts
+    int i = find_by_mail(addressbook, mail); // Hash index lookup
+    if (i != -1) // Check for match
     {
-        if (strcmp(addressbook->contact_details[i].Mail_ID, mail) == 0) // Check for match
-        {
-            // Display contact details in formatted box
-            printf("\n╔════════════════════════════════════════════╗\n");
-            printf("║              CONTACT FOUND                 ║\n");
-            printf("╠════════════════════════════════════════════╣\n");
-            printf("║ Name   : %-33s ║\n", addressbook->contact_details[i].Name); // Print Name
-            printf("║ Mail   : %-33s ║\n", addressbook->contact_details[i].Mail_ID); // Print Mail ID
-            printf("║ Mobile : %-33s ║\n", addressbook->contact_details[i].Mobile_number); // Print Mobile
-            printf("╚════════════════════════════════════════════╝\n\n");
-            return i; // Return index of found contact
-        }
+        // Display contact details in formatted box
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║              CONTACT FOUND                 ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ Name   : %-33s ║\n", contact_name(addressbook, i)); // Print Name
+        printf("║ Mail   : %-33s ║\n", contact_mail(addressbook, i)); // Print Mail ID
+        printf("║ Mobile : %-33s ║\n", contact_mobile(addressbook, i)); // Print Mobile
+        printf("╚════════════════════════════════════════════╝\n\n");
+        return i; // Return index of found contact
     }
 
     // If no match found, display message
@@ -506,13 +455,82 @@ int search_mail_id(struct Address_book *addressbook) // Function to search conta
 }
 
 
+/*------------------- Search Contact by Partial Name / Mail -------------------*/
+#define PAGE_SIZE 10 // Results shown per page of a partial search
+
+static void show_pages(struct Address_book *addressbook, const char *query, int phonetic) // Page through text_search or phonetic_search hits
+{
+    struct Search_hit hits[PAGE_SIZE]; // One page of results
+    int offset = 0, total = 0;
+    while (1)
+    {
+        int shown = phonetic ? phonetic_search(addressbook, query, PHONETIC_DISTANCE, offset, PAGE_SIZE, hits, &total)
+                             : text_search(addressbook, query, SEARCH_NAME | SEARCH_MAIL, offset, PAGE_SIZE, hits, &total);
+        if (shown < 0)
+        {
+            printf("Error: not enough memory to search\n");
+            return;
+        }
+        if (total == 0) // No match found
+        {
+            printf("\n╔════════════════════════════════════════════╗\n");
+            if (phonetic)
+                printf("║      NO CONTACT NAME SOUNDS LIKE THIS      ║\n");
+            else
+                printf("║        NO CONTACT FOUND WITH THIS TEXT     ║\n");
+            printf("╚════════════════════════════════════════════╝\n\n");
+            return;
+        }
+
+        struct Renderer renderer; // One page, written in one block
+        render_begin(&renderer, STDOUT_FILENO, RENDER_TABLE, offset + shown); // Best matches first
+        for (int k = 0; k < shown; k++)
+        {
+            struct Contact_data contact;
+            get_contact(addressbook, hits[k].index, &contact);
+            render_contact(&renderer, offset + k + 1, &contact);
+        }
+        render_end(&renderer);
+
+        printf("Showing %d-%d of %d. (n = next page, p = previous page, q = quit): ", offset + 1, offset + shown, total);
+        char move;
+        if (scanf(" %c", &move) != 1 || move == 'q' || move == 'Q')
+            return;
+        if ((move == 'n' || move == 'N') && offset + PAGE_SIZE < total)
+            offset += PAGE_SIZE; // Next page
+        else if ((move == 'p' || move == 'P') && offset > 0)
+            offset -= PAGE_SIZE; // Previous page
+    }
+}
+
+void search_partial(struct Address_book *addressbook) // Type-ahead search: prefix or part of Name / Mail ID
+{
+    char query[64];
+    printf("Enter part of a Name or Mail ID: ");
+    if (scanf(" %63[^\n]", query) != 1) // Input search text
+        return; // End of input: nothing to search for
+    show_pages(addressbook, query, 0);
+}
+
+
+/*------------------- Search Contact by Sound -------------------*/
+void search_sounds_like(struct Address_book *addressbook) // Names spelt as heard: "Barath" finds "Bharath"
+{
+    char name[64];
+    printf("Enter Name as it sounds: ");
+    if (scanf(" %63[^\n]", name) != 1) // Input search name
+        return; // End of input: nothing to search for
+    show_pages(addressbook, name, 1);
+}
+
+
 /*------------------- Search Contacts Menu -------------------*/
 void search_contacts(struct Address_book *addressbook) // Function to provide a menu for searching contacts
 {
     while (1) // Infinite loop to keep menu active until user exits
     {
         // Display search menu options
-        printf("\nSearch Contacts Menu:\n1.Name\n2.Mobile Number\n3.Mail ID\n4.Exit\nEnter choice: ");
+        printf("\nSearch Contacts Menu:\n1.Name\n2.Mobile Number\n3.Mail ID\n4.Partial Name / Mail ID\n5.Name Sounds Like\n6.Exit\nEnter choice: ");
         int choice;
         scanf("%d", &choice); // Input user choice
 
@@ -522,7 +540,11 @@ void search_contacts(struct Address_book *addressbook) // Function to provide a
             search_Mobile_Number(addressbook); // Call function to search by mobile
         else if (choice == 3) // If user chooses Mail ID
             search_mail_id(addressbook); // Call function to search by mail
-        else if (choice == 4) // If user chooses Exit
+        else if (choice == 4) // If user chooses partial search
+            search_partial(addressbook); // Call function for prefix / substring search
+        else if (choice == 5) // If user chooses sound-alike search
+            search_sounds_like(addressbook); // Call function for phonetic name search
+        else if (choice == 6) // If user chooses Exit
             return; // Exit the function
         else // Invalid input
             printf("Invalid choice. Try again.\n"); // Prompt invalid choice
@@ -588,45 +610,46 @@ void edit_contact(struct Address_book *addressbook) // Function to edit an exist
             int edit_choice;
             scanf("%d", &edit_choice); // Input edit choice
 
-            char temp_name[32], temp_mobile[11], temp_mail[35]; // Temporary storage for inputs
+            char temp_mobile[11]; // Temporary storage for inputs
+            char *temp_name = NULL, *temp_mail = NULL; // New name and mail ID, read at any length
+            struct Contact_data updated; // Current fields to edit, stored via addressbook_update
+            get_contact(addressbook, res, &updated);
+            char key[sizeof(updated.Mobile_number)]; // Mobile number the contact has until the update
+            strcpy(key, updated.Mobile_number);
+            const char *done = NULL; // Success message of the chosen edit
 
             switch (edit_choice) // Handle edit options
             {
                 case 1: // Edit Name
                     printf("Enter new Name: ");
-                    valid_name(temp_name); // Validate name
-                    strcpy(addressbook->contact_details[res].Name, temp_name); // Update name
-                    printf("Name updated successfully!\n");
+                    updated.Name = temp_name = valid_name(); // Validate name
+                    done = "Name updated successfully!";
                     break;
 
                 case 2: // Edit Mobile Number
                     printf("Enter new Mobile Number: ");
                     valid_mobile_number(temp_mobile, addressbook); // Validate mobile
-                    strcpy(addressbook->contact_details[res].Mobile_number, temp_mobile); // Update mobile
-                    printf("Mobile number updated successfully!\n");
+                    strcpy(updated.Mobile_number, temp_mobile); // Update mobile
+                    done = "Mobile number updated successfully!";
                     break;
 
                 case 3: // Edit Mail ID
                     printf("Enter new Mail ID: ");
-                    valid_mail_id(temp_mail, addressbook); // Validate mail
-                    strcpy(addressbook->contact_details[res].Mail_ID, temp_mail); // Update mail
-                    printf("Mail ID updated successfully!\n");
+                    updated.Mail_ID = temp_mail = valid_mail_id(addressbook); // Validate mail
+                    done = "Mail ID updated successfully!";
                     break;
 
                 case 4: // Edit all fields
                     printf("Enter new Name: ");
-                    valid_name(temp_name);
-                    strcpy(addressbook->contact_details[res].Name, temp_name);
+                    updated.Name = temp_name = valid_name();
 
                     printf("Enter new Mobile Number: ");
                     valid_mobile_number(temp_mobile, addressbook);
-                    strcpy(addressbook->contact_details[res].Mobile_number, temp_mobile);
+                    strcpy(updated.Mobile_number, temp_mobile);
 
                     printf("Enter new Mail ID: ");
-                    valid_mail_id(temp_mail, addressbook);
-                    strcpy(addressbook->contact_details[res].Mail_ID, temp_mail);
-
-                    printf("All fields updated successfully!\n");
+                    updated.Mail_ID = temp_mail = valid_mail_id(addressbook);
+                    done = "All fields updated successfully!";
                     break;
 
                 case 5: // Exit edit menu
@@ -636,6 +659,17 @@ void edit_contact(struct Address_book *addressbook) // Function to edit an exist
                 default: // Invalid input
                     printf("Invalid choice. Try again.\n");
             }
+
+            if (done != NULL) // Store the edited fields and re-index them (addressbook.c)
+            {
+                int result = addressbook_update(addressbook, key, &updated);
+                if (result == ADDRESSBOOK_OK)
+                    printf("%s\n", done);
+                else
+                    printf("Error: %s\n", addressbook_message(result));
+            }
+            free(temp_name);
+            free(temp_mail);
         }
 
         // Step 3: Ask if user wants to edit another contact
@@ -648,7 +682,7 @@ void edit_contact(struct Address_book *addressbook) // Function to edit an exist
 /*------------------- Delete Contact -------------------*/
 void delete_contact(struct Address_book *addressbook) // Function to delete a contact
 {
-    if (addressbook->contact_count == 0)   // Check if any contacts exist
+    if (count_contacts(addressbook) == 0)   // Check if any contacts exist
     {
         printf("No contacts available to delete.\n");
         return; // Exit if none
@@ -701,11 +735,9 @@ void delete_contact(struct Address_book *addressbook) // Function to delete a co
         else
         {
             // Step 3: Delete Contact
-            for (int i = index; i < addressbook->contact_count - 1; i++) // Shift contacts
-            {
-                addressbook->contact_details[i] = addressbook->contact_details[i + 1]; // Overwrite deleted contact
-            }
-            addressbook->contact_count--; // Reduce count
+            char key[11]; // The slot is reused by the delete, so the key is copied first
+            strcpy(key, contact_mobile(addressbook, index));
+            addressbook_delete(addressbook, key); // Drop index entries and free the slot
 
             // Display success message
         printf("\n╔════════════════════════════════════════════════════════════════════════════╗\n");
@@ -724,19 +756,47 @@ printf("╚═══════════════════════
 /*------------------- Save Contacts to File -------------------*/
 void save_contacts(struct Address_book *addressbook)
 {
-    FILE *fp = fopen("data.txt", "w");            // Open file in write mode
-    if (!fp) return;                             // Exit if file can't be opened
+    uint64_t start = stats_begin();
+    if (addressbook->wal != NULL)                // Every change is already in the log: just make it durable (wal.c)
+    {
+        if (wal_close(addressbook) != 0)
+            printf("Error: could not save all changes to %s\n", LOG_FILE);
+    }
+    else if (save_snapshot(addressbook, SNAPSHOT_FILE, 0) != 0)  // Records and name order in one binary file (snapshot.c)
+        printf("Error: could not save contacts to %s\n", SNAPSHOT_FILE);
+    stats_end(STAT_SAVE, start);
+}
 
-    fprintf(fp, "#%d\n", addressbook->contact_count);  // Write total contacts
 
-    for (int i = 0; i < addressbook->contact_count; i++)
+/*------------------- Export Contacts as Text -------------------*/
+int export_contacts(struct Address_book *addressbook, const char *path)
+{
+    char temp[4096];                             // Written here, renamed over 'path' once complete
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp)) return -1;
+    uint64_t start = stats_begin();
+    FILE *fp = fopen(temp, "w");                 // Open file in write mode
+    if (!fp) return -1;                          // Exit if file can't be opened
+
+    fprintf(fp, "#%d\n", count_contacts(addressbook));  // Write total contacts
+
+    for (int i = first_contact(addressbook); i != -1; i = next_contact(addressbook, i)) // Sorted order, so the next load needs no sort
     {
         // Write each contact's Name, Mail ID, Mobile Number separated by commas
         fprintf(fp, "%s,%s,%s\n",
-                addressbook->contact_details[i].Name,
-                addressbook->contact_details[i].Mobile_number,
-                addressbook->contact_details[i].Mail_ID);
+                contact_name(addressbook, i),
+                contact_mobile(addressbook, i),
+                contact_mail(addressbook, i));
     }
 
-    fclose(fp);                                   // Close the file
+    int ok = fflush(fp) == 0 && !ferror(fp);     // Every line reached the file (disk not full)
+    stats_add(COUNT_BYTES_WRITTEN, (uint64_t)ftell(fp));
+    ok = sync_file(fileno(fp)) == 0 && ok;       // Flush as the durability level asks (durability.c)
+    ok = fclose(fp) == 0 && ok;                  // Close the file
+    if (!ok || replace_file(temp, path) != 0)    // Old file stays intact unless the new one is complete
+    {
+        remove(temp);
+        return -1;
+    }
+    stats_end(STAT_EXPORT, start);
+    return 0;
 }
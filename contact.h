@@ -1,30 +1,113 @@
 #ifndef CONTACT_H           // Header guard start, prevents multiple inclusion
 #define CONTACT_H
 
+#include <stdio.h>          // FILE is used by load_contact
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint64_t snapshot generations
+#include "arena.h"          // Names and mail IDs kept by length
+#include "hash_index.h"     // Exact-match indexes on Mobile_number and Mail_ID
+#include "name_index.h"     // Ordered index on Name
+#include "text_index.h"     // Trigram index for partial Name / Mail_ID search
+#include "mobile_column.h"  // Packed mobile numbers for range scans
+#include "phonetic.h"       // Sound-alike keys for phonetic name search
+#include "wal.h"            // Change log of adds, edits and deletes
+#include "validate.h"       // Contact rules and their error codes
+#include "addressbook.h"    // Library interface and struct Contact_data
+
+#define DATA_FILE "data.txt"        // Text import/export file
+#define SNAPSHOT_FILE "data.snap"   // Binary snapshot opened at startup (snapshot.c)
+#define LOG_FILE "data.wal"         // Changes made since that snapshot (wal.c)
+#define SOCKET_FILE "addressbook.sock" // Unix socket of the query server (server.c)
+#define STATS_FILE "addressbook.stats" // Statistics the server dumps every STATS_INTERVAL seconds (stats.c)
+
 /*------------------ Structure Declarations ------------------*/
 
-struct Contact_data       // Structure to store individual contact information
+struct Contact_record     // A stored contact: 28 bytes plus the arena bytes of a long name or mail ID
 {
-    char Name[32];        // Name of contact (max 31 chars + null terminator)
-    char Mobile_number[11]; // Mobile number (10 digits + null terminator)
-    char Mail_ID[35];     // Email ID of contact (max 34 chars + null terminator)
+    union Text_slot name;   // Name, in the slot if under 8 characters, else in the book's arena
+    union Text_slot mail;   // Mail ID, the same way
+    char Mobile_number[11]; // Mobile number (10 digits + null terminator), empty in a deleted slot
 };
 
 struct Address_book       // Structure to store multiple contacts
 {
-    struct Contact_data contact_details[100]; // Array to store up to 100 contacts
+    struct Contact_record *contact_details; // Growable array of contacts (see store.c)
+    struct Text_arena strings; // Names and mail IDs of 8 characters or more
     int contact_count;      // Number of contacts currently stored
+    int capacity;           // Number of slots allocated in contact_details
+    int deleted_count;      // Slots below contact_count freed by remove_contact, reclaimed by compact_contacts
+    struct Hash_index mobile_index; // Mobile_number -> contact index
+    struct Hash_index mail_index;   // Mail_ID -> contact index
+    struct Name_index name_index;   // Contacts in dictionary order of Name
+    struct Text_index *text_index;  // Built on first partial search, NULL until then
+    struct Mobile_column *mobile_column; // Built on first mobile range query, NULL until then
+    struct Phonetic_index *phonetic_index; // Built on first sound-alike search, NULL until then
+    void *mapping;          // Snapshot mapping holding contact_details or strings, NULL when both are on the heap
+    size_t mapping_size;    // Length of that mapping
+    struct Wal *wal;        // Change log every insert/update/remove is written to, NULL when not logging
 };
 
 /*------------------ Function Declarations ------------------*/
 
+/* Contact store (store.c) */
+void init_address_book(struct Address_book *addressbook); // Start with an empty address book
+int reserve_contacts(struct Address_book *addressbook, int capacity); // Grow storage to hold 'capacity' contacts, 0 on success or -1
+int append_contact(struct Address_book *addressbook, const struct Contact_data *contact); // Append a contact without indexing it, return its index or -1
+int reserve_strings(struct Address_book *addressbook, size_t bytes); // Room for 'bytes' more arena bytes that bulk loads fill in directly, 0 or -1
+const char *contact_name(const struct Address_book *addressbook, int index); // Name of a contact ("" for a deleted slot)
+const char *contact_mail(const struct Address_book *addressbook, int index); // Mail ID of a contact ("" for a deleted slot)
+const char *contact_mobile(const struct Address_book *addressbook, int index); // Mobile number of a contact ("" for a deleted slot)
+void get_contact(const struct Address_book *addressbook, int index, struct Contact_data *contact); // View of a contact, pointing into the book until it changes
+int pack_strings(struct Contact_record *records, int count, const struct Text_arena *from, struct Text_arena *to); // Copy the strings 'records' use from 'from' into a fresh 'to' and point them there, 0 or -1
+int compact_strings(struct Address_book *addressbook); // Drop the garbage of the book's arena (leaves the snapshot mapping), 0 or -1
+void destroy_address_book(struct Address_book *addressbook); // Free all storage held by the address book
+int rebuild_indexes(struct Address_book *addressbook); // Re-index every contact after bulk changes, 0 on success or -1
+int rebuild_indexes_in_order(struct Address_book *addressbook, const int *order); // Same, given the contacts in name order
+int insert_contact(struct Address_book *addressbook, const struct Contact_data *contact); // Append and index a contact, return its index or -1
+int update_contact(struct Address_book *addressbook, int index, const struct Contact_data *contact); // Replace a contact and its index entries, 0 or -1
+void remove_contact(struct Address_book *addressbook, int index); // Delete a contact and its index entries, O(1) (leaves a tombstone)
+int remove_contacts(struct Address_book *addressbook, const char *const *keys, int count); // Delete every contact named by a mobile number or mail ID, return how many
+int compact_contacts(struct Address_book *addressbook); // Reclaim the slots of deleted contacts (renumbers contacts), 0 or -1
+int contact_deleted(const struct Address_book *addressbook, int index); // Is slot 'index' a deleted contact awaiting compaction?
+int count_contacts(const struct Address_book *addressbook); // Number of contacts, not counting deleted slots
+int first_contact(const struct Address_book *addressbook); // Index of first contact in name order, or -1
+int next_contact(const struct Address_book *addressbook, int index); // Index of contact after 'index' in name order, or -1
+int find_by_mobile(const struct Address_book *addressbook, const char *mobile_number); // Index of contact with this mobile, or -1
+int find_by_mail(const struct Address_book *addressbook, const char *mail_id); // Index of contact with this mail ID, or -1
+int find_by_name(const struct Address_book *addressbook, const char *name); // First contact (in name order) with this name, any case, or -1
+
 /* Load contacts from file */
 void load_contact(FILE *fp, struct Address_book *addressbook); // Reads data from file and stores in address book
+int load_contacts_fd(int fd, struct Address_book *addressbook, const char *source); // Map/read a whole file and append its records, bad line count or -1 (loader.c)
+int parse_contacts(const char *data, size_t length, struct Address_book *addressbook, const char *source); // Append records from a text buffer, bad line count or -1
+const char *parse_record(char *line, size_t length, struct Contact_data *contact); // Split one "Name,Mobile,Mail" line in place (line[length] is overwritten), NULL or why it is bad
+
+/* Library helpers (addressbook.c) */
+void report_problem(const char *format, ...); // printf-style warning to the addressbook_set_diagnostics stream, if any
+int find_by_key(const struct Address_book *addressbook, const char *key); // Contact named by a mobile number or mail ID, or -1
+int check_change(const struct Address_book *addressbook, const struct Contact_data *contact, int index); // Rules and uniqueness for storing 'contact' in slot 'index' (-1 = new), VALID or a validate.h code
+
+/* Batch commands (batch.c) */
+int run_batch(struct Address_book *addressbook, const char *command, FILE *in, const char *source, int print); // Run a record/command stream with no prompts, print one summary, 0 or -1
+
+/* Query server (server.c) */
+int run_server(struct Address_book *addressbook, const char *socket_path); // Answer requests on a Unix socket until SIGINT/SIGTERM, 0 or -1
+int print_server_stats(const char *socket_path); // Print the statistics of the server on 'socket_path', 0 or -1 if none answers
+
+/* Binary snapshot (snapshot.c) */
+int save_snapshot(const struct Address_book *addressbook, const char *path, uint64_t generation); // Write records and name order to 'path', 0 or -1
+int write_snapshot(const char *path, const struct Contact_record *records, const int *order, int count,
+                   const struct Text_arena *strings, uint64_t generation); // Same, from copies whose arena holds nothing else, 0 or -1
+int open_snapshot(const char *path, struct Address_book *addressbook, uint64_t *generation); // Map a snapshot into an empty book, 0 or -1 if missing or invalid
+int *name_order(const struct Address_book *addressbook); // malloc'd array of contact indices in name order, NULL if out of memory
+int copy_contacts(const struct Address_book *addressbook, struct Contact_record **records, int **order,
+                  struct Text_arena *strings); // malloc'd copy of the live contacts, their name order and just their strings, count or -1
+uint64_t snapshot_checksum(uint64_t state, const void *data, size_t length); // 64-bit checksum, chainable through 'state'
 
-/* Validate user input */
-void valid_name(char *name); // Validate name (only alphabets and spaces)
+/* Validate user input (prompt until the rules in validate.c pass) */
+char *valid_name(void); // Validate name (only alphabets and spaces), malloc'd or NULL if out of memory
 void valid_mobile_number(char *mobile_number, struct Address_book *addressbook); // Validate mobile number (digits, length, uniqueness)
-void valid_mail_id(char *mail_id, struct Address_book *addressbook); // Validate mail ID (format and uniqueness)
+char *valid_mail_id(struct Address_book *addressbook); // Validate mail ID (format and uniqueness), malloc'd or NULL if out of memory
 
 /* Create, List, Search, Edit, Delete, Save */
 void create_contact(struct Address_book *addressbook); // Add new contact(s) to address book
@@ -33,11 +116,14 @@ void search_contacts(struct Address_book *addressbook); // Menu for searching co
 int search_name(struct Address_book *addressbook); // Search contact by name, return index or -1 if not found
 int search_Mobile_Number(struct Address_book *addressbook); // Search contact by mobile number
 int search_mail_id(struct Address_book *addressbook); // Search contact by mail ID
+void search_partial(struct Address_book *addressbook); // Type-ahead search by part of a Name or Mail ID, ranked and paged
+void search_sounds_like(struct Address_book *addressbook); // Names that sound like the one typed (phonetic.c), closest spelling first, paged
 void edit_contact(struct Address_book *addressbook); // Edit contact fields
 void delete_contact(struct Address_book *addressbook); // Delete contact from address book
-void save_contacts(struct Address_book *addressbook); // Save all contacts to file
+void save_contacts(struct Address_book *addressbook); // Make every change durable (change log, or a full snapshot when none is open)
+int export_contacts(struct Address_book *addressbook, const char *path); // Write all contacts as text (data.txt format), 0 or -1
 
-/* Sort contacts alphabetically by Name */
-void sort_contact_by_name(struct Address_book *addressbook); // Sort contacts in dictionary order by name
+/* Sort contacts alphabetically by Name (sort.c) */
+void sort_contacts_by_name(struct Address_book *addressbook); // Sort contacts in dictionary order by name
 
 #endif // CONTACT_H          // End of header guard
@@ -0,0 +1,76 @@
+/*------------------------------------------------------------------------------
+-> File         : durability.c
+-> Description  : Durability knob shared by every file the address book
+                  writes (snapshot, change log, text export). Files are
+                  always written under a temporary name and renamed over the
+                  old one, so a crash or full disk leaves either the old or
+                  the new file, never a half-written one. The level decides
+                  how much of that survives a power cut:
+                    none  rename only, the OS flushes when it likes
+                    data  fdatasync the file before the rename
+                    full  fsync the file, and the directory after the rename
+------------------------------------------------------------------------------*/
+#include <stdlib.h>     // Include getenv
+#include <string.h>     // Include strcmp, strrchr, memcpy
+#include <stdio.h>      // Include rename
+#include <fcntl.h>      // Include open for the directory
+#include <unistd.h>     // Include fsync, fdatasync, close
+#include "durability.h" // Include durability declarations
+
+static int configured_level = -1; // -1 = decide from the environment
+
+void set_durability(int level) // Knob used by the CLI and benchmarks
+{
+    configured_level = level >= DURABILITY_NONE && level <= DURABILITY_FULL ? level : -1;
+}
+
+int durability(void) // Level every write should use
+{
+    if (configured_level >= 0)
+        return configured_level;
+
+    const char *env = getenv("ADDRESSBOOK_DURABILITY"); // Environment override
+    if (env != NULL && strcmp(env, "none") == 0)
+        return DURABILITY_NONE;
+    if (env != NULL && strcmp(env, "data") == 0)
+        return DURABILITY_DATA;
+    return DURABILITY_FULL;
+}
+
+int sync_file(int fd) // Make a file's contents durable
+{
+    switch (durability())
+    {
+        case DURABILITY_NONE:
+            return 0;
+        case DURABILITY_DATA:
+            return fdatasync(fd);
+        default:
+            return fsync(fd);
+    }
+}
+
+int replace_file(const char *temp, const char *path) // Atomic replace, then make the new name durable
+{
+    if (rename(temp, path) != 0)
+        return -1;
+    if (durability() < DURABILITY_FULL)
+        return 0;
+
+    char dir[4096] = ".";       // Directory holding 'path'
+    const char *slash = strrchr(path, '/');
+    if (slash != NULL)
+    {
+        size_t length = slash == path ? 1 : (size_t)(slash - path);
+        if (length >= sizeof(dir))
+            return -1;
+        memcpy(dir, path, length);
+        dir[length] = '\0';
+    }
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return -1;
+    int status = fsync(fd); // The rename itself is a directory change
+    close(fd);
+    return status;
+}
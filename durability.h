@@ -0,0 +1,15 @@
+#ifndef DURABILITY_H        // Header guard start, prevents multiple inclusion
+#define DURABILITY_H
+
+#define DURABILITY_NONE 0   // Leave flushing to the operating system
+#define DURABILITY_DATA 1   // fdatasync files before they replace the old ones or count as saved
+#define DURABILITY_FULL 2   // fsync files, and fsync the directory after every rename
+
+/*------------------ Function Declarations ------------------*/
+
+void set_durability(int level); // Force a durability level (-1 = automatic)
+int durability(void); // Level to use: set_durability, else $ADDRESSBOOK_DURABILITY (none/data/full), else full
+int sync_file(int fd); // Flush a written file as the level asks, 0 or -1
+int replace_file(const char *temp, const char *path); // Rename temp over path atomically, syncing the directory at full, 0 or -1
+
+#endif // DURABILITY_H       // End of header guard
@@ -0,0 +1,169 @@
+/*------------------------------------------------------------------------------
+-> File         : hash_index.c
+-> Description  : Open-addressing hash index for exact lookups on one string
+                  field of a contact (Mobile_number or Mail_ID).
+                  Slots hold contact indices; the key itself is read back
+                  from the book, so the index costs 8 bytes per slot.
+                  Linear probing with backward-shift deletion keeps probe
+                  chains short without tombstones. Load factor stays <= 1/2.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, free)
+#include <string.h>     // Include string handling functions (strcmp)
+#include <limits.h>     // Include INT_MAX for capacity overflow checks
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "hash_index.h" // Include hash index declarations
+
+#define EMPTY_SLOT -1   // Marker for an unused slot
+
+static const char *key_of(const struct Hash_index *index, const struct Address_book *addressbook, int contact) // Indexed field of a contact
+{
+    return index->key(addressbook, contact);
+}
+
+unsigned int hash_key(const char *key) // FNV-1a, good spread for short digit/mail strings
+{
+    unsigned int hash = 2166136261u;
+    while (*key)
+    {
+        hash ^= (unsigned char)*key++; // Mix in next byte
+        hash *= 16777619u;             // FNV prime
+    }
+    return hash;
+}
+
+void hash_index_init(struct Hash_index *index, const char *(*key)(const struct Address_book *, int)) // Start with no slots
+{
+    memset(index, 0, sizeof(*index));
+    index->key = key;
+}
+
+void hash_index_free(struct Hash_index *index) // Release slot arrays
+{
+    free(index->slots);
+    free(index->hashes);
+    hash_index_init(index, index->key); // Keep the field, drop the contents
+}
+
+static void place(struct Hash_index *index, unsigned int hash, int contact) // Put entry in first free slot of its probe chain
+{
+    int mask = index->capacity - 1;
+    int i = hash & mask;
+    while (index->slots[i] != EMPTY_SLOT) // Linear probing
+        i = (i + 1) & mask;
+    index->slots[i] = contact;
+    index->hashes[i] = hash;
+    index->size++;
+}
+
+static int resize(struct Hash_index *index, int capacity) // Rehash every entry into 'capacity' slots
+{
+    int *slots = malloc((size_t)capacity * sizeof(int));
+    unsigned int *hashes = malloc((size_t)capacity * sizeof(unsigned int));
+    if (slots == NULL || hashes == NULL)
+    {
+        free(slots);
+        free(hashes);
+        return -1;
+    }
+    memset(slots, 0xff, (size_t)capacity * sizeof(int)); // All bytes 0xff == EMPTY_SLOT
+
+    int *old_slots = index->slots;
+    unsigned int *old_hashes = index->hashes;
+    int old_capacity = index->capacity;
+
+    index->slots = slots;
+    index->hashes = hashes;
+    index->capacity = capacity;
+    index->size = 0;
+    for (int i = 0; i < old_capacity; i++) // Move old entries over, hashes are reused
+        if (old_slots[i] != EMPTY_SLOT)
+            place(index, old_hashes[i], old_slots[i]);
+
+    free(old_slots);
+    free(old_hashes);
+    return 0;
+}
+
+static int reserve(struct Hash_index *index, int entries) // Make sure 'entries' keys fit under load factor 1/2
+{
+    if (entries <= index->capacity / 2)
+        return 0;
+
+    int capacity = index->capacity ? index->capacity : 16;
+    while (capacity / 2 < entries) // Next power of two with room to spare
+    {
+        if (capacity > INT_MAX / 2)
+            return -1;
+        capacity *= 2;
+    }
+    return resize(index, capacity);
+}
+
+/*------------------- Build Index -------------------*/
+int hash_index_build(struct Hash_index *index, const struct Address_book *addressbook, int count) // Rebuild from scratch
+{
+    hash_index_free(index);
+    if (reserve(index, count) != 0)
+        return -1;
+    for (int i = 0; i < count; i++)
+        place(index, hash_key(key_of(index, addressbook, i)), i);
+    return 0;
+}
+
+/*------------------- Find Key -------------------*/
+int hash_index_find(const struct Hash_index *index, const struct Address_book *addressbook, const char *key) // Contact index or -1
+{
+    if (index->size == 0)
+        return -1;
+
+    unsigned int hash = hash_key(key);
+    int mask = index->capacity - 1;
+    for (int i = hash & mask; index->slots[i] != EMPTY_SLOT; i = (i + 1) & mask) // Walk the probe chain
+    {
+        if (index->hashes[i] == hash && strcmp(key_of(index, addressbook, index->slots[i]), key) == 0) // Cheap hash check first
+            return index->slots[i];
+    }
+    return -1; // Hit an empty slot: key not present
+}
+
+/*------------------- Insert Record -------------------*/
+int hash_index_insert(struct Hash_index *index, const struct Address_book *addressbook, int contact) // Add one record
+{
+    if (reserve(index, index->size + 1) != 0)
+        return -1;
+    place(index, hash_key(key_of(index, addressbook, contact)), contact);
+    return 0;
+}
+
+/*------------------- Remove Record -------------------*/
+void hash_index_remove(struct Hash_index *index, const struct Address_book *addressbook, int contact) // Drop entry pointing at contact
+{
+    if (index->size == 0)
+        return;
+
+    unsigned int hash = hash_key(key_of(index, addressbook, contact));
+    int mask = index->capacity - 1;
+    int i = hash & mask;
+    while (index->slots[i] != contact) // Find the slot holding this contact
+    {
+        if (index->slots[i] == EMPTY_SLOT)
+            return; // Not indexed
+        i = (i + 1) & mask;
+    }
+
+    // Backward-shift deletion: pull later entries of the chain into the hole
+    int hole = i;
+    for (int j = (i + 1) & mask; index->slots[j] != EMPTY_SLOT; j = (j + 1) & mask)
+    {
+        int home = index->hashes[j] & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) // Entry may legally sit in the hole
+        {
+            index->slots[hole] = index->slots[j];
+            index->hashes[hole] = index->hashes[j];
+            hole = j;
+        }
+    }
+    index->slots[hole] = EMPTY_SLOT;
+    index->size--;
+}
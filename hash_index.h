@@ -0,0 +1,27 @@
+#ifndef HASH_INDEX_H        // Header guard start, prevents multiple inclusion
+#define HASH_INDEX_H
+
+struct Address_book;        // Defined in contact.h
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Hash_index           // Open-addressing (linear probing) index from a contact field to contact index
+{
+    int *slots;             // Contact index stored in each slot, -1 when the slot is empty
+    unsigned int *hashes;   // Cached hash of the key stored in each slot
+    int capacity;           // Number of slots (always a power of two, or 0)
+    int size;               // Number of occupied slots
+    const char *(*key)(const struct Address_book *addressbook, int contact); // Indexed field of a contact (contact_mobile, contact_mail)
+};
+
+/*------------------ Function Declarations ------------------*/
+
+void hash_index_init(struct Hash_index *index, const char *(*key)(const struct Address_book *, int)); // Empty index over the field 'key' reads
+void hash_index_free(struct Hash_index *index); // Release all slots
+unsigned int hash_key(const char *key); // FNV-1a hash of a NUL-terminated key
+int hash_index_build(struct Hash_index *index, const struct Address_book *addressbook, int count); // Index contacts 0..count-1, 0 or -1
+int hash_index_find(const struct Hash_index *index, const struct Address_book *addressbook, const char *key); // Contact index or -1
+int hash_index_insert(struct Hash_index *index, const struct Address_book *addressbook, int contact); // Add a contact, 0 or -1
+void hash_index_remove(struct Hash_index *index, const struct Address_book *addressbook, int contact); // Drop the entry of a contact
+
+#endif // HASH_INDEX_H       // End of header guard
@@ -0,0 +1,627 @@
+/*------------------------------------------------------------------------------
+-> File         : loader.c
+-> Description  : Bulk loader for data.txt.
+                  The whole file is mapped into memory (or read in large
+                  blocks when it is a pipe) and split with memchr, which
+                  glibc implements with SIMD, so there is no per-field
+                  fscanf. Names and mail IDs are kept at their own length
+                  (only the mobile number has a fixed field); bad lines are
+                  reported with their line number and skipped. The "#N" header is
+                  only a capacity hint and is checked against what was read.
+
+                  Large files are split at newline boundaries into one chunk
+                  per worker thread (see workers.c for the knob). Each chunk
+                  is parsed into its own records and string arena, and
+                  both are copied into the book in parallel (the arena
+                  offsets moved by where the chunk's strings land), every
+                  new record goes through the
+                  contact rules in one vectorized pass (validate.c), and
+                  repeated mobile numbers or mail IDs are found by hash-partitioning the keys so every
+                  partition is checked on its own thread.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free)
+#include <string.h>     // Include string handling functions (memchr, memcpy, memset)
+#include <unistd.h>     // Include read for non-mappable inputs
+#include <sys/mman.h>   // Include mmap for regular files
+#include <sys/stat.h>   // Include fstat to size the file
+#include <limits.h>     // Include INT_MAX for size checks
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "workers.h"    // Include thread-count knob and fork/join helper
+#include "stats.h"      // Include operation counters
+
+#define READ_BLOCK (1 << 20)    // Bytes requested per read() when the input cannot be mapped
+#define TYPICAL_LINE_LENGTH 40  // Used to size a chunk's first buffer (it grows if lines are shorter)
+#define MAX_REPORTED 20         // Bad lines printed before only counting them
+#define PARALLEL_LOAD_MIN (8 << 20) // Files smaller than this parse on one thread
+#define VALIDATE_BLOCK 256      // Records handed to validate_contacts at a time
+
+/*------------------- Parse Header -------------------*/
+static long parse_header(const char *line, size_t length) // Value of "#N", or -1 if the line is not a valid header
+{
+    if (length < 2 || line[0] != '#')
+        return -1;
+    long value = 0;
+    for (size_t i = 1; i < length; i++)
+    {
+        if (line[i] < '0' || line[i] > '9' || value > 100000000000L) // Digits only, no absurd counts
+            return -1;
+        value = value * 10 + (line[i] - '0');
+    }
+    return value;
+}
+
+/*------------------- Parse One Record -------------------*/
+struct Fields                   // Where the fields of one line are
+{
+    const char *name, *mobile, *mail;
+    size_t name_length, mobile_length, mail_length;
+};
+
+static const char *split_record(const char *line, size_t length, struct Fields *fields) // NULL on success, else the reason
+{
+    const char *end = line + length;
+    const char *comma1 = memchr(line, ',', length); // End of Name
+    if (comma1 == NULL)
+        return "missing ',' after name";
+    const char *mobile = comma1 + 1;
+    const char *comma2 = memchr(mobile, ',', end - mobile); // End of Mobile_number
+    if (comma2 == NULL)
+        return "missing ',' after mobile number";
+    const char *mail = comma2 + 1; // Mail ID runs to the end of the line
+
+    *fields = (struct Fields){ line, mobile, mail, comma1 - line, comma2 - mobile, end - mail };
+    if (fields->name_length == 0 || fields->name_length > TEXT_MAX_LENGTH)
+        return "name empty or longer than 16777215 characters";
+    if (fields->mobile_length == 0 || fields->mobile_length >= sizeof(((struct Contact_record *)0)->Mobile_number))
+        return "mobile number empty or longer than 10 characters";
+    if (fields->mail_length == 0 || fields->mail_length > TEXT_MAX_LENGTH)
+        return "mail ID empty or longer than 16777215 characters";
+    return NULL;
+}
+
+const char *parse_record(char *line, size_t length, struct Contact_data *contact) // NULL on success, else the reason
+{
+    struct Fields fields;
+    const char *reason = split_record(line, length, &fields);
+    if (reason != NULL)
+        return reason;
+    line[fields.name_length] = '\0'; // Each field ends where its comma was
+    line[length] = '\0';
+    memset(contact->Mobile_number, 0, sizeof(contact->Mobile_number));
+    memcpy(contact->Mobile_number, fields.mobile, fields.mobile_length);
+    contact->Name = line;
+    contact->Mail_ID = fields.mail;
+    return NULL;
+}
+
+static const char *parse_line(const char *line, size_t length, struct Contact_record *record,
+                              struct Text_arena *strings) // Same, into a record whose strings go to 'strings'
+{
+    struct Fields fields;
+    const char *reason = split_record(line, length, &fields);
+    if (reason != NULL)
+        return reason;
+    memset(record, 0, sizeof(*record)); // Zero padding keeps saved records byte-identical
+    memcpy(record->Mobile_number, fields.mobile, fields.mobile_length);
+    if (arena_store(strings, &record->name, fields.name, fields.name_length) != 0 ||
+        arena_store(strings, &record->mail, fields.mail, fields.mail_length) != 0)
+        return ""; // Out of memory
+    return NULL;
+}
+
+/*------------------- Parse One Chunk -------------------*/
+struct Bad_line                 // A line that was skipped
+{
+    long line;                  // Line number (chunk-local until merged)
+    const char *reason;         // Why it was skipped
+};
+
+struct Chunk                    // A run of whole lines parsed by one worker into its own buffer
+{
+    const char *begin, *end;    // Bytes of this chunk
+    struct Contact_record *records; // Records parsed so far
+    struct Text_arena strings;  // Their names and mail IDs of 8 characters or more
+    long *lines;                // Line number of each record (chunk-local)
+    int count, capacity;        // Records used / allocated
+    struct Bad_line *bad;       // Skipped lines
+    int bad_count, bad_capacity;
+    long line_count;            // Lines in this chunk
+    int failed;                 // Out of memory
+    struct Contact_record *dest; // Merge: where the records go in the book
+    char *dest_strings;         // Merge: where the strings go in the book's arena
+    uint32_t strings_base;      // Merge: its offset there, added to every arena offset
+    long *dest_lines;           // Merge: where their line numbers go
+    long line_base;             // Merge: lines before this chunk
+};
+
+static int chunk_push_bad(struct Chunk *chunk, long line, const char *reason) // Remember one skipped line
+{
+    if (chunk->bad_count == chunk->bad_capacity)
+    {
+        int capacity = chunk->bad_capacity ? chunk->bad_capacity * 2 : 16;
+        struct Bad_line *bad = realloc(chunk->bad, (size_t)capacity * sizeof(*bad));
+        if (bad == NULL)
+            return -1;
+        chunk->bad = bad;
+        chunk->bad_capacity = capacity;
+    }
+    chunk->bad[chunk->bad_count++] = (struct Bad_line){ line, reason };
+    return 0;
+}
+
+static int chunk_grow(struct Chunk *chunk) // Double the record buffer of a chunk
+{
+    int capacity = chunk->capacity * 2;
+    struct Contact_record *records = realloc(chunk->records, (size_t)capacity * sizeof(struct Contact_record));
+    if (records == NULL)
+        return -1;
+    chunk->records = records;
+    long *lines = realloc(chunk->lines, (size_t)capacity * sizeof(long));
+    if (lines == NULL)
+        return -1;
+    chunk->lines = lines;
+    chunk->capacity = capacity;
+    return 0;
+}
+
+static void *parse_chunk(void *arg) // Worker: parse every line of one chunk
+{
+    struct Chunk *chunk = arg;
+    const char *p = chunk->begin, *end = chunk->end;
+
+    int capacity = (int)((end - p) / TYPICAL_LINE_LENGTH) + 16; // Estimate of records in this chunk
+    chunk->records = malloc((size_t)capacity * sizeof(struct Contact_record));
+    chunk->lines = malloc((size_t)capacity * sizeof(long));
+    chunk->capacity = capacity;
+    if (chunk->records == NULL || chunk->lines == NULL)
+    {
+        chunk->failed = 1;
+        return NULL;
+    }
+
+    while (p < end)
+    {
+        const char *newline = memchr(p, '\n', end - p);
+        const char *line_end = newline ? newline : end;
+        size_t line_length = line_end - p;
+        long line = ++chunk->line_count;
+
+        if (line_length > 0 && p[line_length - 1] == '\r') // Accept CRLF files
+            line_length--;
+        if (line_length > 0) // Skip blank lines
+        {
+            if (chunk->count == chunk->capacity && chunk_grow(chunk) != 0) // Shorter lines than estimated
+            {
+                chunk->failed = 1;
+                return NULL;
+            }
+            const char *reason = parse_line(p, line_length, &chunk->records[chunk->count], &chunk->strings);
+
+            if (reason != NULL && reason[0] == '\0')
+            {
+                chunk->failed = 1;
+                return NULL;
+            }
+            if (reason != NULL)
+            {
+                if (chunk_push_bad(chunk, line, reason) != 0)
+                {
+                    chunk->failed = 1;
+                    return NULL;
+                }
+            }
+            else
+                chunk->lines[chunk->count++] = line;
+        }
+        p = newline ? newline + 1 : end;
+    }
+    return NULL;
+}
+
+static void *copy_chunk(void *arg) // Worker: move one chunk's records and strings into the book
+{
+    struct Chunk *chunk = arg;
+    if (chunk->strings.used > 0)
+        memcpy(chunk->dest_strings, chunk->strings.bytes, chunk->strings.used);
+    for (int i = 0; i < chunk->count; i++)
+    {
+        struct Contact_record record = chunk->records[i];
+        if (record.name.far.tag) // Arena offsets now count from the start of the book's arena
+            record.name.far.offset += chunk->strings_base;
+        if (record.mail.far.tag)
+            record.mail.far.offset += chunk->strings_base;
+        chunk->dest[i] = record;
+        chunk->dest_lines[i] = chunk->line_base + chunk->lines[i];
+    }
+    return NULL;
+}
+
+/*------------------- Duplicate Check -------------------*/
+#define PARTITIONS 256          // Hash partitions checked independently in parallel
+
+struct Key_item                 // One key in a partition
+{
+    unsigned int hash;          // hash_key() of the field
+    int index;                  // Contact index
+};
+
+struct Dup_job                  // Work for one thread of the duplicate check
+{
+    const struct Address_book *addressbook; // Whole book
+    const char *(*key)(const struct Address_book *, int); // Field being checked (contact_mobile, contact_mail)
+    int begin, end;             // Records hashed and scattered by this job
+    int first_new;              // Records below this were already in the book
+    unsigned int *hashes;       // Hash of every record
+    int histogram[PARTITIONS];  // Keys of this job per partition, then its write cursor
+    const int *part_start;      // First item of every partition (PARTITIONS + 1 entries)
+    struct Key_item *items;     // All keys grouped by partition
+    int job, jobs;              // Partitions job, job + jobs, ... are checked by this job
+    unsigned char *duplicate;   // Set to 1 for records to drop
+    int failed;                 // Out of memory: some partitions were left unchecked
+};
+
+static void *hash_keys(void *arg) // Phase 1: hash every key and count keys per partition
+{
+    struct Dup_job *job = arg;
+    memset(job->histogram, 0, sizeof(job->histogram));
+    for (int i = job->begin; i < job->end; i++)
+    {
+        unsigned int hash = hash_key(job->key(job->addressbook, i));
+        job->hashes[i] = hash;
+        job->histogram[hash >> 24]++;
+    }
+    return NULL;
+}
+
+static void *scatter_keys(void *arg) // Phase 2: place keys in their partition, in index order
+{
+    struct Dup_job *job = arg;
+    for (int i = job->begin; i < job->end; i++)
+    {
+        unsigned int hash = job->hashes[i];
+        job->items[job->histogram[hash >> 24]++] = (struct Key_item){ hash, i };
+    }
+    return NULL;
+}
+
+static void *check_partitions(void *arg) // Phase 3: within each partition, a key seen before is a duplicate
+{
+    struct Dup_job *job = arg;
+    int *table = NULL;          // Small open-addressing set, reused for every partition
+    int table_size = 0;
+
+    for (int p = job->job; p < PARTITIONS; p += job->jobs)
+    {
+        const struct Key_item *items = job->items + job->part_start[p];
+        int count = job->part_start[p + 1] - job->part_start[p];
+        int size = 16;
+        while (size < 2 * count) // Load factor <= 1/2
+            size *= 2;
+        if (size > table_size)
+        {
+            free(table);
+            table = malloc((size_t)size * sizeof(int));
+            table_size = table ? size : 0;
+            if (table == NULL)
+            {
+                job->failed = 1; // Out of memory: the load fails rather than keep unchecked keys
+                return NULL;
+            }
+        }
+        memset(table, 0xff, (size_t)size * sizeof(int)); // -1 = empty
+
+        for (int j = 0; j < count; j++) // Items arrive in index order, so the first copy is kept
+        {
+            if (job->duplicate[items[j].index])
+                continue; // Dropped by an earlier pass: it must not make a later record look like a repeat
+            const char *key = job->key(job->addressbook, items[j].index);
+            unsigned int slot = items[j].hash & (size - 1); // Low bits: the top byte picked the partition
+            for (; table[slot] != -1; slot = (slot + 1) & (size - 1))
+            {
+                const struct Key_item *seen = &items[table[slot]];
+                if (seen->hash == items[j].hash &&
+                    strcmp(job->key(job->addressbook, seen->index), key) == 0)
+                    break;
+            }
+            if (table[slot] == -1)
+                table[slot] = j; // First time this key is seen
+            else if (items[j].index >= job->first_new)
+                job->duplicate[items[j].index] = 1; // Repeat of an earlier record
+        }
+    }
+    free(table);
+    return NULL;
+}
+
+static int mark_duplicates(const struct Address_book *addressbook, int first_new, const char *(*key)(const struct Address_book *, int),
+                           unsigned char *duplicate, int threads) // Flag records whose key repeats an earlier kept one, 0 or -1
+{
+    int count = addressbook->contact_count;
+    struct Dup_job *jobs = calloc(threads, sizeof(*jobs));
+    unsigned int *hashes = malloc((size_t)count * sizeof(unsigned int));
+    struct Key_item *items = malloc((size_t)count * sizeof(struct Key_item));
+    int part_start[PARTITIONS + 1];
+    if (jobs == NULL || hashes == NULL || items == NULL)
+    {
+        free(jobs);
+        free(hashes);
+        free(items);
+        return -1;
+    }
+
+    for (int t = 0; t < threads; t++)
+        jobs[t] = (struct Dup_job){ addressbook, key, (int)((long long)count * t / threads),
+                                    (int)((long long)count * (t + 1) / threads), first_new, hashes,
+                                    { 0 }, part_start, items, t, threads, duplicate, 0 };
+    run_workers(hash_keys, jobs, sizeof(*jobs), threads);
+
+    int position = 0; // Partition starts, and a private write cursor per job inside each partition
+    for (int p = 0; p < PARTITIONS; p++)
+    {
+        part_start[p] = position;
+        for (int t = 0; t < threads; t++)
+        {
+            int keys = jobs[t].histogram[p];
+            jobs[t].histogram[p] = position;
+            position += keys;
+        }
+    }
+    part_start[PARTITIONS] = position;
+
+    run_workers(scatter_keys, jobs, sizeof(*jobs), threads);
+    run_workers(check_partitions, jobs, sizeof(*jobs), threads);
+
+    int status = 0;
+    for (int t = 0; t < threads; t++)
+        if (jobs[t].failed)
+            status = -1;
+    free(jobs);
+    free(hashes);
+    free(items);
+    return status;
+}
+
+/*------------------- Parse Buffer -------------------*/
+int parse_contacts(const char *data, size_t length, struct Address_book *addressbook, const char *source) // Append every record, return bad line count or -1
+{
+    const char *p = data, *end = data + length;
+    long header = -1, line_base = 0;
+    int malformed = 0, shown = 0;
+    if (compact_contacts(addressbook) != 0) // New records go after a dense array (duplicate check below)
+        return -1;
+
+    const char *newline = memchr(p, '\n', end - p);
+    const char *first_end = newline ? newline : end;
+    if (p < end && p[0] == '#') // Header: trust it only as a size hint
+    {
+        size_t header_length = first_end - p;
+        if (header_length > 0 && p[header_length - 1] == '\r')
+            header_length--;
+        header = parse_header(p, header_length);
+        if (header < 0)
+        {
+            report_problem("%s:1: bad '#count' header, line skipped\n", source);
+            malformed++;
+            shown++;
+        }
+        p = newline ? newline + 1 : end;
+        line_base = 1;
+    }
+
+    // Split the body into one chunk per thread, each ending just after a newline
+    int threads = length >= PARALLEL_LOAD_MIN ? worker_threads() : 1;
+    struct Chunk *chunks = calloc(threads, sizeof(struct Chunk));
+    if (chunks == NULL)
+        return -1;
+    const char *chunk_begin = p;
+    for (int t = 0; t < threads; t++)
+    {
+        const char *chunk_end = t == threads - 1 ? end : chunk_begin + (end - p) / threads;
+        if (chunk_end < chunk_begin)
+            chunk_end = chunk_begin;
+        if (chunk_end < end)
+        {
+            const char *nl = memchr(chunk_end, '\n', end - chunk_end);
+            chunk_end = nl ? nl + 1 : end;
+        }
+        chunks[t].begin = chunk_begin;
+        chunks[t].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+    run_workers(parse_chunk, chunks, sizeof(struct Chunk), threads);
+
+    // Merge: number the lines, report skipped ones in file order, then copy every chunk into the book
+    int failed = 0;
+    long total = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        failed |= chunks[t].failed;
+        chunks[t].line_base = line_base;
+        for (int b = 0; b < chunks[t].bad_count; b++, malformed++)
+            if (shown++ < MAX_REPORTED)
+                report_problem("%s:%ld: %s, line skipped\n", source, line_base + chunks[t].bad[b].line, chunks[t].bad[b].reason);
+        line_base += chunks[t].line_count;
+        total += chunks[t].count;
+    }
+
+    int first_new = addressbook->contact_count;
+    long *lines = NULL;
+    size_t strings = 0; // Arena bytes of all chunks
+    for (int t = 0; t < threads; t++)
+        strings += chunks[t].strings.used;
+    if (!failed && total > 0)
+    {
+        lines = malloc((size_t)total * sizeof(long));
+        if (lines == NULL || total > INT_MAX - first_new || reserve_strings(addressbook, strings) != 0 ||
+            reserve_contacts(addressbook, first_new + (int)total) != 0)
+            failed = 1;
+    }
+    if (!failed && total > 0)
+    {
+        long at = 0;
+        size_t base = addressbook->strings.used;
+        for (int t = 0; t < threads; t++)
+        {
+            chunks[t].dest = addressbook->contact_details + first_new + at;
+            chunks[t].dest_strings = addressbook->strings.bytes + base;
+            chunks[t].strings_base = (uint32_t)base;
+            chunks[t].dest_lines = lines + at;
+            at += chunks[t].count;
+            base += chunks[t].strings.used;
+        }
+        run_workers(copy_chunk, chunks, sizeof(struct Chunk), threads);
+        addressbook->contact_count = first_new + (int)total;
+        addressbook->strings.used = base;
+    }
+
+    for (int t = 0; t < threads; t++)
+    {
+        free(chunks[t].records);
+        arena_free(&chunks[t].strings);
+        free(chunks[t].lines);
+        free(chunks[t].bad);
+    }
+    free(chunks);
+    if (failed)
+    {
+        free(lines);
+        return -1;
+    }
+
+    // Rules: the same checks as the menu prompts, one vectorized pass over the new records (validate.c)
+    int invalid = 0;
+    if (total > 0)
+    {
+        unsigned char *errors = malloc((size_t)total);
+        if (errors == NULL)
+        {
+            free(lines);
+            return -1;
+        }
+        int rejected = 0;
+        for (int first = 0; first < total; first += VALIDATE_BLOCK) // Views of a block of records at a time
+        {
+            struct Contact_data views[VALIDATE_BLOCK];
+            int count = total - first < VALIDATE_BLOCK ? (int)(total - first) : VALIDATE_BLOCK;
+            for (int k = 0; k < count; k++)
+                get_contact(addressbook, first_new + first + k, &views[k]);
+            rejected += validate_contacts(views, count, errors + first);
+        }
+        if (rejected > 0)
+        {
+            int kept = first_new;
+            for (int i = first_new; i < addressbook->contact_count; i++) // Close the gaps left by invalid records
+            {
+                if (errors[i - first_new] != VALID)
+                {
+                    if (shown++ < MAX_REPORTED)
+                        report_problem("%s:%ld: %s, line skipped\n", source, lines[i - first_new],
+                                validation_message(errors[i - first_new]));
+                    arena_drop(&addressbook->strings, &addressbook->contact_details[i].name);
+                    arena_drop(&addressbook->strings, &addressbook->contact_details[i].mail);
+                    invalid++;
+                    continue;
+                }
+                addressbook->contact_details[kept] = addressbook->contact_details[i];
+                lines[kept - first_new] = lines[i - first_new];
+                kept++;
+            }
+            addressbook->contact_count = kept;
+        }
+        free(errors);
+    }
+
+    // Uniqueness: later records repeating a mobile number or mail ID are dropped
+    int duplicates = 0;
+    if (addressbook->contact_count > first_new)
+    {
+        unsigned char *duplicate = calloc(addressbook->contact_count, 1);
+        if (duplicate == NULL ||
+            mark_duplicates(addressbook, first_new, contact_mobile, duplicate, threads) != 0 ||
+            mark_duplicates(addressbook, first_new, contact_mail, duplicate, threads) != 0)
+        {
+            free(duplicate);
+            free(lines);
+            return -1;
+        }
+
+        int kept = first_new;
+        for (int i = first_new; i < addressbook->contact_count; i++) // Close the gaps left by duplicates
+        {
+            if (duplicate[i])
+            {
+                if (shown++ < MAX_REPORTED)
+                    report_problem("%s:%ld: duplicate mobile number or mail ID, line skipped\n", source, lines[i - first_new]);
+                arena_drop(&addressbook->strings, &addressbook->contact_details[i].name);
+                arena_drop(&addressbook->strings, &addressbook->contact_details[i].mail);
+                duplicates++;
+                continue;
+            }
+            if (kept != i)
+                addressbook->contact_details[kept] = addressbook->contact_details[i];
+            kept++;
+        }
+        addressbook->contact_count = kept;
+        free(duplicate);
+    }
+    free(lines);
+
+    if (shown > MAX_REPORTED)
+        report_problem("%s: %d more bad lines not shown\n", source, shown - MAX_REPORTED);
+    if (header >= 0 && header != total + malformed)
+        report_problem("%s: header says %ld contacts but file has %ld records\n", source, header, total + malformed);
+    return malformed + invalid + duplicates;
+}
+
+/*------------------- Load From File Descriptor -------------------*/
+int load_contacts_fd(int fd, struct Address_book *addressbook, const char *source) // Map or read the whole input, then parse it
+{
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        if (st.st_size == 0)
+            return 0;
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL); // One front-to-back pass
+            stats_add(COUNT_BYTES_READ, (uint64_t)st.st_size);
+            int bad = parse_contacts(map, (size_t)st.st_size, addressbook, source);
+            munmap(map, (size_t)st.st_size);
+            return bad;
+        }
+    }
+
+    // Pipe or mmap failure: read in large blocks into one growing buffer
+    char *buffer = NULL;
+    size_t used = 0, capacity = 0;
+    while (1)
+    {
+        if (capacity - used < READ_BLOCK)
+        {
+            capacity = capacity ? capacity * 2 : 4 * READ_BLOCK;
+            char *grown = realloc(buffer, capacity);
+            if (grown == NULL)
+            {
+                free(buffer);
+                return -1;
+            }
+            buffer = grown;
+        }
+        ssize_t got = read(fd, buffer + used, capacity - used);
+        if (got < 0)
+        {
+            free(buffer);
+            return -1;
+        }
+        if (got == 0)
+            break;
+        used += (size_t)got;
+    }
+
+    stats_add(COUNT_BYTES_READ, used);
+    int bad = parse_contacts(buffer, used, addressbook, source);
+    free(buffer);
+    return bad;
+}
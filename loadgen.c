@@ -0,0 +1,376 @@
+/*------------------------------------------------------------------------------
+-> File         : loadgen.c
+-> Description  : Load generator for the query server (server.c).
+                  Adds N contacts of its own, then runs C client threads
+                  for S seconds. Each thread has one connection and sends
+                  batches of D pipelined requests (lookups by mobile,
+                  mail and name prefix, plus the given share of edits),
+                  then reads the D replies. Every request's latency runs
+                  from sending its batch to reading its reply. Prints the
+                  throughput and the p50 / p99 / p99.9 / max latency, then
+                  deletes its contacts again.
+
+-> Build        : make loadgen
+-> Usage        : ./addressbook serve &
+                  ./loadgen [--socket PATH] [--connections C] [--depth D] [--seconds S]
+                            [--contacts N] [--writes PERCENT] [--keep]
+                  (defaults: addressbook.sock, 4, 16, 5, 10000, 0)
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (printf, snprintf)
+#include <stdlib.h>     // Include standard library functions (atol, qsort, realloc)
+#include <string.h>     // Include string handling functions (memchr, strcmp)
+#include <errno.h>      // Include errno for EINTR
+#include <pthread.h>    // Include the client threads
+#include <time.h>       // Include clock_gettime for latencies
+#include <unistd.h>     // Include read, write, close
+#include <sys/socket.h> // Include socket, connect
+#include <sys/un.h>     // Include struct sockaddr_un
+#include "contact.h"    // Include SOCKET_FILE
+
+#define MAX_DEPTH 1024          // Most requests in flight per connection
+#define SETUP_BATCH 256         // Adds / deletes pipelined per round trip while setting up
+
+struct Client                   // One connection and its reply buffer
+{
+    int fd;
+    char in[65536];
+    size_t start, end;          // Unread bytes are in[start .. end)
+};
+
+struct Worker                   // One load thread and what it measured
+{
+    pthread_t thread;
+    const char *socket_path;
+    int id, depth, writes;
+    long contacts;
+    double deadline;
+    float *latencies;           // Microseconds, one per request
+    long count, capacity;
+    long errors;                // ERR replies
+    int started;                // Thread was created
+    int failed;                 // Connection broke
+};
+
+static double now_seconds(void) // Monotonic wall clock in seconds
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*------------------- Connection -------------------*/
+static int connect_to(struct Client *client, const char *socket_path) // 0 or -1
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, socket_path);
+    client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    client->start = client->end = 0;
+    if (client->fd < 0)
+        return -1;
+    if (connect(client->fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(client->fd);
+        client->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static int send_all(struct Client *client, const char *data, size_t length) // 0 or -1
+{
+    while (length > 0)
+    {
+        ssize_t sent = write(client->fd, data, length);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return -1;
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+static char *read_line(struct Client *client) // Next reply line without its newline, NULL if the server went away
+{
+    for (;;)
+    {
+        char *newline = memchr(client->in + client->start, '\n', client->end - client->start);
+        if (newline != NULL)
+        {
+            char *line = client->in + client->start;
+            *newline = '\0';
+            client->start = (size_t)(newline - client->in) + 1;
+            return line;
+        }
+        memmove(client->in, client->in + client->start, client->end - client->start); // Keep the partial line
+        client->end -= client->start;
+        client->start = 0;
+        if (client->end == sizeof(client->in))
+            return NULL;
+        ssize_t got = read(client->fd, client->in + client->end, sizeof(client->in) - client->end);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return NULL;
+        client->end += (size_t)got;
+    }
+}
+
+static int read_reply(struct Client *client) // One whole reply: 0 for OK, 1 for ERR, -1 if the server went away
+{
+    char *line = read_line(client);
+    if (line == NULL)
+        return -1;
+    if (strncmp(line, "OK ", 3) != 0)
+        return 1;
+    for (long n = atol(line + 3); n > 0; n--) // Skip the contact lines
+        if (read_line(client) == NULL)
+            return -1;
+    return 0;
+}
+
+/*------------------- Requests -------------------*/
+static void make_name(char *name, size_t size, long i) // Unique alphabetic name for contact i
+{
+    char letters[8];
+    for (int k = 6; k >= 0; k--) // Spell the number in base 26
+    {
+        letters[k] = 'a' + i % 26;
+        i /= 26;
+    }
+    letters[7] = '\0';
+    snprintf(name, size, "Load %s", letters);
+}
+
+static int make_request(char *out, size_t size, long i, int kind, int flip) // Request line about contact i, its length
+{
+    char name[32];
+    long mobile = 7000000000L + i;
+    switch (kind)
+    {
+        case 'A':
+            make_name(name, sizeof(name), i);
+            return snprintf(out, size, "A %s,%010ld,loadgen%07ld@bench.com\n", name, mobile, i);
+        case 'U': // Same keys, the name toggles between two spellings
+            make_name(name, sizeof(name), i);
+            return snprintf(out, size, "U %010ld %s%s,%010ld,loadgen%07ld@bench.com\n",
+                            mobile, name, flip ? "x" : "", mobile, i);
+        case 'D':
+            return snprintf(out, size, "D %010ld\n", mobile);
+        case 'E':
+            return snprintf(out, size, "E loadgen%07ld@bench.com\n", i);
+        case 'P':
+            make_name(name, sizeof(name), i);
+            name[9] = '\0'; // "Load " and the first four letters
+            return snprintf(out, size, "P %s\n", name);
+    }
+    return snprintf(out, size, "M %010ld\n", mobile);
+}
+
+static long run_setup(const char *socket_path, int kind, long contacts) // Add or delete every contact, ERR replies counted, -1 on failure
+{
+    struct Client *client = malloc(sizeof(*client));
+    char *batch = malloc(SETUP_BATCH * 128);
+    long errors = 0;
+    if (client != NULL)
+        client->fd = -1;
+    if (client == NULL || batch == NULL || connect_to(client, socket_path) != 0)
+        errors = -1;
+    for (long i = 0; errors >= 0 && i < contacts; i += SETUP_BATCH)
+    {
+        long n = contacts - i < SETUP_BATCH ? contacts - i : SETUP_BATCH;
+        size_t length = 0;
+        for (long k = 0; k < n; k++)
+            length += (size_t)make_request(batch + length, 128, i + k, kind, 0);
+        if (send_all(client, batch, length) != 0)
+            errors = -1;
+        for (long k = 0; errors >= 0 && k < n; k++)
+        {
+            int reply = read_reply(client);
+            errors = reply < 0 ? -1 : errors + reply;
+        }
+    }
+    if (client != NULL && client->fd >= 0)
+        close(client->fd);
+    free(client);
+    free(batch);
+    return errors;
+}
+
+/*------------------- Load Threads -------------------*/
+static unsigned long next_random(unsigned long *state) // xorshift64
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void *run_worker(void *argument) // Pipelined batches until the deadline
+{
+    struct Worker *worker = argument;
+    struct Client *client = malloc(sizeof(*client));
+    char *batch = malloc((size_t)worker->depth * 128);
+    if (client == NULL || batch == NULL || connect_to(client, worker->socket_path) != 0)
+    {
+        worker->failed = 1;
+        free(client);
+        free(batch);
+        return NULL;
+    }
+    unsigned long state = 0x9e3779b97f4a7c15UL * (unsigned long)(worker->id + 1);
+    while (!worker->failed && now_seconds() < worker->deadline)
+    {
+        size_t length = 0;
+        for (int k = 0; k < worker->depth; k++)
+        {
+            unsigned long r = next_random(&state);
+            long i = (long)((r >> 8) % (unsigned long)worker->contacts);
+            int roll = (int)(r % 100);
+            int kind = roll < worker->writes ? 'U' : roll % 10 < 6 ? 'M' : roll % 10 < 9 ? 'E' : 'P';
+            length += (size_t)make_request(batch + length, 128, i, kind, (int)(r >> 40) & 1);
+        }
+        if (worker->count + worker->depth > worker->capacity)
+        {
+            long capacity = worker->capacity ? worker->capacity * 2 : 65536;
+            float *latencies = realloc(worker->latencies, (size_t)capacity * sizeof(float));
+            if (latencies == NULL)
+                break;
+            worker->latencies = latencies;
+            worker->capacity = capacity;
+        }
+        double sent = now_seconds();
+        if (send_all(client, batch, length) != 0)
+            worker->failed = 1;
+        for (int k = 0; !worker->failed && k < worker->depth; k++)
+        {
+            int reply = read_reply(client);
+            if (reply < 0)
+                worker->failed = 1;
+            worker->errors += reply > 0;
+            worker->latencies[worker->count++] = (float)((now_seconds() - sent) * 1e6);
+        }
+    }
+    close(client->fd);
+    free(client);
+    free(batch);
+    return NULL;
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static float percentile(const float *sorted, long count, double p) // Nearest-rank percentile
+{
+    long rank = (long)(p / 100.0 * (double)count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *socket_path = SOCKET_FILE;
+    int connections = 4, depth = 16, writes = 0, keep = 0;
+    double seconds = 5;
+    long contacts = 10000;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--keep") == 0)
+            keep = 1;
+        else if (value != NULL && strcmp(argv[i], "--socket") == 0)
+            socket_path = argv[++i];
+        else if (value != NULL && strcmp(argv[i], "--connections") == 0)
+            connections = atoi(argv[++i]);
+        else if (value != NULL && strcmp(argv[i], "--depth") == 0)
+            depth = atoi(argv[++i]);
+        else if (value != NULL && strcmp(argv[i], "--seconds") == 0)
+            seconds = atof(argv[++i]);
+        else if (value != NULL && strcmp(argv[i], "--contacts") == 0)
+            contacts = atol(argv[++i]);
+        else if (value != NULL && strcmp(argv[i], "--writes") == 0)
+            writes = atoi(argv[++i]);
+        else
+            connections = 0; // Reported below
+    }
+    if (connections <= 0 || depth <= 0 || depth > MAX_DEPTH || seconds <= 0 ||
+        contacts <= 0 || contacts > 1000000000L || writes < 0 || writes > 100)
+    {
+        printf("Usage: %s [--socket PATH] [--connections C] [--depth D (1-%d)] [--seconds S]\n"
+               "       [--contacts N] [--writes PERCENT] [--keep]\n", argv[0], MAX_DEPTH);
+        return 1;
+    }
+
+    double start = now_seconds();
+    long errors = run_setup(socket_path, 'A', contacts);
+    if (errors < 0)
+    {
+        printf("Error: could not talk to the server on %s\n", socket_path);
+        return 1;
+    }
+    printf("setup: %ld contacts added in %.3f s (%ld already there)\n",
+           contacts - errors, now_seconds() - start, errors);
+
+    struct Worker *workers = calloc((size_t)connections, sizeof(*workers));
+    if (workers == NULL)
+    {
+        printf("Error: not enough memory\n");
+        return 1;
+    }
+    start = now_seconds();
+    for (int t = 0; t < connections; t++)
+    {
+        workers[t] = (struct Worker){ .socket_path = socket_path, .id = t, .depth = depth, .writes = writes,
+                                      .contacts = contacts, .deadline = start + seconds };
+        workers[t].started = pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]) == 0;
+        workers[t].failed = !workers[t].started;
+    }
+    long total = 0, failures = 0;
+    errors = 0;
+    for (int t = 0; t < connections; t++)
+    {
+        if (workers[t].started)
+            pthread_join(workers[t].thread, NULL);
+        total += workers[t].count;
+        errors += workers[t].errors;
+        failures += workers[t].failed;
+    }
+    double elapsed = now_seconds() - start;
+
+    float *all = malloc((size_t)(total > 0 ? total : 1) * sizeof(float));
+    if (all == NULL)
+    {
+        printf("Error: not enough memory\n");
+        return 1;
+    }
+    for (long t = 0, n = 0; t < connections; t++)
+    {
+        memcpy(all + n, workers[t].latencies, (size_t)workers[t].count * sizeof(float));
+        n += workers[t].count;
+        free(workers[t].latencies);
+    }
+    qsort(all, (size_t)total, sizeof(float), compare_floats);
+    printf("load: %d connections x depth %d, %d%% writes: %ld requests in %.3f s = %.0f req/s, %ld errors, %ld broken connections\n",
+           connections, depth, writes, total, elapsed, elapsed > 0 ? total / elapsed : 0.0, errors, failures);
+    if (total > 0)
+        printf("latency (us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               percentile(all, total, 50), percentile(all, total, 99), percentile(all, total, 99.9), all[total - 1]);
+    free(all);
+    free(workers);
+
+    if (!keep && run_setup(socket_path, 'D', contacts) < 0)
+    {
+        printf("Error: could not delete the load contacts\n");
+        return 1;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -1,22 +1,288 @@
 #include <stdio.h>      // Include standard input/output functions
 #include <string.h>     // Include string handling functions
+#include <stdlib.h>     // Include atol for list offsets
+#include <unistd.h>     // Include STDOUT_FILENO for list output
+#include <time.h>       // Include clock_gettime to time the shard commands
 #include "contact.h"    // Include user-defined header for contact structure and functions
+#include "addressbook.h" // Include the library interface the program is a client of
+#include "render.h"     // Include list formats
+#include "merge.h"      // Include merge policies
+#include "shard.h"      // Include sharded books
 
-int main()
+#define SHARD_SEARCH_LIMIT 20 // Matches 'shards DIR search' prints
+
+/* 'stats': ask the server on 'socket_path'; with none running, show its last dump. 0 or 1 */
+static int show_stats(const char *socket_path)
+{
+    if (print_server_stats(socket_path) == 0)
+        return 0;
+    FILE *fp = fopen(STATS_FILE, "r");
+    if (fp == NULL)
+    {
+        printf("Error: no server on %s and no %s\n", socket_path, STATS_FILE);
+        return 1;
+    }
+    printf("No server on %s, last dump in %s:\n", socket_path, STATS_FILE);
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL)
+        fputs(line, stdout);
+    fclose(fp);
+    return 0;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 'shard N DIR': write the open book as a sharded book, 0 or 1 */
+static int split_book(struct Address_book *addressbook, const char *directory, int shards, int scheme)
+{
+    double start = now_seconds();
+    int status = sharded_split(addressbook, directory, shards, scheme); // Shards written in parallel
+    if (status != ADDRESSBOOK_OK)
+    {
+        printf("Error: could not split the book into %s: %s\n", directory, addressbook_message(status));
+        return 1;
+    }
+    printf("shard: %d contacts into %d shards by %s in %s; %.3f s\n", addressbook_count(addressbook), shards,
+           scheme == SHARD_BY_NAME ? "name" : "mobile", directory, now_seconds() - start);
+    return 0;
+}
+
+/* 'shards DIR [search TEXT | save]': open a sharded book, report its shards, search or save it, 0 or 1 */
+static int open_shards(const char *directory, const char *text, int save)
+{
+    int error;
+    double start = now_seconds();
+    struct Sharded_book *book = sharded_open(directory, &error); // Shards opened in parallel
+    if (book == NULL)
+    {
+        printf("Error: could not open the sharded book in %s: %s\n", directory, addressbook_message(error));
+        return 1;
+    }
+    int counts[SHARDS_MAX];
+    int shards = sharded_shards(book, counts);
+    printf("shards: %d contacts in %d shards (", sharded_count(book), shards);
+    for (int i = 0; i < shards; i++)
+        printf(i ? " %d" : "%d", counts[i]);
+    printf("), opened in %.3f s\n", now_seconds() - start);
+
+    int status = ADDRESSBOOK_OK;
+    if (text != NULL)                   // Fanned out to every shard, merged best first
+    {
+        struct Contact_data found[SHARD_SEARCH_LIMIT];
+        int total;
+        int shown = sharded_query(book, text, 0, SHARD_SEARCH_LIMIT, found, &total);
+        status = shown < 0 ? shown : ADDRESSBOOK_OK;
+        if (shown >= 0)
+        {
+            struct Renderer renderer;
+            render_begin(&renderer, STDOUT_FILENO, render_default_format(STDOUT_FILENO), shown);
+            for (int k = 0; k < shown; k++)
+                render_contact(&renderer, k + 1, &found[k]);
+            render_end(&renderer);
+            printf("%d of %d matches\n", shown, total);
+        }
+    }
+    if (save)                           // Every shard compacted and snapshotted at once
+    {
+        start = now_seconds();
+        status = sharded_save(book);
+        if (status == ADDRESSBOOK_OK)
+            printf("saved %d shards in %.3f s\n", shards, now_seconds() - start);
+    }
+    if (status != ADDRESSBOOK_OK)
+        printf("Error: %s\n", addressbook_message(status));
+    if (sharded_close(book) != ADDRESSBOOK_OK && status == ADDRESSBOOK_OK)
+    {
+        printf("Error: could not save the shards in %s\n", directory);
+        status = ADDRESSBOOK_IO_ERROR;
+    }
+    return status == ADDRESSBOOK_OK ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
 {
     /* Variable and structure definition */
     int option;                         // Variable to store user menu choice
-    struct Address_book addressbook;    // Define a structure variable for storing contacts
-    addressbook.contact_count = 0;      // Initialize number of contacts to zero
+    struct Address_book *addressbook;   // The open book (addressbook.c)
+    addressbook_set_diagnostics(stderr); // Show skipped lines and change log trouble
 
-    /* Load contacts from file if available */
-    FILE *fp = fopen("data.txt", "r");  // Open file "data.txt" in read mode
-    if (fp == NULL)                     // Check if file does not open
+    /* Optional text import / export, or a batch command */
+    const char *import_path = NULL, *export_path = NULL;
+    const char *command = NULL, *batch_path = NULL;   // Batch mode (batch.c)
+    const char *socket_path = NULL;                   // Server mode (server.c)
+    int stats = 0;                                    // Statistics of a running server (stats.c)
+    const char *merge_path = NULL;                    // Merge mode (merge.c)
+    int policy = MERGE_SKIP;
+    const char *split_directory = NULL;               // Split mode (shard.c)
+    int shards = 0, scheme = SHARD_BY_MOBILE;
+    const char *sharded_directory = NULL, *sharded_text = NULL; // Sharded book mode (shard.c)
+    int sharded_saving = 0;
+    int list = 0, format = render_default_format(STDOUT_FILENO); // List mode (render.c)
+    long offset = 0, limit = -1;
+    int print = 0;
+    if (argc >= 2 && (strcmp(argv[1], "import") == 0 || strcmp(argv[1], "delete") == 0 ||
+                      strcmp(argv[1], "query") == 0 || strcmp(argv[1], "batch") == 0))
+    {
+        command = argv[1];
+        for (int i = 2; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+                batch_path = argv[++i];
+            else if (strcmp(argv[i], "--print") == 0)
+                print = 1;
+            else
+                command = NULL;
+        }
+    }
+    else if ((argc == 2 || (argc == 4 && strcmp(argv[2], "--socket") == 0)) && strcmp(argv[1], "serve") == 0)
+        socket_path = argc == 4 ? argv[3] : SOCKET_FILE;
+    else if ((argc == 2 || (argc == 4 && strcmp(argv[2], "--socket") == 0)) && strcmp(argv[1], "stats") == 0)
     {
-        printf("Error: could not open file\n");  // Print error message
+        stats = 1;
+        socket_path = argc == 4 ? argv[3] : SOCKET_FILE;
+    }
+    else if (argc >= 2 && strcmp(argv[1], "list") == 0)
+    {
+        list = 1;
+        for (int i = 2; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+                format = render_format(argv[++i]);
+            else if (strcmp(argv[i], "--offset") == 0 && i + 1 < argc)
+                offset = atol(argv[++i]);
+            else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
+                limit = atol(argv[++i]);
+            else
+                list = 0;
+        }
+        if (format < 0 || offset < 0)
+            list = 0;
+    }
+    else if (argc >= 3 && strcmp(argv[1], "merge") == 0)
+    {
+        merge_path = argv[2];
+        for (int i = 3; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--on-conflict") == 0 && i + 1 < argc)
+                policy = merge_policy(argv[++i]);
+            else
+                merge_path = NULL;
+        }
+        if (policy < 0)
+            merge_path = NULL;
+    }
+    else if (argc >= 4 && strcmp(argv[1], "shard") == 0)
+    {
+        shards = atoi(argv[2]);
+        split_directory = argv[argc - 1];
+        for (int i = 3; i < argc - 1; i++)
+        {
+            if (strcmp(argv[i], "--by") == 0 && i + 1 < argc - 1)
+                scheme = shard_scheme(argv[++i]);
+            else
+                split_directory = NULL;
+        }
+        if (shards < 1 || shards > SHARDS_MAX || scheme < 0)
+            split_directory = NULL;
+    }
+    else if (argc >= 3 && strcmp(argv[1], "shards") == 0)
+    {
+        sharded_directory = argv[2];
+        if (argc == 5 && strcmp(argv[3], "search") == 0)
+            sharded_text = argv[4];
+        else if (argc == 4 && strcmp(argv[3], "save") == 0)
+            sharded_saving = 1;
+        else if (argc != 3)
+            sharded_directory = NULL;
+    }
+    else if (argc == 3 && strcmp(argv[1], "--import") == 0)
+        import_path = argv[2];
+    else if (argc == 3 && strcmp(argv[1], "--export") == 0)
+        export_path = argv[2];
+    if (argc != 1 && command == NULL && import_path == NULL && export_path == NULL && socket_path == NULL && !list &&
+        merge_path == NULL && split_directory == NULL && sharded_directory == NULL)
+    {
+        printf("Usage: %s [--import FILE | --export FILE]\n"
+               "       %s import|delete|query|batch [--file FILE] [--print]\n"
+               "       %s list [--format table|tsv|csv] [--offset N] [--limit N]\n"
+               "       %s merge FILE [--on-conflict skip|overwrite|report]\n"
+               "       %s shard N [--by mobile|name] DIR\n"
+               "       %s shards DIR [search TEXT | save]\n"
+               "       %s serve|stats [--socket PATH]\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    if (stats)                          // Nothing to load: the server has the book
+        return show_stats(socket_path);
+    if (sharded_directory != NULL)      // The shards are books of their own
+        return open_shards(sharded_directory, sharded_text, sharded_saving);
+
+    /* Map data.snap or import data.txt, then redo and keep logging changes (data.wal) */
+    int error;
+    addressbook = addressbook_open(".", import_path, &error);
+    if (addressbook == NULL)
+    {
+        printf("Error: could not open the address book: %s\n", addressbook_message(error));
         return 1;                                // Exit program with error code
     }
-    load_contact(fp, &addressbook);     // Load contacts from file into addressbook
+
+    if (export_path != NULL)            // Write the book as text and stop
+    {
+        int status = export_contacts(addressbook, export_path);
+        if (status != 0)
+            printf("Error: could not write %s\n", export_path);
+        addressbook_close(addressbook);  // Also closes the change log
+        return status == 0 ? 0 : 1;
+    }
+
+    if (list)                           // Stream the book in name order and stop
+    {
+        long rows = render_list(addressbook, STDOUT_FILENO, format, offset, limit);
+        addressbook_close(addressbook);
+        return rows < 0 ? 1 : 0;
+    }
+
+    if (command != NULL)                // Run the stream with no prompts, then stop
+    {
+        FILE *in = batch_path && strcmp(batch_path, "-") != 0 ? fopen(batch_path, "r") : stdin;
+        if (in == NULL)
+        {
+            printf("Error: could not open %s\n", batch_path);
+            addressbook_close(addressbook);
+            return 1;
+        }
+        int status = run_batch(addressbook, command, in, in == stdin ? "stdin" : batch_path, print);
+        if (in != stdin)
+            fclose(in);
+        addressbook_close(addressbook);  // Commits the change log
+        return status == 0 ? 0 : 1;
+    }
+
+    if (split_directory != NULL)        // Write the book as shards and stop
+    {
+        int status = split_book(addressbook, split_directory, shards, scheme);
+        addressbook_close(addressbook);
+        return status;
+    }
+
+    if (merge_path != NULL)             // Fold another contact file in and stop
+    {
+        int status = run_merge(addressbook, merge_path, policy);
+        if (addressbook_close(addressbook) != ADDRESSBOOK_OK) // Commits the change log
+            status = -1;
+        return status == 0 ? 0 : 1;
+    }
+
+    if (socket_path != NULL)            // Answer socket requests until stopped
+    {
+        int status = run_server(addressbook, socket_path);
+        addressbook_close(addressbook);  // Commits the change log
+        return status == 0 ? 0 : 1;
+    }
 
     while (1)                           // Infinite loop for menu until user exits
     {
@@ -38,29 +304,30 @@ int main()
         switch (option)                   // Check user's choice
         {
             case 1:
-                create_contact(&addressbook); // Call function to add new contact(s)
+                create_contact(addressbook); // Call function to add new contact(s)
                 break;
 
             case 2:
-                edit_contact(&addressbook);   // Call function to edit existing contact
+                edit_contact(addressbook);   // Call function to edit existing contact
                 break;
 
             case 3:
-                delete_contact(&addressbook); // Call function to delete contact(s)
+                delete_contact(addressbook); // Call function to delete contact(s)
                 break;
 
             case 4:
-                search_contacts(&addressbook); // Call function to search contact
+                search_contacts(addressbook); // Call function to search contact
                 break;
 
             case 5:
                 printf("\nList of contacts:\n");
-                list_contacts(&addressbook);    // Call function to display all contacts
+                list_contacts(addressbook);    // Call function to display all contacts
                 break;
 
             case 6:
                 printf("\nSaving contacts and exiting...\n");
-                save_contacts(&addressbook);    // Call function to save contacts to file
+                save_contacts(addressbook);    // Call function to save contacts to file
+                addressbook_close(addressbook); // Release contact storage
                 return 0;                       // Exit program successfully
 
             default:
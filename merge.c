@@ -0,0 +1,267 @@
+/*------------------------------------------------------------------------------
+-> File         : merge.c
+-> Description  : Merge a second contact file (a vendor export, say) into
+                  the book, in time linear in both.
+
+                  The input goes through the bulk loader into a book of its
+                  own, so it is parsed on every thread, checked against the
+                  contact rules, and lines repeating an earlier line's
+                  mobile number or mail ID are dropped (hash-partitioned,
+                  loader.c). Every remaining record then looks its mobile
+                  and mail up in the book's hash indexes, in parallel:
+                  O(1) each, so the book is never scanned.
+
+                  A record whose keys belong to no contact is new. One
+                  whose keys belong to a contact with other fields is a
+                  conflict, handled by the policy: skip it, overwrite the
+                  contact, or list it on the report stream as
+                  "incoming<TAB>book contact" (two book contacts when its
+                  mobile and mail belong to different ones; those are
+                  never overwritten). Each book contact is overwritten at
+                  most once, so uniqueness holds whatever the input.
+
+                  A few new contacts are inserted and logged one by one. A
+                  large batch (MERGE_BULK_FRACTION of the book) is appended
+                  unindexed, merged into the name order in one pass (the
+                  input was sorted on its own), indexed in one pass, and
+                  saved as a fresh snapshot (wal_checkpoint) instead of a
+                  log record each; a crash before that keeps none of them.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (fprintf, printf)
+#include <stdlib.h>     // Include memory functions (malloc, calloc, free)
+#include <string.h>     // Include string handling functions (strcmp, memset)
+#include <strings.h>    // Include strcasecmp for names in any case
+#include <limits.h>     // Include INT_MAX for size checks
+#include <fcntl.h>      // Include open
+#include <unistd.h>     // Include close, STDIN_FILENO
+#include <time.h>       // Include clock_gettime for the summary
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "merge.h"      // Include merge declarations
+#include "workers.h"    // Include the thread-count knob and fork/join helper
+
+#define MATCH_NEW 0         // Neither key is in the book
+#define MATCH_SAME 1        // The book has this exact contact
+#define MATCH_CONFLICT 2    // One book contact has the mobile, the mail or both, with other fields
+#define MATCH_CROSS 3       // Mobile and mail belong to two different book contacts
+
+struct Match_job                // Incoming records looked up by one thread
+{
+    const struct Address_book *addressbook;
+    const struct Address_book *incoming;
+    int begin, end;             // Records [begin, end) of 'incoming'
+    unsigned char *kind;        // MATCH_NEW ... per record
+    int *target;                // Book contact with its mobile (else its mail), -1 if none
+};
+
+/*------------------- Policy -------------------*/
+int merge_policy(const char *name)
+{
+    if (strcmp(name, "skip") == 0)
+        return MERGE_SKIP;
+    if (strcmp(name, "overwrite") == 0)
+        return MERGE_OVERWRITE;
+    if (strcmp(name, "report") == 0)
+        return MERGE_REPORT;
+    return -1;
+}
+
+/*------------------- Match Against the Book -------------------*/
+static int same_contact(const struct Address_book *addressbook, int contact, const struct Contact_data *record)
+{
+    return strcmp(contact_name(addressbook, contact), record->Name) == 0 &&
+           strcmp(contact_mobile(addressbook, contact), record->Mobile_number) == 0 &&
+           strcmp(contact_mail(addressbook, contact), record->Mail_ID) == 0;
+}
+
+static void *match_records(void *arg) // Worker: two hash lookups per record, the book is only read
+{
+    struct Match_job *job = arg;
+    for (int i = job->begin; i < job->end; i++)
+    {
+        struct Contact_data record;
+        get_contact(job->incoming, i, &record);
+        int mobile_owner = find_by_mobile(job->addressbook, record.Mobile_number);
+        int mail_owner = find_by_mail(job->addressbook, record.Mail_ID);
+        int target = mobile_owner != -1 ? mobile_owner : mail_owner;
+        job->target[i] = target;
+        if (target == -1)
+            job->kind[i] = MATCH_NEW;
+        else if (mobile_owner != -1 && mail_owner != -1 && mobile_owner != mail_owner)
+            job->kind[i] = MATCH_CROSS;
+        else
+            job->kind[i] = same_contact(job->addressbook, target, &record) ? MATCH_SAME : MATCH_CONFLICT;
+    }
+    return NULL;
+}
+
+static void match_all(const struct Address_book *addressbook, const struct Address_book *incoming,
+                      unsigned char *kind, int *target)
+{
+    int count = incoming->contact_count;
+    int threads = count >= PARALLEL_MERGE_MIN ? worker_threads() : 1;
+    struct Match_job jobs[MAX_WORKERS];
+    for (int t = 0; t < threads; t++)
+        jobs[t] = (struct Match_job){ addressbook, incoming, (int)((long long)count * t / threads),
+                                      (int)((long long)count * (t + 1) / threads), kind, target };
+    run_workers(match_records, jobs, sizeof(jobs[0]), threads);
+}
+
+static void report_conflict(FILE *report, const struct Address_book *addressbook, const struct Contact_data *record,
+                            int kind, int target) // "incoming<TAB>book contact[<TAB>book contact]"
+{
+    struct Contact_data owner;
+    get_contact(addressbook, target, &owner);
+    fprintf(report, "%s,%s,%s\t%s,%s,%s", record->Name, record->Mobile_number, record->Mail_ID,
+            owner.Name, owner.Mobile_number, owner.Mail_ID);
+    if (kind == MATCH_CROSS) // Mail owner too
+    {
+        get_contact(addressbook, find_by_mail(addressbook, record->Mail_ID), &owner);
+        fprintf(report, "\t%s,%s,%s", owner.Name, owner.Mobile_number, owner.Mail_ID);
+    }
+    fputc('\n', report);
+}
+
+/*------------------- Bulk Append -------------------*/
+static int append_in_bulk(struct Address_book *addressbook, const struct Address_book *incoming,
+                          const unsigned char *kind, int added) // New records (in name order) joined to the book, indexed in one pass, 0 or -1
+{
+    int first_new = addressbook->contact_count; // No tombstones: the book was compacted
+    if (first_new > INT_MAX - added || reserve_contacts(addressbook, first_new + added) != 0 ||
+        reserve_strings(addressbook, incoming->strings.used) != 0)
+        return -1;
+    int *order = malloc((size_t)(first_new + added) * sizeof(int));
+    if (order == NULL)
+        return -1;
+    for (int i = 0; i < incoming->contact_count; i++)
+        if (kind[i] == MATCH_NEW)
+        {
+            struct Contact_data record;
+            get_contact(incoming, i, &record);
+            append_contact(addressbook, &record); // Room reserved above
+        }
+
+    // Merge the name index walk with the new records; on equal names the lower contact index goes first
+    int total = addressbook->contact_count, k = 0;
+    int old = first_contact(addressbook), fresh = first_new;
+    while (old != -1 || fresh < total)
+    {
+        if (fresh == total ||
+            (old != -1 && strcasecmp(contact_name(addressbook, old), contact_name(addressbook, fresh)) <= 0))
+        {
+            order[k++] = old;
+            old = next_contact(addressbook, old);
+        }
+        else
+            order[k++] = fresh++;
+    }
+    int status = rebuild_indexes_in_order(addressbook, order); // O(n) for a sorted order
+    free(order);
+    return status;
+}
+
+/*------------------- Merge -------------------*/
+int merge_contacts(struct Address_book *addressbook, int fd, const char *source, int policy, FILE *report,
+                   struct Merge_result *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (compact_contacts(addressbook) != 0) // Contact numbers stay put from here on
+        return -1;
+
+    struct Address_book incoming;
+    init_address_book(&incoming);
+    int bad = load_contacts_fd(fd, &incoming, source); // Parsed, checked, repeats dropped and reported
+    if (bad < 0)
+    {
+        destroy_address_book(&incoming);
+        return -1;
+    }
+    result->bad = bad;
+    sort_contacts_by_name(&incoming); // So new contacts join the name order in one merge pass
+
+    int count = incoming.contact_count;
+    unsigned char *kind = malloc((size_t)(count ? count : 1));
+    int *target = malloc((size_t)(count ? count : 1) * sizeof(int));
+    unsigned char *claimed = calloc((size_t)(addressbook->contact_count ? addressbook->contact_count : 1), 1);
+    if (kind == NULL || target == NULL || claimed == NULL)
+    {
+        free(kind);
+        free(target);
+        free(claimed);
+        destroy_address_book(&incoming);
+        return -1;
+    }
+    match_all(addressbook, &incoming, kind, target);
+
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) // Known contacts first: no new one shares their keys
+    {
+        struct Contact_data record;
+        get_contact(&incoming, i, &record);
+        if (kind[i] == MATCH_NEW)
+            result->added++;
+        else if (kind[i] == MATCH_SAME)
+            result->unchanged++;
+        else if (policy == MERGE_OVERWRITE && kind[i] == MATCH_CONFLICT && !claimed[target[i]])
+        {
+            claimed[target[i]] = 1; // A second record for the same contact is a conflict
+            status = update_contact(addressbook, target[i], &record);
+            result->overwritten++;
+        }
+        else
+        {
+            result->conflicts++;
+            if (policy == MERGE_REPORT && report != NULL)
+                report_conflict(report, addressbook, &record, kind[i], target[i]);
+        }
+    }
+
+    int added = (int)result->added;
+    if (status == 0 && added >= MERGE_BULK_MIN && (long)added * MERGE_BULK_FRACTION >= addressbook->contact_count)
+    {
+        status = append_in_bulk(addressbook, &incoming, kind, added);
+        if (status == 0 && addressbook->wal != NULL && wal_checkpoint(addressbook) != 0) // Nothing above was logged
+            status = -2;
+    }
+    else
+        for (int i = 0; i < count && status == 0; i++)
+        {
+            struct Contact_data record;
+            get_contact(&incoming, i, &record);
+            if (kind[i] == MATCH_NEW && insert_contact(addressbook, &record) == -1)
+                status = -1;
+        }
+
+    free(kind);
+    free(target);
+    free(claimed);
+    destroy_address_book(&incoming);
+    return status;
+}
+
+int run_merge(struct Address_book *addressbook, const char *path, int policy)
+{
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        printf("Error: could not open %s\n", path);
+        return -1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct Merge_result result;
+    int status = merge_contacts(addressbook, fd, fd == STDIN_FILENO ? "stdin" : path, policy, stdout, &result);
+    if (fd != STDIN_FILENO)
+        close(fd);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(policy == MERGE_REPORT ? stderr : stdout, // Keep the report alone on stdout
+            "merge: %ld added, %ld overwritten, %ld unchanged, %ld conflicts, %ld bad lines; %d contacts; %.3f s\n",
+            result.added, result.overwritten, result.unchanged, result.conflicts, result.bad,
+            count_contacts(addressbook), elapsed);
+    if (status == -1)
+        printf("Error: not enough memory to merge %s\n", path);
+    else if (status == -2)
+        printf("Error: merged contacts could not be saved to %s\n", SNAPSHOT_FILE);
+    return status == 0 ? 0 : -1;
+}
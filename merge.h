@@ -0,0 +1,34 @@
+#ifndef MERGE_H             // Header guard start, prevents multiple inclusion
+#define MERGE_H
+
+#include <stdio.h>          // FILE for the conflict report
+
+struct Address_book;        // Defined in contact.h
+
+#define MERGE_SKIP 0        // Conflict policy: keep the book's contact
+#define MERGE_OVERWRITE 1   // Replace it with the incoming record
+#define MERGE_REPORT 2      // Keep it and list the conflict
+
+#define MERGE_BULK_FRACTION 8       // New contacts of at least 1/8 of the book are appended in bulk and indexed in one pass
+#define MERGE_BULK_MIN 65536        // ... once there are at least this many
+#define PARALLEL_MERGE_MIN 100000   // Incoming records matched on several threads from this many
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Merge_result         // What a merge did with the incoming records
+{
+    long added;             // New contacts
+    long overwritten;       // Book contacts replaced (MERGE_OVERWRITE)
+    long unchanged;         // Already in the book exactly
+    long conflicts;         // Mobile or mail belongs to a different book contact, left as it was
+    long bad;               // Lines skipped: malformed, breaking a rule, or repeating an earlier line's mobile or mail
+};
+
+/*------------------ Function Declarations ------------------*/
+
+int merge_policy(const char *name); // "skip", "overwrite" or "report" to MERGE_SKIP ..., or -1
+int merge_contacts(struct Address_book *addressbook, int fd, const char *source, int policy, FILE *report,
+                   struct Merge_result *result); // Merge a data.txt-format input, conflicts listed on 'report' (may be NULL); 0, -1 out of memory, -2 not saved
+int run_merge(struct Address_book *addressbook, const char *path, int policy); // Merge a file ("-" = stdin) and print one summary, 0 or -1
+
+#endif // MERGE_H            // End of header guard
@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------------
+-> File         : mobile_column.c
+-> Description  : Packed mobile column for point and range scans.
+                  A 10-digit mobile number fits in 34 bits, so each slot's
+                  number is kept as one uint64_t in its own array, apart
+                  from the 78-byte records. A range query ("every mobile
+                  starting with 98765") reads 8 bytes per contact instead
+                  of pulling names and mails through the cache, and the
+                  scan compares four numbers per instruction with AVX2
+                  when the CPU has it (chosen at run time), else one at a
+                  time.
+
+                  The records stay the row store: the snapshot maps them
+                  and the change log copies them. The folded-name column
+                  lives in the name index (name_index.c). This column is
+                  built on the first range query, then kept current by
+                  insert_contact, update_contact and remove_contact, and
+                  dropped whenever the indexes are rebuilt.
+------------------------------------------------------------------------------*/
+#include <stdio.h>          // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>         // Include memory functions (malloc, realloc, free)
+#include <string.h>         // Include strlen
+#include "contact.h"        // Include structure definitions and function prototypes
+#include "mobile_column.h"  // Include mobile column declarations
+#include "stats.h"          // Include operation counters
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>      // Include AVX2 intrinsics (compiled per function, used only if supported)
+#define HAVE_AVX2_KERNEL 1
+#endif
+
+/*------------------- Packing -------------------*/
+uint64_t pack_mobile(const char *mobile_number)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        if (mobile_number[i] < '0' || mobile_number[i] > '9')
+            return MOBILE_NONE; // Tombstone (empty) or not a mobile number
+        value = value * 10 + (uint64_t)(mobile_number[i] - '0');
+    }
+    return mobile_number[10] == '\0' ? value : MOBILE_NONE;
+}
+
+/*------------------- Build / Maintain -------------------*/
+static int grow_column(struct Mobile_column *column, int capacity) // Room for 'capacity' slots, 0 or -1
+{
+    if (capacity <= column->capacity)
+        return 0;
+    if (capacity < 2 * column->capacity)
+        capacity = 2 * column->capacity; // Amortized O(1) appends
+    uint64_t *values = realloc(column->values, (size_t)capacity * sizeof(uint64_t));
+    if (values == NULL)
+        return -1;
+    column->values = values;
+    column->capacity = capacity;
+    return 0;
+}
+
+struct Mobile_column *mobile_column_build(const struct Address_book *addressbook)
+{
+    struct Mobile_column *column = calloc(1, sizeof(*column));
+    if (column == NULL || grow_column(column, addressbook->contact_count > 16 ? addressbook->contact_count : 16) != 0)
+    {
+        mobile_column_free(column);
+        return NULL;
+    }
+    for (int i = 0; i < addressbook->contact_count; i++)
+        column->values[i] = pack_mobile(addressbook->contact_details[i].Mobile_number);
+    column->count = addressbook->contact_count;
+    return column;
+}
+
+void mobile_column_free(struct Mobile_column *column)
+{
+    if (column == NULL)
+        return;
+    free(column->values);
+    free(column);
+}
+
+int mobile_column_set(struct Mobile_column *column, int contact, uint64_t value)
+{
+    if (contact >= column->count) // New slot (insert_contact appends one at a time)
+    {
+        if (grow_column(column, contact + 1) != 0)
+            return -1;
+        for (int i = column->count; i < contact; i++)
+            column->values[i] = MOBILE_NONE;
+        column->count = contact + 1;
+    }
+    column->values[contact] = value;
+    return 0;
+}
+
+/*------------------- Scan Kernels -------------------*/
+static int scan_scalar(const uint64_t *values, int from, int count, uint64_t low, uint64_t high,
+                       int *matches, int limit, int total) // One value at a time
+{
+    for (int i = from; i < count; i++)
+        if (values[i] - low <= high - low) // low <= v <= high in one unsigned compare
+        {
+            if (total < limit)
+                matches[total] = i;
+            total++;
+        }
+    return total;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+static int scan_avx2(const uint64_t *values, int count, uint64_t low, uint64_t high, int *matches, int limit) // Eight values per step
+{
+    // Numbers are below 2^34 and MOBILE_NONE is -1 as a signed value, so signed compares are exact
+    __m256i above = _mm256_set1_epi64x((long long)low - 1);
+    __m256i below = _mm256_set1_epi64x((long long)high + 1);
+    int total = 0, i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(values + i + 4));
+        __m256i in_a = _mm256_and_si256(_mm256_cmpgt_epi64(a, above), _mm256_cmpgt_epi64(below, a));
+        __m256i in_b = _mm256_and_si256(_mm256_cmpgt_epi64(b, above), _mm256_cmpgt_epi64(below, b));
+        unsigned int mask = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(in_a)) |
+                            (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(in_b)) << 4;
+        while (mask != 0) // Usually none: a range covers few contacts
+        {
+            if (total < limit)
+                matches[total] = i + __builtin_ctz(mask);
+            total++;
+            mask &= mask - 1;
+        }
+    }
+    return scan_scalar(values, i, count, low, high, matches, limit, total); // Tail
+}
+#endif
+
+int mobile_scan(const struct Mobile_column *column, uint64_t low, uint64_t high, int *matches, int limit)
+{
+    if (low > high)
+        return 0;
+#ifdef HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) // Read from a table filled at program start
+        return scan_avx2(column->values, column->count, low, high, matches, limit);
+#endif
+    return scan_scalar(column->values, 0, column->count, low, high, matches, limit, 0);
+}
+
+/*------------------- Prefix Query -------------------*/
+int find_by_mobile_prefix(struct Address_book *addressbook, const char *prefix, int *matches, int limit)
+{
+    size_t length = strlen(prefix);
+    if (length > 10)
+        return 0;
+    uint64_t low = 0, span = 1;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (prefix[i] < '0' || prefix[i] > '9')
+            return 0; // No mobile number starts with it
+        low = low * 10 + (uint64_t)(prefix[i] - '0');
+    }
+    for (size_t i = length; i < 10; i++) // "98765" covers 9876500000 .. 9876599999
+    {
+        low *= 10;
+        span *= 10;
+    }
+    uint64_t start = stats_begin();
+    if (addressbook->mobile_column == NULL && (addressbook->mobile_column = mobile_column_build(addressbook)) == NULL)
+        return -1;
+    int total = mobile_scan(addressbook->mobile_column, low, low + span - 1, matches, limit);
+    stats_add(COUNT_SCANNED, (uint64_t)addressbook->mobile_column->count);
+    stats_end(STAT_MOBILE_PREFIX, start);
+    return total;
+}
@@ -0,0 +1,28 @@
+#ifndef MOBILE_COLUMN_H     // Header guard start, prevents multiple inclusion
+#define MOBILE_COLUMN_H
+
+#include <stdint.h>         // uint64_t packed mobile numbers
+
+struct Address_book;        // Defined in contact.h
+
+#define MOBILE_NONE UINT64_MAX  // Column value of a deleted slot, inside no range
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Mobile_column        // Mobile_number of every slot as one integer, 8 bytes apiece instead of a 78-byte record
+{
+    uint64_t *values;       // values[contact], MOBILE_NONE for tombstones
+    int count;              // Slots covered (contact_count of the book)
+    int capacity;           // Slots allocated
+};
+
+/*------------------ Function Declarations ------------------*/
+
+uint64_t pack_mobile(const char *mobile_number); // 10 digits to an integer, MOBILE_NONE if not 10 digits
+struct Mobile_column *mobile_column_build(const struct Address_book *addressbook); // Pack every slot, NULL if out of memory
+void mobile_column_free(struct Mobile_column *column); // Release the column
+int mobile_column_set(struct Mobile_column *column, int contact, uint64_t value); // Store a slot's value (growing for a new slot), 0 or -1
+int mobile_scan(const struct Mobile_column *column, uint64_t low, uint64_t high, int *matches, int limit); // Slots with low <= mobile <= high in slot order, up to 'limit' written, total returned
+int find_by_mobile_prefix(struct Address_book *addressbook, const char *prefix, int *matches, int limit); // Contacts whose mobile starts with 'prefix' (0-10 digits), total or -1 if out of memory
+
+#endif // MOBILE_COLUMN_H    // End of header guard
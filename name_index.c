@@ -0,0 +1,257 @@
+/*------------------------------------------------------------------------------
+-> File         : name_index.c
+-> Description  : Ordered name index (skip list) for struct Address_book.
+                  Contacts are kept in dictionary order of their lower-cased
+                  Name, ties broken by contact index so equal names keep the
+                  order they were added in. Create, edit and delete relink a
+                  single node in O(log n), so listing and saving walk the
+                  list in order without any sort pass.
+
+                  The index keeps no copy of the names: like the hash
+                  indexes it reads each contact's Name from the book
+                  (contact_name) and compares in any case with strcasecmp,
+                  the same order as comparing lower-cased names. So a
+                  contact must be unlinked while it still has the name it
+                  was linked by, and linked once its new name is stored.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free)
+#include <string.h>     // Include string handling functions (memset)
+#include <strings.h>    // Include strcasecmp for name order
+#include <ctype.h>      // Include tolower for case folding
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "name_index.h" // Include name index declarations
+
+#define END_OF_LIST -1  // Link value meaning "no next node"
+#define HEAD -1         // Node number used for the head node
+
+/*------------------- Fold Name -------------------*/
+void fold_name(char *key, const char *name) // Lower-case copy of name, zero padded to NAME_KEY_SIZE
+{
+    int k = 0;
+    for (; k < NAME_KEY_SIZE - 1 && name[k] != '\0'; k++)
+        key[k] = tolower((unsigned char)name[k]);
+    memset(key + k, 0, NAME_KEY_SIZE - k);
+}
+
+/*------------------- Links -------------------*/
+static int *forward(struct Name_index *index, int node, int level) // Link 'level' of a node (or of the head)
+{
+    return node == HEAD ? &index->head[level] : &index->links[index->offsets[node] + level];
+}
+
+static int next_at(const struct Name_index *index, int node, int level) // Read-only version of forward()
+{
+    return node == HEAD ? index->head[level] : index->links[index->offsets[node] + level];
+}
+
+static int node_before(const struct Address_book *addressbook, int node, const char *name, int contact) // node sorts before (name, contact)?
+{
+    int cmp = strcasecmp(contact_name(addressbook, node), name);
+    return cmp < 0 || (cmp == 0 && node < contact);
+}
+
+static int random_level(struct Name_index *index) // Level with probability 1/4 of going one higher
+{
+    unsigned int x = index->seed; // xorshift32
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    index->seed = x;
+
+    int level = 1;
+    while ((x & 3) == 0 && level < NAME_INDEX_MAX_LEVEL)
+    {
+        level++;
+        x >>= 2;
+    }
+    return level;
+}
+
+static int reserve_nodes(struct Name_index *index, int count) // Per-contact arrays for 'count' contacts
+{
+    if (count <= index->capacity)
+        return 0;
+
+    int capacity = index->capacity ? index->capacity : 16;
+    while (capacity < count)
+        capacity = capacity > 0x3fffffff ? count : capacity * 2;
+
+    unsigned char *levels = realloc(index->levels, (size_t)capacity);
+    if (levels == NULL)
+        return -1;
+    index->levels = levels;
+    int *offsets = realloc(index->offsets, (size_t)capacity * sizeof(int));
+    if (offsets == NULL)
+        return -1;
+    index->offsets = offsets;
+
+    index->capacity = capacity;
+    return 0;
+}
+
+static int give_links(struct Name_index *index, int contact) // Pick a level and hand out that many links
+{
+    int level = random_level(index);
+    if (index->links_used + level > index->links_capacity)
+    {
+        size_t capacity = index->links_capacity ? index->links_capacity * 2 : 64;
+        int *links = realloc(index->links, capacity * sizeof(int));
+        if (links == NULL)
+            return -1;
+        index->links = links;
+        index->links_capacity = capacity;
+    }
+    if (index->links_used > 0x7fffffff - (size_t)level) // Offsets are ints
+        return -1;
+    index->offsets[contact] = (int)index->links_used;
+    index->levels[contact] = (unsigned char)level;
+    index->links_used += level;
+    return 0;
+}
+
+/*------------------- Initialise / Free -------------------*/
+void name_index_init(struct Name_index *index) // Empty list
+{
+    memset(index, 0, sizeof(*index));
+    for (int l = 0; l < NAME_INDEX_MAX_LEVEL; l++)
+        index->head[l] = END_OF_LIST;
+    index->seed = 2463534242u; // Any non-zero seed
+}
+
+void name_index_free(struct Name_index *index) // Release all memory
+{
+    free(index->levels);
+    free(index->offsets);
+    free(index->links);
+    name_index_init(index);
+}
+
+/*------------------- Insert Contact -------------------*/
+int name_index_insert(struct Name_index *index, const struct Address_book *addressbook, int contact) // Link contact at its place
+{
+    if (reserve_nodes(index, contact + 1) != 0)
+        return -1;
+    while (index->count <= contact) // New contacts start unlinked
+        index->levels[index->count++] = 0;
+
+    const char *name = contact_name(addressbook, contact);
+    if (index->levels[contact] == 0 && give_links(index, contact) != 0) // Renamed contacts reuse their links
+        return -1;
+
+    int update[NAME_INDEX_MAX_LEVEL]; // Last node before the new one on every level
+    int node = HEAD;
+    for (int l = index->level - 1; l >= 0; l--)
+    {
+        int next;
+        while ((next = next_at(index, node, l)) != END_OF_LIST && node_before(addressbook, next, name, contact))
+            node = next;
+        update[l] = node;
+    }
+
+    int level = index->levels[contact];
+    for (int l = index->level; l < level; l++) // New levels start at the head
+        update[l] = HEAD;
+    if (level > index->level)
+        index->level = level;
+
+    for (int l = 0; l < level; l++) // Splice the node in
+    {
+        *forward(index, contact, l) = next_at(index, update[l], l);
+        *forward(index, update[l], l) = contact;
+    }
+    return 0;
+}
+
+/*------------------- Remove Contact -------------------*/
+void name_index_remove(struct Name_index *index, const struct Address_book *addressbook, int contact) // Unlink contact, keeping its slot and links for reuse
+{
+    if (contact < 0 || contact >= index->count || index->levels[contact] == 0)
+        return;
+
+    const char *name = contact_name(addressbook, contact);
+    int node = HEAD;
+    for (int l = index->level - 1; l >= 0; l--)
+    {
+        int next;
+        while ((next = next_at(index, node, l)) != END_OF_LIST && node_before(addressbook, next, name, contact))
+            node = next;
+        if (next == contact) // Bypass the node on this level
+            *forward(index, node, l) = next_at(index, contact, l);
+    }
+    while (index->level > 0 && index->head[index->level - 1] == END_OF_LIST) // Drop empty top levels
+        index->level--;
+}
+
+/*------------------- Build Index -------------------*/
+int name_index_build(struct Name_index *index, const struct Address_book *addressbook, int count, const int *order) // Index all contacts
+{
+    name_index_free(index);
+    if (count == 0)
+        return 0;
+    if (reserve_nodes(index, count) != 0)
+        return -1;
+
+    memset(index->levels, 0, (size_t)count); // Nothing linked yet
+    index->count = count;
+
+    int sorted = 1; // Does 'order' (or the array itself) really list contacts in (name, index) order?
+    for (int k = 1; k < count && sorted; k++)
+    {
+        int prev = order ? order[k - 1] : k - 1;
+        int node = order ? order[k] : k;
+        sorted = node_before(addressbook, prev, contact_name(addressbook, node), node);
+    }
+
+    if (!sorted) // Fall back to inserting one by one, O(n log n)
+    {
+        for (int i = 0; i < count; i++)
+            if (name_index_insert(index, addressbook, i) != 0)
+                return -1;
+        return 0;
+    }
+
+    int last[NAME_INDEX_MAX_LEVEL]; // Last node linked on every level
+    for (int l = 0; l < NAME_INDEX_MAX_LEVEL; l++)
+        last[l] = HEAD;
+    for (int k = 0; k < count; k++) // Already in order: append each node at the tail, O(n)
+    {
+        int i = order ? order[k] : k;
+        if (give_links(index, i) != 0)
+            return -1;
+        int level = index->levels[i];
+        for (int l = 0; l < level; l++)
+        {
+            *forward(index, last[l], l) = i;
+            *forward(index, i, l) = END_OF_LIST;
+            last[l] = i;
+        }
+        if (level > index->level)
+            index->level = level;
+    }
+    return 0;
+}
+
+/*------------------- Walk In Order -------------------*/
+int name_index_first(const struct Name_index *index) // First contact in name order
+{
+    return index->head[0];
+}
+
+int name_index_next(const struct Name_index *index, int contact) // Contact after 'contact'
+{
+    return next_at(index, contact, 0);
+}
+
+int name_index_seek(const struct Name_index *index, const struct Address_book *addressbook, const char *name) // First contact whose name >= name, in any case
+{
+    int node = HEAD;
+    for (int l = index->level - 1; l >= 0; l--)
+    {
+        int next;
+        while ((next = next_at(index, node, l)) != END_OF_LIST &&
+               strcasecmp(contact_name(addressbook, next), name) < 0)
+            node = next;
+    }
+    return next_at(index, node, 0);
+}
@@ -0,0 +1,39 @@
+#ifndef NAME_INDEX_H        // Header guard start, prevents multiple inclusion
+#define NAME_INDEX_H
+
+#include <stddef.h>         // size_t
+
+struct Address_book;        // Defined in contact.h
+
+#define NAME_KEY_SIZE 32            // Folded name prefix of fold_name (shard bounds)
+#define NAME_INDEX_MAX_LEVEL 16     // Skip list height limit (enough for 4^16 contacts)
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Name_index           // Skip list of contact indices ordered by (Name in any case, contact index); names are read from the book
+{
+    unsigned char *levels;  // Number of forward links of each contact's node (0 = not linked)
+    int *offsets;           // Where each contact's forward links start inside 'links'
+    int count;              // Number of contacts covered by keys/levels/offsets
+    int capacity;           // Number of contacts the per-contact arrays can hold
+    int *links;             // Pool of forward links (-1 = end of list)
+    size_t links_used;      // Links handed out from the pool
+    size_t links_capacity;  // Size of the pool
+    int head[NAME_INDEX_MAX_LEVEL]; // Forward links of the head node
+    int level;              // Highest level currently in use
+    unsigned int seed;      // State of the level generator
+};
+
+/*------------------ Function Declarations ------------------*/
+
+void fold_name(char *key, const char *name); // Lower-case the first NAME_KEY_SIZE - 1 characters of name into a zero-padded key
+void name_index_init(struct Name_index *index); // Empty index
+void name_index_free(struct Name_index *index); // Release all memory
+int name_index_build(struct Name_index *index, const struct Address_book *addressbook, int count, const int *order); // Index contacts listed in 'order' (NULL = array order), O(n) when that order is sorted, 0 or -1
+int name_index_insert(struct Name_index *index, const struct Address_book *addressbook, int contact); // Link a new or renamed contact (its name already stored), 0 or -1
+void name_index_remove(struct Name_index *index, const struct Address_book *addressbook, int contact); // Unlink a contact while it still has the name it was linked by (its slot stays valid)
+int name_index_first(const struct Name_index *index); // First contact in name order, or -1
+int name_index_next(const struct Name_index *index, int contact); // Contact after 'contact' in name order, or -1
+int name_index_seek(const struct Name_index *index, const struct Address_book *addressbook, const char *name); // First contact whose name is >= name in any case (strcasecmp), or -1
+
+#endif // NAME_INDEX_H       // End of header guard
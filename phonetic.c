@@ -0,0 +1,295 @@
+/*------------------------------------------------------------------------------
+-> File         : phonetic.c
+-> Description  : Sound-alike name search. Names taken down over the phone
+                  are spelt as heard ("Bharath" / "Barath", "Haritha" /
+                  "Haritta"), so neither the exact nor the typo search
+                  (a few edits, but a shared trigram) can be relied on.
+
+                  Every name gets a phonetic key: the Soundex code of each
+                  of its first PHONETIC_WORDS words (first letter, then
+                  three digits for the consonant groups that follow; h and
+                  w are silent, repeats collapse), 14 bits a word, packed
+                  into one integer. The keys are kept per slot, and slots
+                  are chained by key hash, so a query computes one key,
+                  walks one bucket, and never looks at another name.
+                  Candidates with the same key are then ranked by edit
+                  distance to the query (text_index.c) and those more than
+                  max_distance edits away are dropped.
+
+                  The index is built on the first sound-alike search, then
+                  kept current by insert_contact, update_contact and
+                  remove_contact, and dropped whenever the indexes are
+                  rebuilt, like the trigram index and the mobile column.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free, qsort)
+#include <string.h>     // Include string handling functions (strlen)
+#include <strings.h>    // Include strcasecmp for name order
+#include <ctype.h>      // Include tolower / isalpha for the Soundex codes
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "phonetic.h"   // Include phonetic index declarations
+#include "stats.h"      // Include operation counters
+
+#define MIN_BUCKETS 16          // Smallest bucket array
+#define WORD_BITS 14            // Bits of one word's code: 5 for the letter, 3 for each digit
+#define SILENT 7                // Soundex class of h and w: skipped, and does not separate repeats
+#define MAX_QUERY 64            // Longest query accepted (folded), as in text_index.c
+
+static const char soundex_class[26] = { // a..z: 0 = vowel, 1-6 = consonant group, SILENT = h, w
+    0, 1, 2, 3, 0, 1, 2, SILENT, 0, 2, 2, 4, 5, 5, 0, 1, 2, 6, 2, 3, 0, 1, SILENT, 2, 0, 2 };
+
+struct Ranked_alike         // Candidate plus the key it is ordered by
+{
+    int index;              // Contact index
+    int distance;           // Edits from the query
+    const char *key;        // Name, ties go by name order (any case)
+};
+
+/*------------------- Keys -------------------*/
+static int letter_of(unsigned char c) // 0..25 for a letter in either case, -1 otherwise
+{
+    return isalpha(c) ? tolower(c) - 'a' : -1;
+}
+
+static int soundex_word(const char **text) // Code of the word at *text (which starts with a letter), moves past the word
+{
+    const char *p = *text;
+    int first = letter_of((unsigned char)*p);
+    int code = (first + 1) << 9; // Letter 1..26, then three 3-bit digits
+    int last = soundex_class[first], digits = 0;
+    for (p++; letter_of((unsigned char)*p) != -1; p++)
+    {
+        int group = soundex_class[letter_of((unsigned char)*p)];
+        if (group == SILENT)
+            continue; // "Bharath" reads as "Barat"
+        if (group != 0 && group != last && digits < 3)
+            code |= group << (3 * (2 - digits++));
+        last = group; // A vowel lets the same group count again
+    }
+    *text = p;
+    return code;
+}
+
+uint64_t phonetic_key(const char *name)
+{
+    uint64_t key = PHONETIC_NONE;
+    int words = 0;
+    while (*name != '\0' && words < PHONETIC_WORDS)
+    {
+        if (letter_of((unsigned char)*name) == -1)
+        {
+            name++; // Spaces and anything else only separate words
+            continue;
+        }
+        key = key << WORD_BITS | (uint64_t)soundex_word(&name);
+        words++;
+    }
+    return key;
+}
+
+/*------------------- Buckets -------------------*/
+static int bucket_of(const struct Phonetic_index *index, uint64_t key) // Fibonacci hashing on the packed key
+{
+    int bits = __builtin_ctz((unsigned int)index->bucket_count);
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+static void link_slot(struct Phonetic_index *index, int contact) // Put a keyed slot at the head of its bucket
+{
+    int bucket = bucket_of(index, index->keys[contact]);
+    int head = index->buckets[bucket];
+    index->next[contact] = head;
+    index->previous[contact] = -1;
+    if (head != -1)
+        index->previous[head] = contact;
+    index->buckets[bucket] = contact;
+    index->linked++;
+}
+
+static void unlink_slot(struct Phonetic_index *index, int contact) // Take a slot out of its bucket, O(1)
+{
+    if (index->keys[contact] == PHONETIC_NONE)
+        return; // Never chained
+    int next = index->next[contact], previous = index->previous[contact];
+    if (previous != -1)
+        index->next[previous] = next;
+    else
+        index->buckets[bucket_of(index, index->keys[contact])] = next;
+    if (next != -1)
+        index->previous[next] = previous;
+    index->linked--;
+}
+
+static int rehash(struct Phonetic_index *index, int bucket_count) // Chain every keyed slot into 'bucket_count' buckets, 0 or -1
+{
+    int *buckets = malloc((size_t)bucket_count * sizeof(int));
+    if (buckets == NULL)
+        return -1;
+    memset(buckets, 0xff, (size_t)bucket_count * sizeof(int)); // All bytes 0xff == -1
+    free(index->buckets);
+    index->buckets = buckets;
+    index->bucket_count = bucket_count;
+    index->linked = 0;
+    for (int i = index->count - 1; i >= 0; i--) // Backwards, so each chain lists its slots in ascending order
+        if (index->keys[i] != PHONETIC_NONE)
+            link_slot(index, i);
+    return 0;
+}
+
+static int grow_slots(struct Phonetic_index *index, int capacity) // Room for 'capacity' slots, 0 or -1
+{
+    if (capacity <= index->capacity)
+        return 0;
+    if (capacity < 2 * index->capacity)
+        capacity = 2 * index->capacity; // Amortized O(1) appends
+    uint64_t *keys = realloc(index->keys, (size_t)capacity * sizeof(uint64_t));
+    if (keys == NULL)
+        return -1;
+    index->keys = keys;
+    int *next = realloc(index->next, (size_t)capacity * sizeof(int));
+    if (next == NULL)
+        return -1;
+    index->next = next;
+    int *previous = realloc(index->previous, (size_t)capacity * sizeof(int));
+    if (previous == NULL)
+        return -1;
+    index->previous = previous;
+    index->capacity = capacity;
+    return 0;
+}
+
+/*------------------- Build / Free / Set -------------------*/
+struct Phonetic_index *phonetic_index_build(const struct Address_book *addressbook)
+{
+    struct Phonetic_index *index = calloc(1, sizeof(*index));
+    int count = addressbook->contact_count;
+    int bucket_count = MIN_BUCKETS;
+    while (bucket_count < count && bucket_count < (1 << 30))
+        bucket_count *= 2;
+    if (index == NULL || grow_slots(index, count > MIN_BUCKETS ? count : MIN_BUCKETS) != 0)
+    {
+        phonetic_index_free(index);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) // Each name is keyed once, here or when it is stored
+        index->keys[i] = contact_deleted(addressbook, i) ? PHONETIC_NONE : phonetic_key(contact_name(addressbook, i));
+    index->count = count;
+    if (rehash(index, bucket_count) != 0)
+    {
+        phonetic_index_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void phonetic_index_free(struct Phonetic_index *index)
+{
+    if (index == NULL)
+        return;
+    free(index->keys);
+    free(index->next);
+    free(index->previous);
+    free(index->buckets);
+    free(index);
+}
+
+int phonetic_index_set(struct Phonetic_index *index, int contact, const char *name)
+{
+    if (contact >= index->count) // New slot (insert_contact appends one at a time)
+    {
+        if (grow_slots(index, contact + 1) != 0)
+            return -1;
+        for (int i = index->count; i <= contact; i++)
+            index->keys[i] = PHONETIC_NONE;
+        index->count = contact + 1;
+    }
+    uint64_t key = name != NULL ? phonetic_key(name) : PHONETIC_NONE;
+    if (key == index->keys[contact])
+        return 0; // Renamed to a sound-alike: same chain
+    unlink_slot(index, contact);
+    index->keys[contact] = PHONETIC_NONE; // Unchained while the buckets may be redone
+    if (key == PHONETIC_NONE)
+        return 0;
+    if (index->linked >= index->bucket_count && index->bucket_count < (1 << 30) &&
+        rehash(index, index->bucket_count * 2) != 0) // Keep chains short: at most one slot per bucket on average
+        return -1;
+    index->keys[contact] = key;
+    link_slot(index, contact);
+    return 0;
+}
+
+/*------------------- Search -------------------*/
+static int compare_alikes(const void *a, const void *b) // Fewest edits first, then dictionary order
+{
+    const struct Ranked_alike *x = a, *y = b;
+    if (x->distance != y->distance)
+        return x->distance - y->distance;
+    int cmp = strcasecmp(x->key, y->key);
+    if (cmp != 0)
+        return cmp;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int sound_alikes(struct Address_book *addressbook, const char *query, int max_distance,
+                        int offset, int limit, struct Search_hit *hits, int *total) // Same key, within max_distance edits, closest first
+{
+    char folded[MAX_QUERY];
+    int len = 0;
+    for (; len < MAX_QUERY - 1 && query[len] != '\0'; len++)
+        folded[len] = tolower((unsigned char)query[len]);
+    folded[len] = '\0';
+    uint64_t key = phonetic_key(folded);
+    *total = 0;
+    if (key == PHONETIC_NONE)
+        return 0;
+    if (addressbook->phonetic_index == NULL) // First sound-alike search: key every name once
+    {
+        addressbook->phonetic_index = phonetic_index_build(addressbook);
+        if (addressbook->phonetic_index == NULL)
+            return -1;
+    }
+
+    const struct Phonetic_index *index = addressbook->phonetic_index;
+    struct Ranked_alike *ranked = NULL;
+    int count = 0, capacity = 0;
+    for (int id = index->buckets[bucket_of(index, key)]; id != -1; id = index->next[id])
+    {
+        if (index->keys[id] != key)
+            continue; // Another key in the same bucket
+        stats_add(COUNT_CANDIDATES, 1);
+        const char *name = contact_name(addressbook, id);
+        int distance = name_distance(folded, name);
+        if (distance < 0 || distance > max_distance)
+            continue; // Sounds alike but spelt too differently
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            struct Ranked_alike *grown = realloc(ranked, (size_t)capacity * sizeof(*ranked));
+            if (grown == NULL)
+            {
+                free(ranked);
+                return -1;
+            }
+            ranked = grown;
+        }
+        ranked[count++] = (struct Ranked_alike){ id, distance, name };
+    }
+    if (count > 0)
+        qsort(ranked, count, sizeof(*ranked), compare_alikes);
+
+    int written = 0;
+    for (int i = offset; i < count && written < limit; i++) // Copy out the requested page
+        hits[written++] = (struct Search_hit){ ranked[i].index, ranked[i].distance };
+    *total = count;
+    free(ranked);
+    return written;
+}
+
+int phonetic_search(struct Address_book *addressbook, const char *query, int max_distance,
+                    int offset, int limit, struct Search_hit *hits, int *total) // Timed sound_alikes
+{
+    uint64_t start = stats_begin();
+    int written = sound_alikes(addressbook, query, max_distance, offset, limit, hits, total);
+    stats_end(STAT_PHONETIC_SEARCH, start);
+    return written;
+}
@@ -0,0 +1,36 @@
+#ifndef PHONETIC_H          // Header guard start, prevents multiple inclusion
+#define PHONETIC_H
+
+#include <stdint.h>         // uint64_t packed keys
+
+struct Address_book;        // Defined in contact.h
+struct Search_hit;          // Defined in text_index.h
+
+#define PHONETIC_NONE 0     // Key of a deleted slot (every name has at least one word)
+#define PHONETIC_WORDS 4    // Words of a name that go into its key, 14 bits each
+#define PHONETIC_DISTANCE 3 // Edits the menu allows between a sound-alike name and the query
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Phonetic_index       // Soundex key of every slot; slots whose keys share a bucket are chained
+{
+    uint64_t *keys;         // keys[contact], PHONETIC_NONE for tombstones
+    int *next;              // next[contact]: following slot in its bucket, -1 at the end
+    int *previous;          // previous[contact]: slot before it, -1 when it heads the bucket
+    int *buckets;           // First slot of each bucket, -1 when empty
+    int bucket_count;       // Power of two, kept at least the number of chained slots
+    int linked;             // Slots chained (live contacts)
+    int count;              // Slots covered (contact_count of the book)
+    int capacity;           // Slots allocated in keys, next and previous
+};
+
+/*------------------ Function Declarations ------------------*/
+
+uint64_t phonetic_key(const char *name); // Soundex codes of the first PHONETIC_WORDS words packed together, PHONETIC_NONE if no letters
+struct Phonetic_index *phonetic_index_build(const struct Address_book *addressbook); // Key and chain every slot, NULL if out of memory
+void phonetic_index_free(struct Phonetic_index *index); // Release the index
+int phonetic_index_set(struct Phonetic_index *index, int contact, const char *name); // Re-key a slot (growing for a new one, NULL name = deleted), 0 or -1
+int phonetic_search(struct Address_book *addressbook, const char *query, int max_distance,
+                    int offset, int limit, struct Search_hit *hits, int *total); // Names that sound like the query within max_distance edits, closest first, hits written or -1
+
+#endif // PHONETIC_H         // End of header guard
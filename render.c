@@ -0,0 +1,227 @@
+/*------------------------------------------------------------------------------
+-> File         : render.c
+-> Description  : Output of contact lists: the menu's tables, search results
+                  and the 'list' command.
+
+                  Rows are formatted by hand (no printf) into a 64 KiB
+                  buffer that is written out with one write() when it fills,
+                  so listing millions of contacts costs a few hundred system
+                  calls. Lists stream straight off the name index, a page at
+                  a time if wanted, without copying or sorting the contacts.
+
+                  Table rows are padded and cut to fixed column widths like
+                  the old "%-18.18s" format; the No. column grows with the
+                  largest row number so big lists stay aligned.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include fflush so earlier printf output comes first
+#include <string.h>     // Include string handling functions (memcpy, memset, strlen, strcmp)
+#include <errno.h>      // Include errno for EINTR
+#include <unistd.h>     // Include write, isatty
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "render.h"     // Include the renderer declarations
+
+#define NAME_WIDTH 18           // Table column widths (characters)
+#define MOBILE_WIDTH 12
+#define MAIL_WIDTH 41
+#define MIN_NUMBER_WIDTH 4
+
+/*------------------- Buffer -------------------*/
+static void flush_buffer(struct Renderer *renderer) // Write out what is gathered
+{
+    size_t done = 0;
+    while (!renderer->failed && done < renderer->used)
+    {
+        ssize_t written = write(renderer->fd, renderer->buffer + done, renderer->used - done);
+        if (written > 0)
+            done += (size_t)written;
+        else if (written < 0 && errno != EINTR)
+            renderer->failed = 1; // Reader went away or disk full: drop the rest
+    }
+    renderer->used = 0;
+}
+
+static char *reserve(struct Renderer *renderer, size_t length) // Room for 'length' bytes (at most RENDER_BUFFER)
+{
+    if (renderer->used + length > RENDER_BUFFER)
+        flush_buffer(renderer);
+    char *at = renderer->buffer + renderer->used;
+    renderer->used += length;
+    return at;
+}
+
+static void put_text(struct Renderer *renderer, const char *text, size_t length) // Any length, a buffer at a time
+{
+    while (length > 0)
+    {
+        size_t piece = length < RENDER_BUFFER ? length : RENDER_BUFFER;
+        memcpy(reserve(renderer, piece), text, piece);
+        text += piece;
+        length -= piece;
+    }
+}
+
+static char *copy_padded(char *at, const char *text, int width) // 'text' cut or space-padded to 'width' bytes
+{
+    int length = 0;
+    while (length < width && text[length] != '\0')
+        length++;
+    memcpy(at, text, (size_t)length);
+    memset(at + length, ' ', (size_t)(width - length));
+    return at + width;
+}
+
+static char *copy_field(char *at, const char *text) // Whole field, return where it ends
+{
+    size_t length = strlen(text);
+    memcpy(at, text, length);
+    return at + length;
+}
+
+static int digits(long n)
+{
+    int count = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        count++;
+    }
+    return count;
+}
+
+/*------------------- Table Frame -------------------*/
+static void put_border(struct Renderer *renderer, const char *left, const char *middle, const char *right) // ╔══╦══╗ style line
+{
+    int widths[4] = { renderer->number_width, NAME_WIDTH, MOBILE_WIDTH, MAIL_WIDTH };
+    put_text(renderer, left, strlen(left));
+    for (int column = 0; column < 4; column++)
+    {
+        for (int k = 0; k < widths[column] + 2; k++)
+            put_text(renderer, "═", sizeof("═") - 1);
+        const char *end = column < 3 ? middle : right;
+        put_text(renderer, end, strlen(end));
+    }
+    put_text(renderer, "\n", 1);
+}
+
+static void put_cells(struct Renderer *renderer, const char *number, const char *name, const char *mobile, const char *mail) // ║ a ║ b ║ c ║ d ║
+{
+    size_t frame = 3 + 5 * 3 + 5; // "║ ", three " ║ ", " ║\n" ('║' is 3 bytes of UTF-8)
+    char *at = reserve(renderer, (size_t)renderer->number_width + NAME_WIDTH + MOBILE_WIDTH + MAIL_WIDTH + frame + 1);
+    at = copy_field(at, "║ ");
+    at = copy_padded(at, number, renderer->number_width);
+    at = copy_field(at, " ║ ");
+    at = copy_padded(at, name, NAME_WIDTH);
+    at = copy_field(at, " ║ ");
+    at = copy_padded(at, mobile, MOBILE_WIDTH);
+    at = copy_field(at, " ║ ");
+    at = copy_padded(at, mail, MAIL_WIDTH);
+    at = copy_field(at, " ║\n");
+    renderer->used = (size_t)(at - renderer->buffer); // Give back the spare byte
+}
+
+/*------------------- Renderer -------------------*/
+int render_format(const char *name)
+{
+    if (strcmp(name, "table") == 0)
+        return RENDER_TABLE;
+    if (strcmp(name, "tsv") == 0)
+        return RENDER_TSV;
+    if (strcmp(name, "csv") == 0)
+        return RENDER_CSV;
+    return -1;
+}
+
+int render_default_format(int fd)
+{
+    return isatty(fd) ? RENDER_TABLE : RENDER_TSV;
+}
+
+void render_begin(struct Renderer *renderer, int fd, int format, long last_number)
+{
+    fflush(stdout); // Prompts and headings printed so far go out first
+    renderer->fd = fd;
+    renderer->format = format;
+    renderer->number_width = digits(last_number) > MIN_NUMBER_WIDTH ? digits(last_number) : MIN_NUMBER_WIDTH;
+    renderer->failed = 0;
+    renderer->used = 0;
+    if (format != RENDER_TABLE)
+        return;
+    put_text(renderer, "\n", 1);
+    put_border(renderer, "╔", "╦", "╗");
+    put_cells(renderer, "No.", "Name", "Mobile", "Mail ID");
+    put_border(renderer, "╠", "╬", "╣");
+}
+
+void render_contact(struct Renderer *renderer, long number, const struct Contact_data *contact)
+{
+    if (renderer->format == RENDER_TABLE)
+    {
+        char text[24];
+        char *end = text + sizeof(text);
+        *--end = '\0';
+        do // Digits from the right
+            *--end = (char)('0' + number % 10);
+        while ((number /= 10) > 0);
+        put_cells(renderer, end, contact->Name, contact->Mobile_number, contact->Mail_ID);
+        return;
+    }
+    char separator = renderer->format == RENDER_TSV ? '\t' : ',';
+    size_t name = strlen(contact->Name), mobile = strlen(contact->Mobile_number), mail = strlen(contact->Mail_ID);
+    if (name + mobile + mail + 3 > RENDER_BUFFER) // Huge name or mail ID: field by field
+    {
+        put_text(renderer, contact->Name, name);
+        put_text(renderer, &separator, 1);
+        put_text(renderer, contact->Mobile_number, mobile);
+        put_text(renderer, &separator, 1);
+        put_text(renderer, contact->Mail_ID, mail);
+        put_text(renderer, "\n", 1);
+        return;
+    }
+    char *at = reserve(renderer, name + mobile + mail + 3);
+    memcpy(at, contact->Name, name);
+    at += name;
+    *at++ = separator;
+    memcpy(at, contact->Mobile_number, mobile);
+    at += mobile;
+    *at++ = separator;
+    memcpy(at, contact->Mail_ID, mail);
+    at += mail;
+    *at++ = '\n';
+}
+
+int render_end(struct Renderer *renderer)
+{
+    if (renderer->format == RENDER_TABLE)
+        put_border(renderer, "╚", "╩", "╝");
+    flush_buffer(renderer);
+    return renderer->failed ? -1 : 0;
+}
+
+/*------------------- Lists -------------------*/
+int render_page(const struct Address_book *addressbook, struct Renderer *renderer, int first, long number, long limit)
+{
+    int i = first;
+    for (long row = 0; i != -1 && (limit < 0 || row < limit); row++, i = next_contact(addressbook, i))
+    {
+        struct Contact_data contact;
+        get_contact(addressbook, i, &contact);
+        render_contact(renderer, number + row, &contact);
+    }
+    return i;
+}
+
+long render_list(const struct Address_book *addressbook, int fd, int format, long offset, long limit)
+{
+    long count = count_contacts(addressbook);
+    long last = limit >= 0 && offset + limit < count ? offset + limit : count;
+    if (offset >= last)
+        return 0;
+    int first = first_contact(addressbook);
+    for (long skipped = 0; skipped < offset && first != -1; skipped++) // Walk to the first row of the page
+        first = next_contact(addressbook, first);
+
+    struct Renderer renderer;
+    render_begin(&renderer, fd, format, last);
+    render_page(addressbook, &renderer, first, offset + 1, last - offset);
+    return render_end(&renderer) == 0 ? last - offset : -1;
+}
@@ -0,0 +1,36 @@
+#ifndef RENDER_H            // Header guard start, prevents multiple inclusion
+#define RENDER_H
+
+#include <stddef.h>         // size_t
+
+struct Address_book;        // Defined in contact.h
+struct Contact_data;
+
+#define RENDER_BUFFER 65536 // Output gathered per write()
+#define RENDER_TABLE 0      // Box-drawing table with a No. column (terminals)
+#define RENDER_TSV 1        // Name<TAB>Mobile<TAB>Mail, no header (pipes)
+#define RENDER_CSV 2        // Name,Mobile,Mail, no header (data.txt records, can be imported)
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Renderer             // Rows formatted into one buffer, written out when it fills
+{
+    int fd;                 // Where rows go
+    int format;             // RENDER_TABLE ...
+    int number_width;       // Digits of the No. column (table)
+    int failed;             // A write failed, later output is dropped
+    size_t used;            // Bytes waiting in buffer
+    char buffer[RENDER_BUFFER];
+};
+
+/*------------------ Function Declarations ------------------*/
+
+int render_format(const char *name); // "table", "tsv" or "csv" to RENDER_TABLE ..., or -1
+int render_default_format(int fd); // Table for a terminal, TSV otherwise
+void render_begin(struct Renderer *renderer, int fd, int format, long last_number); // Start a table whose rows are numbered up to 'last_number'
+void render_contact(struct Renderer *renderer, long number, const struct Contact_data *contact); // One row
+int render_end(struct Renderer *renderer); // Close the table and write everything out, 0 or -1
+int render_page(const struct Address_book *addressbook, struct Renderer *renderer, int first, long number, long limit); // Up to 'limit' rows in name order from contact 'first', numbered from 'number'; next contact or -1
+long render_list(const struct Address_book *addressbook, int fd, int format, long offset, long limit); // Stream rows offset .. offset+limit-1 (limit < 0 = all) in name order, rows written or -1
+
+#endif // RENDER_H           // End of header guard
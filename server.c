@@ -0,0 +1,600 @@
+/*------------------------------------------------------------------------------
+-> File         : server.c
+-> Description  : Query server: answers lookups and changes from local
+                  programs over a Unix domain socket, so the book stays
+                  open and indexed between requests.
+
+                  One thread, one epoll loop (level-triggered). Every
+                  connection has an input and an output buffer. All
+                  complete request lines in the input are answered in
+                  order, so a client may pipeline any number of requests
+                  without waiting for replies. A connection whose unsent
+                  replies pass OUTPUT_LIMIT is not read until they drain.
+
+                  Changes go through the library calls (addressbook_insert,
+                  addressbook_update, addressbook_delete), so they meet the
+                  same rules as every other front end, and through the
+                  change log. Replies to a round of epoll events are sent
+                  only after one wal_sync covers every change in it, so an
+                  "OK" to a change means it is durable (group commit). If
+                  that sync fails, the round's change replies are turned
+                  into "ERR" before anything is sent.
+
+                  Requests, one per line:
+                    M mobile                 find by mobile number
+                    M prefix*                mobiles starting with prefix, up to PREFIX_LIMIT
+                    E mail                   find by mail ID
+                    P prefix                 names starting with prefix (any case), up to PREFIX_LIMIT
+                    F n name                 names within n typos (0-3) of name, closest first, up to PREFIX_LIMIT
+                    L n name                 names that sound like name within n edits (0-9), closest first, up to PREFIX_LIMIT
+                    A Name,Mobile,Mail       add
+                    U key Name,Mobile,Mail   edit the contact with this mobile or mail
+                    D key                    delete
+                    S                        operation statistics (stats.c)
+                  Replies, in request order:
+                    OK n                     then n lines "Name,Mobile,Mail" (n = 0 for changes),
+                                             or n lines of the statistics table for 'S'
+                    ERR reason               request not done
+
+                  Every STATS_INTERVAL seconds, and on exit, the statistics
+                  are also written to STATS_FILE for tools that only read
+                  files.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (printf, snprintf)
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free)
+#include <string.h>     // Include string handling functions (memchr, memmove, strchr)
+#include <errno.h>      // Include errno for EAGAIN / EINTR
+#include <strings.h>    // Include strncasecmp for name prefixes
+#include <fcntl.h>      // Include fcntl to make client sockets non-blocking
+#include <signal.h>     // Include sigaction to stop on SIGINT / SIGTERM
+#include <unistd.h>     // Include read, write, close, unlink
+#include <time.h>       // Include clock_gettime to time the statistics dumps
+#include <sys/epoll.h>  // Include the epoll event loop
+#include <sys/socket.h> // Include socket, bind, listen, accept
+#include <sys/stat.h>   // Include lstat to recognize a stale socket
+#include <sys/un.h>     // Include struct sockaddr_un
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "stats.h"      // Include the statistics report
+
+#define SERVER_EVENTS 64            // Events taken per epoll_wait
+#define READ_CHUNK 65536            // Input buffer growth per read
+#define MAX_REQUEST (1 << 20)       // Longest request line (a name or mail ID may be long); a longer one closes the connection
+#define OUTPUT_LIMIT (1 << 20)      // Unsent reply bytes before a connection stops being read
+#define PREFIX_LIMIT 100            // Most contacts one 'P' request returns
+#define CHANGE_OK "OK 0\n"          // Reply to a change, once the round's sync succeeds
+#define CHANGE_NOT_SAVED "change not saved (change log could not be synced)" // Reply to a change when it fails
+
+struct Connection               // One client
+{
+    int fd;
+    char *in;                   // Received bytes not yet answered
+    size_t in_length, in_capacity;
+    char *out;                  // Replies not yet sent, from out_sent on
+    size_t out_length, out_sent, out_capacity;
+    int eof;                    // Client closed its side: answer what is left, then close
+    int closing;                // Protocol error: send what is queued, then close
+    size_t *changes;            // Offsets in 'out' of this round's change replies, rewritten if its sync fails
+    int change_count, change_capacity;
+    unsigned int events;        // Interest currently registered with epoll
+    struct Connection *prev, *next; // Every open connection, for shutdown
+};
+
+static volatile sig_atomic_t stopping; // Set by SIGINT / SIGTERM
+
+static void on_signal(int signal_number)
+{
+    (void)signal_number;
+    stopping = 1;
+}
+
+/*------------------- Replies -------------------*/
+static int put(struct Connection *connection, const char *text, size_t length) // Queue reply bytes, 0 or -1
+{
+    if (connection->out_length + length > connection->out_capacity)
+    {
+        size_t capacity = connection->out_capacity ? connection->out_capacity : 4096;
+        while (capacity < connection->out_length + length)
+            capacity *= 2;
+        char *out = realloc(connection->out, capacity);
+        if (out == NULL)
+            return -1;
+        connection->out = out;
+        connection->out_capacity = capacity;
+    }
+    memcpy(connection->out + connection->out_length, text, length);
+    connection->out_length += length;
+    return 0;
+}
+
+static int put_ok(struct Connection *connection, int n) // "OK n", n contact lines follow
+{
+    char line[32];
+    int length = snprintf(line, sizeof(line), "OK %d\n", n);
+    return put(connection, line, (size_t)length);
+}
+
+static int put_error(struct Connection *connection, const char *reason) // "ERR reason", the request was not done
+{
+    char line[128];
+    int length = snprintf(line, sizeof(line), "ERR %s\n", reason);
+    return put(connection, line, (size_t)length);
+}
+
+static int put_change(struct Connection *connection) // "OK 0" for a change, remembered until the round's sync, 0 or -1
+{
+    if (connection->change_count == connection->change_capacity)
+    {
+        int capacity = connection->change_capacity ? connection->change_capacity * 2 : 16;
+        size_t *changes = realloc(connection->changes, (size_t)capacity * sizeof(*changes));
+        if (changes == NULL)
+            return -1;
+        connection->changes = changes;
+        connection->change_capacity = capacity;
+    }
+    connection->changes[connection->change_count++] = connection->out_length;
+    return put(connection, CHANGE_OK, sizeof(CHANGE_OK) - 1);
+}
+
+static int fail_changes(struct Connection *connection) // The round's sync failed: its "OK 0" change replies become errors, 0 or -1
+{
+    char line[128];
+    size_t length = (size_t)snprintf(line, sizeof(line), "ERR %s\n", CHANGE_NOT_SAVED), ok_length = sizeof(CHANGE_OK) - 1;
+    size_t capacity = connection->out_length + (size_t)connection->change_count * (length - ok_length);
+    char *out = malloc(capacity);
+    if (out == NULL)
+        return -1;
+    size_t from = 0, to = 0;
+    for (int i = 0; i < connection->change_count; i++) // Copy up to each change reply, then the error in its place
+    {
+        size_t at = connection->changes[i];
+        memcpy(out + to, connection->out + from, at - from);
+        to += at - from;
+        memcpy(out + to, line, length);
+        to += length;
+        from = at + ok_length;
+    }
+    memcpy(out + to, connection->out + from, connection->out_length - from);
+    free(connection->out);
+    connection->out = out;
+    connection->out_length = to + connection->out_length - from;
+    connection->out_capacity = capacity;
+    connection->change_count = 0;
+    return 0;
+}
+
+static int put_contact(struct Connection *connection, const struct Address_book *addressbook, int index) // One match, in data.txt format
+{
+    const char *name = contact_name(addressbook, index), *mail = contact_mail(addressbook, index);
+    char mobile[16];
+    int length = snprintf(mobile, sizeof(mobile), ",%s,", contact_mobile(addressbook, index));
+    if (put(connection, name, strlen(name)) != 0 || put(connection, mobile, (size_t)length) != 0 ||
+        put(connection, mail, strlen(mail)) != 0)
+        return -1;
+    return put(connection, "\n", 1);
+}
+
+/*------------------- Requests -------------------*/
+static int answer_prefix(struct Address_book *addressbook, struct Connection *connection, const char *prefix) // 'P': walk the name index from the prefix
+{
+    int matches[PREFIX_LIMIT], count = 0;
+    size_t length = strlen(prefix);
+    for (int i = name_index_seek(&addressbook->name_index, addressbook, prefix);
+         i != -1 && count < PREFIX_LIMIT && strncasecmp(contact_name(addressbook, i), prefix, length) == 0;
+         i = next_contact(addressbook, i))
+        matches[count++] = i;
+    int status = put_ok(connection, count);
+    for (int i = 0; i < count && status == 0; i++)
+        status = put_contact(connection, addressbook, matches[i]);
+    return status;
+}
+
+static int answer_fuzzy(struct Address_book *addressbook, struct Connection *connection, const char *argument) // 'F 2 name': closest names first
+{
+    if (argument[0] < '0' || argument[0] > '9' || argument[1] != ' ')
+        return put_error(connection, "fuzzy search needs a distance and a name");
+    struct Search_hit hits[PREFIX_LIMIT];
+    int total;
+    int count = fuzzy_search(addressbook, argument + 2, argument[0] - '0', 0, PREFIX_LIMIT, hits, &total);
+    if (count < 0)
+        return put_error(connection, "not enough memory");
+    int status = put_ok(connection, count);
+    for (int i = 0; i < count && status == 0; i++)
+        status = put_contact(connection, addressbook, hits[i].index);
+    return status;
+}
+
+static int answer_sounds_like(struct Address_book *addressbook, struct Connection *connection, const char *argument) // 'L 3 name': sound-alikes, closest first
+{
+    if (argument[0] < '0' || argument[0] > '9' || argument[1] != ' ')
+        return put_error(connection, "sound-alike search needs a distance and a name");
+    struct Search_hit hits[PREFIX_LIMIT];
+    int total;
+    int count = phonetic_search(addressbook, argument + 2, argument[0] - '0', 0, PREFIX_LIMIT, hits, &total);
+    if (count < 0)
+        return put_error(connection, "not enough memory");
+    int status = put_ok(connection, count);
+    for (int i = 0; i < count && status == 0; i++)
+        status = put_contact(connection, addressbook, hits[i].index);
+    return status;
+}
+
+static int answer_range(struct Address_book *addressbook, struct Connection *connection, const char *prefix) // 'M 98765*': scan the packed mobile column
+{
+    int matches[PREFIX_LIMIT];
+    int total = find_by_mobile_prefix(addressbook, prefix, matches, PREFIX_LIMIT);
+    if (total < 0)
+        return put_error(connection, "not enough memory");
+    int count = total < PREFIX_LIMIT ? total : PREFIX_LIMIT;
+    int status = put_ok(connection, count);
+    for (int i = 0; i < count && status == 0; i++)
+        status = put_contact(connection, addressbook, matches[i]);
+    return status;
+}
+
+static int answer_stats(struct Connection *connection) // 'S': the statistics table, one reply line per row
+{
+    char report[STATS_REPORT_SIZE];
+    int length = stats_report(report, sizeof(report));
+    int lines = 0;
+    for (int i = 0; i < length; i++)
+        lines += report[i] == '\n';
+    if (put_ok(connection, lines) != 0)
+        return -1;
+    return put(connection, report, (size_t)length);
+}
+
+static int answer(struct Address_book *addressbook, struct Connection *connection, char *line, int *changed) // One request line, 0 or -1 (out of memory)
+{
+    if (line[0] == 'S' && line[1] == '\0')
+        return answer_stats(connection);
+    if (line[0] == '\0' || line[1] != ' ')
+        return put_error(connection, "bad request");
+    char *argument = line + 2;
+    struct Contact_data contact;
+    const char *reason;
+    int index, result;
+    switch (line[0])
+    {
+        case 'M':
+            if (argument[0] != '\0' && argument[strlen(argument) - 1] == '*') // Mobile prefix
+            {
+                argument[strlen(argument) - 1] = '\0';
+                return answer_range(addressbook, connection, argument);
+            }
+            /* fall through */
+        case 'E':
+            index = line[0] == 'M' ? find_by_mobile(addressbook, argument) : find_by_mail(addressbook, argument);
+            if (index == -1)
+                return put_ok(connection, 0);
+            if (put_ok(connection, 1) != 0)
+                return -1;
+            return put_contact(connection, addressbook, index);
+
+        case 'P':
+            return answer_prefix(addressbook, connection, argument);
+
+        case 'F':
+            return answer_fuzzy(addressbook, connection, argument);
+
+        case 'L':
+            return answer_sounds_like(addressbook, connection, argument);
+
+        case 'A':
+            if ((reason = parse_record(argument, strlen(argument), &contact)) != NULL)
+                return put_error(connection, reason);
+            if ((result = addressbook_insert(addressbook, &contact)) != ADDRESSBOOK_OK)
+                return put_error(connection, addressbook_message(result));
+            *changed = 1;
+            return put_change(connection);
+
+        case 'U':
+        {
+            char *record = strchr(argument, ' '); // KEY, then the new record
+            if (record == NULL)
+                return put_error(connection, "edit needs a key and a record");
+            *record++ = '\0';
+            if ((reason = parse_record(record, strlen(record), &contact)) != NULL)
+                return put_error(connection, reason);
+            if ((result = addressbook_update(addressbook, argument, &contact)) != ADDRESSBOOK_OK)
+                return put_error(connection, addressbook_message(result));
+            *changed = 1;
+            return put_change(connection);
+        }
+
+        case 'D':
+            if ((result = addressbook_delete(addressbook, argument)) != ADDRESSBOOK_OK)
+                return put_error(connection, addressbook_message(result));
+            *changed = 1;
+            return put_change(connection);
+    }
+    return put_error(connection, "unknown request");
+}
+
+static void stop_reading(struct Connection *connection, const char *reason) // Tell the client why once, send what is queued, then close
+{
+    connection->closing = 1;
+    put_error(connection, reason); // Best effort: with no memory left this may not fit either
+}
+
+static void answer_all(struct Address_book *addressbook, struct Connection *connection, int *changed) // Every complete line received, in order
+{
+    size_t start = 0;
+    char *newline;
+    connection->change_count = 0; // A new round: earlier change replies are committed
+    while (!connection->closing &&
+           (newline = memchr(connection->in + start, '\n', connection->in_length - start)) != NULL)
+    {
+        *newline = '\0';
+        if (newline > connection->in + start && newline[-1] == '\r')
+            newline[-1] = '\0';
+        if ((size_t)(newline - connection->in - start) >= MAX_REQUEST)
+            stop_reading(connection, "request too long");
+        else if (answer(addressbook, connection, connection->in + start, changed) != 0)
+            stop_reading(connection, addressbook_message(ADDRESSBOOK_NO_MEMORY));
+        start = (size_t)(newline - connection->in) + 1;
+    }
+    if (!connection->closing && connection->in_length - start >= MAX_REQUEST) // No newline in sight
+        stop_reading(connection, "request too long");
+    memmove(connection->in, connection->in + start, connection->in_length - start);
+    connection->in_length -= start;
+}
+
+/*------------------- Connections -------------------*/
+static int read_input(struct Connection *connection) // Take everything the socket holds, 0 or -1 (connection failed)
+{
+    for (;;)
+    {
+        if (connection->in_capacity - connection->in_length < READ_CHUNK / 4)
+        {
+            char *in = realloc(connection->in, connection->in_capacity + READ_CHUNK);
+            if (in == NULL)
+                return -1;
+            connection->in = in;
+            connection->in_capacity += READ_CHUNK;
+        }
+        ssize_t got = read(connection->fd, connection->in + connection->in_length,
+                           connection->in_capacity - connection->in_length);
+        if (got > 0)
+            connection->in_length += (size_t)got;
+        else if (got == 0)
+        {
+            connection->eof = 1;
+            return 0;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        else if (errno != EINTR)
+            return -1;
+    }
+}
+
+static int send_output(struct Connection *connection) // Send queued replies until done or the socket is full, 0 or -1
+{
+    while (connection->out_sent < connection->out_length)
+    {
+        ssize_t sent = write(connection->fd, connection->out + connection->out_sent,
+                             connection->out_length - connection->out_sent);
+        if (sent > 0)
+            connection->out_sent += (size_t)sent;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        else if (errno != EINTR)
+            return -1;
+    }
+    connection->out_sent = connection->out_length = 0; // All sent, reuse the buffer
+    return 0;
+}
+
+static void close_connection(int epoll_fd, struct Connection **connections, struct Connection *connection)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    if (connection->prev != NULL)
+        connection->prev->next = connection->next;
+    else
+        *connections = connection->next;
+    if (connection->next != NULL)
+        connection->next->prev = connection->prev;
+    free(connection->in);
+    free(connection->out);
+    free(connection->changes);
+    free(connection);
+}
+
+static int watch(int epoll_fd, struct Connection *connection) // Read unless replies pile up, wait for room while any are unsent, 0 or -1
+{
+    size_t unsent = connection->out_length - connection->out_sent;
+    unsigned int events = (!connection->eof && !connection->closing && unsent < OUTPUT_LIMIT ? EPOLLIN : 0) |
+                          (unsent > 0 ? EPOLLOUT : 0);
+    if (events == connection->events)
+        return 0;
+    struct epoll_event event = { .events = events, .data.ptr = connection };
+    connection->events = events;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+static void accept_all(int epoll_fd, int listen_fd, struct Connection **connections) // Every pending client
+{
+    int fd;
+    while ((fd = accept(listen_fd, NULL, NULL)) >= 0)
+    {
+        struct Connection *connection = calloc(1, sizeof(*connection));
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        if (connection == NULL || fcntl(fd, F_SETFL, O_NONBLOCK) != 0 || fcntl(fd, F_SETFD, FD_CLOEXEC) != 0 ||
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        connection->next = *connections;
+        if (*connections != NULL)
+            (*connections)->prev = connection;
+        *connections = connection;
+    }
+}
+
+static int open_socket(const char *socket_path) // Listening socket at 'socket_path' (a stale one is replaced), fd or -1
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, socket_path);
+
+    struct stat st;
+    if (lstat(socket_path, &st) == 0 && S_ISSOCK(st.st_mode)) // Left behind by a server that did not stop cleanly
+        unlink(socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*------------------- Run Server -------------------*/
+static long long seconds_now(void) // Monotonic clock, whole seconds
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec;
+}
+
+int run_server(struct Address_book *addressbook, const char *socket_path) // Serve until SIGINT or SIGTERM, 0 or -1
+{
+    int listen_fd = open_socket(socket_path);
+    if (listen_fd < 0)
+    {
+        printf("Error: could not listen on %s\n", socket_path);
+        return -1;
+    }
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL }; // NULL marks the listening socket
+    if (epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0)
+    {
+        printf("Error: could not start the event loop\n");
+        if (epoll_fd >= 0)
+            close(epoll_fd);
+        close(listen_fd);
+        unlink(socket_path);
+        return -1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;      // No SA_RESTART: epoll_wait returns EINTR and the loop ends
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);           // A client that went away is seen as a write error instead
+    stopping = 0;
+    printf("Serving %d contacts on %s (Ctrl-C to stop)\n", count_contacts(addressbook), socket_path);
+    fflush(stdout);
+
+    struct Connection *connections = NULL;
+    struct Connection *ready[SERVER_EVENTS];
+    struct epoll_event events[SERVER_EVENTS];
+    int status = 0;
+    long long next_dump = seconds_now() + STATS_INTERVAL;
+    while (!stopping)
+    {
+        long long now = seconds_now();
+        if (now >= next_dump)
+        {
+            if (stats_write(STATS_FILE) != 0)
+                fprintf(stderr, "Warning: could not write %s\n", STATS_FILE);
+            next_dump = now + STATS_INTERVAL;
+        }
+        int n = epoll_wait(epoll_fd, events, SERVER_EVENTS, (int)(next_dump - now) * 1000); // Wake for the next dump
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            status = -1;
+            break;
+        }
+
+        int changed = 0, replies = 0;
+        for (int i = 0; i < n; i++) // Answer everything received this round
+        {
+            struct Connection *connection = events[i].data.ptr;
+            if (connection == NULL)
+            {
+                accept_all(epoll_fd, listen_fd, &connections);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && read_input(connection) != 0)
+            {
+                close_connection(epoll_fd, &connections, connection);
+                continue;
+            }
+            answer_all(addressbook, connection, &changed);
+            ready[replies++] = connection;
+        }
+
+        int synced = !changed || addressbook->wal == NULL || wal_sync(addressbook) == 0; // One commit for the whole round
+        if (!synced)
+            fprintf(stderr, "Warning: change log could not be synced, this round's changes are answered ERR\n");
+
+        for (int i = 0; i < replies; i++)
+        {
+            struct Connection *connection = ready[i];
+            if ((!synced && connection->change_count > 0 && fail_changes(connection) != 0) || // Never an OK that is not durable
+                send_output(connection) != 0 ||
+                ((connection->eof || connection->closing) && connection->out_length == 0) || // Finished with it
+                watch(epoll_fd, connection) != 0)
+                close_connection(epoll_fd, &connections, connection);
+        }
+    }
+
+    while (connections != NULL)
+        close_connection(epoll_fd, &connections, connections);
+    close(epoll_fd);
+    close(listen_fd);
+    unlink(socket_path);
+    if (stats_write(STATS_FILE) != 0)
+        fprintf(stderr, "Warning: could not write %s\n", STATS_FILE);
+    printf("Server stopped\n");
+    return status;
+}
+
+/*------------------- Client -------------------*/
+int print_server_stats(const char *socket_path) // Ask a running server for 'S' and print the table, 0 or -1 (no server)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || write(fd, "S\n", 2) != 2)
+    {
+        close(fd);
+        return -1;
+    }
+    shutdown(fd, SHUT_WR); // One request: the server closes once it is answered
+
+    char reply[STATS_REPORT_SIZE + 64];
+    size_t length = 0;
+    ssize_t got;
+    while (length < sizeof(reply) - 1 && ((got = read(fd, reply + length, sizeof(reply) - 1 - length)) > 0 ||
+                                         (got < 0 && errno == EINTR)))
+        if (got > 0)
+            length += (size_t)got;
+    close(fd);
+    reply[length] = '\0';
+    char *table = strchr(reply, '\n');
+    if (strncmp(reply, "OK ", 3) != 0 || table == NULL)
+        return -1;
+    fputs(table + 1, stdout);
+    return 0;
+}
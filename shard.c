@@ -0,0 +1,621 @@
+/*------------------------------------------------------------------------------
+-> File         : shard.c
+-> Description  : Sharded books: one address book split into N ordinary
+                  books, each in its own directory with its own data.snap,
+                  data.wal and indexes, so a load, save or scan covers one
+                  shard and the shards can be worked on at the same time.
+
+                  A contact's shard comes from its mobile number (a hash
+                  spread evenly) or from its name (ranges of folded names,
+                  split at the quantiles of the book it was made from, so
+                  shard order is name order). The manifest records the
+                  scheme and the split points. It is written last, so a
+                  split cut short leaves no half-made sharded book; a
+                  split that fails removes the shard directories it made,
+                  and a retry takes over empty ones left by a crash.
+
+                  Opening, closing, saving and partial search run every
+                  shard as a job on worker threads (run_workers, one job
+                  per thread, each taking shards t, t + threads, ...); a
+                  shard's own parallel load then gets its share of the
+                  threads. Search results come back best first from each
+                  shard and are merged on the calling thread. Lookups by a
+                  key that does not pick the shard probe every shard's
+                  hash index in turn: N hash probes cost less than waking
+                  N threads. Mobile numbers and mail IDs stay unique
+                  across all shards.
+
+                  A contact whose shard changes on edit is added to the
+                  new shard before it leaves the old one. The move is
+                  first written to a journal next to the manifest, and each
+                  step is synced before the next, so a crash leaves either
+                  the old contact alone, or both copies and the journal. In
+                  that case the next open removes the old copy and clears
+                  the journal, which completes the move.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include fopen, fprintf, fgets, snprintf
+#include <stdlib.h>     // Include memory functions (malloc, calloc, free)
+#include <string.h>     // Include string handling functions (strchr, strcmp, strcspn)
+#include <strings.h>    // Include strcasecmp for name order across shards
+#include <limits.h>     // Include PATH_MAX, INT_MAX
+#include <errno.h>      // Include errno for an existing directory
+#include <unistd.h>     // Include access, close, rmdir
+#include <sys/stat.h>   // Include mkdir
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "shard.h"      // Include sharded book declarations
+#include "workers.h"    // Include the thread-count knob and fork/join helper
+#include "durability.h" // Include sync_file / replace_file for the manifest
+
+#define SHARD_GENERATION 1 // Generation of the snapshots a split writes
+
+struct Shard_map            // Which shard a contact belongs to
+{
+    int count;              // Number of shards
+    int scheme;             // SHARD_BY_MOBILE or SHARD_BY_NAME
+    char bounds[SHARDS_MAX - 1][NAME_KEY_SIZE]; // SHARD_BY_NAME: folded name where shard i + 1 starts
+};
+
+struct Sharded_book
+{
+    struct Shard_map map;
+    char directory[PATH_MAX]; // Where the manifest and the move journal live
+    struct Address_book *shards[SHARDS_MAX]; // One ordinary book per shard
+};
+
+struct Fan_out              // One operation spread over the shards by parallel_shards
+{
+    void (*task)(struct Fan_out *fan, int shard); // Run once per shard, on a worker thread
+    struct Sharded_book *book;
+    int status[SHARDS_MAX]; // Each shard's result, ADDRESSBOOK_OK or an error
+    const char *directory;  // Open, split: the sharded book's directory
+    struct Contact_record *records; // Split: every contact, grouped by shard, each group in name order
+    const struct Text_arena *strings; // Split: their names and mail IDs
+    const int *starts;      // Split: group of shard i is records[starts[i] .. starts[i + 1])
+    const int *identity;    // Split: 0, 1, 2 ... (name order of every group)
+    int made[SHARDS_MAX];   // Split: shard directories this split created, removed again if it fails
+    const char *text;       // Query: search text
+    int wanted;             // Query: hits each shard returns (offset + limit)
+    struct Search_hit *hits[SHARDS_MAX]; // Query: each shard's best hits
+    int found[SHARDS_MAX];  // Query: how many of them
+    int totals[SHARDS_MAX]; // Query: each shard's match count
+};
+
+struct Fan_job              // Shards handled by one worker
+{
+    struct Fan_out *fan;
+    int first, step;        // Shards first, first + step, ...
+};
+
+/*------------------- Placement -------------------*/
+int shard_scheme(const char *name)
+{
+    if (strcmp(name, "mobile") == 0)
+        return SHARD_BY_MOBILE;
+    if (strcmp(name, "name") == 0)
+        return SHARD_BY_NAME;
+    return -1;
+}
+
+static int shard_of(const struct Shard_map *map, const struct Contact_data *contact) // Shard a contact belongs in
+{
+    if (map->scheme == SHARD_BY_MOBILE) // Remixed first: the shard's own hash index uses the low bits of hash_key
+        return (int)(((uint64_t)(uint32_t)(hash_key(contact->Mobile_number) * 0x9E3779B1u) * (uint64_t)map->count) >> 32);
+    char key[NAME_KEY_SIZE];
+    fold_name(key, contact->Name);
+    int low = 0, high = map->count - 1; // First shard whose split point is past the key
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (strcmp(key, map->bounds[mid]) < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+static int shard_path(char *path, const char *directory, int shard, const char *name) // "directory/shard.i[/name]", 0 or -1 if too long
+{
+    int length = snprintf(path, PATH_MAX, "%s/" SHARD_DIRECTORY "%s%s", directory, shard, name ? "/" : "", name ? name : "");
+    return length > 0 && length < PATH_MAX ? 0 : -1;
+}
+
+static int locate(const struct Sharded_book *book, const char *key, int *shard) // Contact with this mobile or mail: index in shard *shard, or -1
+{
+    int mail = strchr(key, '@') != NULL;
+    if (!mail && book->map.scheme == SHARD_BY_MOBILE) // The key picks the shard
+    {
+        struct Contact_data probe = { .Name = "", .Mail_ID = "" };
+        snprintf(probe.Mobile_number, sizeof(probe.Mobile_number), "%s", key);
+        if (strcmp(probe.Mobile_number, key) != 0)
+            return -1; // Longer than any mobile number
+        *shard = shard_of(&book->map, &probe);
+        return find_by_mobile(book->shards[*shard], key);
+    }
+    for (int s = 0; s < book->map.count; s++) // One hash probe per shard
+    {
+        int index = mail ? find_by_mail(book->shards[s], key) : find_by_mobile(book->shards[s], key);
+        if (index != -1)
+        {
+            *shard = s;
+            return index;
+        }
+    }
+    return -1;
+}
+
+static int check_sharded(const struct Sharded_book *book, const struct Contact_data *contact, int shard, int index) // check_change over every shard for storing 'contact' over (shard, index) (-1 = new)
+{
+    int error = VALID;
+    for (int s = 0; s < book->map.count; s++) // A broken rule comes back from every shard; a duplicate mobile wins over a duplicate mail
+    {
+        int found = check_change(book->shards[s], contact, s == shard ? index : -1);
+        if (found != VALID && (error == VALID || found < error))
+            error = found;
+    }
+    return error;
+}
+
+/*------------------- Fan Out -------------------*/
+static void *fan_job(void *arg) // Worker: run the task on each of its shards
+{
+    struct Fan_job *job = arg;
+    for (int s = job->first; s < job->fan->book->map.count; s += job->step)
+        job->fan->task(job->fan, s);
+    return NULL;
+}
+
+static int parallel_shards(struct Fan_out *fan) // Run fan->task on every shard over the worker threads, first error or ADDRESSBOOK_OK
+{
+    int count = fan->book->map.count;
+    int threads = worker_threads() < count ? worker_threads() : count;
+    struct Fan_job jobs[MAX_WORKERS];
+    for (int t = 0; t < threads; t++)
+        jobs[t] = (struct Fan_job){ fan, t, threads };
+    run_workers(fan_job, jobs, sizeof(jobs[0]), threads);
+    for (int s = 0; s < count; s++)
+        if (fan->status[s] != ADDRESSBOOK_OK)
+            return fan->status[s];
+    return ADDRESSBOOK_OK;
+}
+
+static void open_task(struct Fan_out *fan, int shard)
+{
+    char path[PATH_MAX];
+    if (shard_path(path, fan->directory, shard, NULL) != 0)
+        fan->status[shard] = ADDRESSBOOK_BAD_ARGUMENT;
+    else
+        fan->book->shards[shard] = addressbook_open(path, NULL, &fan->status[shard]); // Maps data.snap, replays data.wal
+}
+
+static void close_task(struct Fan_out *fan, int shard)
+{
+    if (fan->book->shards[shard] != NULL)
+        fan->status[shard] = addressbook_close(fan->book->shards[shard]); // Finishes compaction, syncs the log
+    fan->book->shards[shard] = NULL;
+}
+
+static void save_task(struct Fan_out *fan, int shard)
+{
+    struct Address_book *addressbook = fan->book->shards[shard];
+    if (compact_contacts(addressbook) != 0)
+        fan->status[shard] = ADDRESSBOOK_NO_MEMORY;
+    else if (addressbook->wal != NULL && wal_checkpoint(addressbook) != 0)
+        fan->status[shard] = ADDRESSBOOK_IO_ERROR;
+}
+
+static int make_shard_directory(const char *path) // A fresh directory, so there is no old log to replay; 0 or -1
+{
+    if (mkdir(path, 0777) == 0)
+        return 0;
+    return errno == EEXIST && rmdir(path) == 0 && mkdir(path, 0777) == 0 ? 0 : -1; // An empty one is taken over, anything else kept
+}
+
+static void split_task(struct Fan_out *fan, int shard)
+{
+    char path[PATH_MAX];
+    struct Text_arena strings;
+    int first = fan->starts[shard], count = fan->starts[shard + 1] - first;
+    if (shard_path(path, fan->directory, shard, NULL) != 0 || make_shard_directory(path) != 0)
+    {
+        fan->status[shard] = ADDRESSBOOK_IO_ERROR;
+        return;
+    }
+    fan->made[shard] = 1; // Ours from here on: undone if the split fails
+    if (shard_path(path, fan->directory, shard, SNAPSHOT_FILE) != 0 ||
+        pack_strings(fan->records + first, count, fan->strings, &strings) != 0) // Just this shard's strings
+    {
+        fan->status[shard] = ADDRESSBOOK_IO_ERROR;
+        return;
+    }
+    if (write_snapshot(path, fan->records + first, fan->identity, count, &strings, SHARD_GENERATION) != 0)
+        fan->status[shard] = ADDRESSBOOK_IO_ERROR;
+    arena_free(&strings);
+}
+
+static void query_task(struct Fan_out *fan, int shard)
+{
+    fan->hits[shard] = malloc((size_t)(fan->wanted > 0 ? fan->wanted : 1) * sizeof(struct Search_hit));
+    fan->found[shard] = fan->hits[shard] == NULL ? -1 :
+                        text_search(fan->book->shards[shard], fan->text, SEARCH_NAME | SEARCH_MAIL, 0, fan->wanted,
+                                    fan->hits[shard], &fan->totals[shard]); // Builds that shard's trigram index the first time
+    if (fan->found[shard] < 0)
+        fan->status[shard] = ADDRESSBOOK_NO_MEMORY;
+}
+
+/*------------------- Small Files -------------------*/
+static int write_small_file(const char *directory, const char *name, const char *text) // Replace directory/name with 'text' atomically and durably, 0 or -1
+{
+    char path[PATH_MAX], temp[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", directory, name) >= (int)sizeof(path) ||
+        snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return -1;
+    FILE *fp = fopen(temp, "w");
+    if (fp == NULL)
+        return -1;
+    int ok = fputs(text, fp) >= 0;
+    ok = fflush(fp) == 0 && ok;
+    ok = sync_file(fileno(fp)) == 0 && ok;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || replace_file(temp, path) != 0)
+    {
+        remove(temp);
+        return -1;
+    }
+    return 0;
+}
+
+/*------------------- Split -------------------*/
+static void undo_split(const struct Fan_out *fan, int shards) // Remove what a failed split wrote, so it can be retried
+{
+    char path[PATH_MAX];
+    for (int shard = 0; shard < shards; shard++)
+        if (fan->made[shard] && shard_path(path, fan->directory, shard, SNAPSHOT_FILE) == 0)
+        {
+            remove(path);
+            if (shard_path(path, fan->directory, shard, NULL) == 0)
+                rmdir(path);
+        }
+}
+
+static int write_manifest(const char *directory, const struct Shard_map *map) // Last step of a split, 0 or -1
+{
+    char text[32 + (SHARDS_MAX - 1) * (NAME_KEY_SIZE + 1)];
+    int length = snprintf(text, sizeof(text), "#shards %d %s\n", map->count, map->scheme == SHARD_BY_NAME ? "name" : "mobile");
+    for (int i = 0; map->scheme == SHARD_BY_NAME && i < map->count - 1; i++)
+        length += snprintf(text + length, sizeof(text) - length, "%s\n", map->bounds[i]); // Folded names: letters and spaces only
+    return write_small_file(directory, SHARD_MANIFEST, text);
+}
+
+int sharded_split(const struct Address_book *addressbook, const char *directory, int shards, int scheme)
+{
+    if (addressbook == NULL || directory == NULL || shards < 1 || shards > SHARDS_MAX ||
+        (scheme != SHARD_BY_MOBILE && scheme != SHARD_BY_NAME))
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", directory, SHARD_MANIFEST) >= (int)sizeof(path))
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    if ((mkdir(directory, 0777) != 0 && errno != EEXIST) || access(path, F_OK) == 0) // Never over another sharded book
+        return ADDRESSBOOK_IO_ERROR;
+
+    struct Contact_record *records;
+    int *order;
+    struct Text_arena strings;
+    int count = copy_contacts(addressbook, &records, &order, &strings); // Dense, with the name order
+    if (count < 0)
+        return ADDRESSBOOK_NO_MEMORY;
+    struct Sharded_book *book = calloc(1, sizeof(*book)); // Only its map is used
+    struct Contact_record *grouped = malloc((size_t)(count ? count : 1) * sizeof(*grouped));
+    int *owner = malloc((size_t)(count ? count : 1) * sizeof(int));
+    int *identity = malloc((size_t)(count ? count : 1) * sizeof(int));
+    int status = book != NULL && grouped != NULL && owner != NULL && identity != NULL ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+    if (status == ADDRESSBOOK_OK)
+    {
+        book->map.count = shards;
+        book->map.scheme = scheme;
+        for (int i = 1; i < shards && scheme == SHARD_BY_NAME; i++) // Split at the quantiles: shards of equal size
+            if (count > 0)
+                fold_name(book->map.bounds[i - 1], arena_text(&strings, &records[order[(long long)count * i / shards]].name));
+
+        int starts[SHARDS_MAX + 1] = { 0 }, fill[SHARDS_MAX];
+        for (int k = 0; k < count; k++)
+        {
+            const struct Contact_record *record = &records[order[k]];
+            struct Contact_data view = { arena_text(&strings, &record->name), "", arena_text(&strings, &record->mail) };
+            memcpy(view.Mobile_number, record->Mobile_number, sizeof(view.Mobile_number));
+            starts[(owner[k] = shard_of(&book->map, &view)) + 1]++;
+        }
+        for (int s = 0; s < shards; s++)
+            starts[s + 1] += starts[s];
+        memcpy(fill, starts, sizeof(fill));
+        for (int k = 0; k < count; k++) // Walked in name order, so every group comes out sorted
+        {
+            grouped[fill[owner[k]]++] = records[order[k]];
+            identity[k] = k;
+        }
+
+        struct Fan_out fan = { .task = split_task, .book = book, .directory = directory,
+                               .records = grouped, .strings = &strings, .starts = starts, .identity = identity };
+        status = parallel_shards(&fan);
+        if (status == ADDRESSBOOK_OK && write_manifest(directory, &book->map) != 0)
+            status = ADDRESSBOOK_IO_ERROR;
+        if (status != ADDRESSBOOK_OK)
+            undo_split(&fan, shards);
+    }
+    free(records);
+    free(order);
+    arena_free(&strings);
+    free(grouped);
+    free(owner);
+    free(identity);
+    free(book);
+    return status;
+}
+
+/*------------------- Manifest -------------------*/
+static int read_manifest(const char *directory, struct Shard_map *map) // 0 or -1 if missing or malformed
+{
+    char path[PATH_MAX], line[64], scheme[16];
+    if (snprintf(path, sizeof(path), "%s/%s", directory, SHARD_MANIFEST) >= (int)sizeof(path))
+        return -1;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    int ok = fgets(line, sizeof(line), fp) != NULL && sscanf(line, "#shards %d %15s", &map->count, scheme) == 2 &&
+             map->count >= 1 && map->count <= SHARDS_MAX && (map->scheme = shard_scheme(scheme)) >= 0;
+    for (int i = 0; ok && map->scheme == SHARD_BY_NAME && i < map->count - 1; i++)
+    {
+        ok = fgets(line, sizeof(line), fp) != NULL;
+        line[strcspn(line, "\n")] = '\0';
+        ok = ok && strlen(line) < NAME_KEY_SIZE;
+        if (ok)
+            fold_name(map->bounds[i], line); // Zero padded
+    }
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+/*------------------- Move Journal -------------------*/
+static int finish_move(struct Sharded_book *book) // Complete a move a crash cut short, ADDRESSBOOK_OK or an error
+{
+    char path[PATH_MAX], line[128], old_mobile[16], new_mobile[16];
+    if (snprintf(path, sizeof(path), "%s/%s", book->directory, SHARD_JOURNAL) >= (int)sizeof(path))
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return errno == ENOENT ? ADDRESSBOOK_OK : ADDRESSBOOK_IO_ERROR; // No move ever made
+    int from, to;
+    int pending = fgets(line, sizeof(line), fp) != NULL;
+    fclose(fp);
+    if (!pending)
+        return ADDRESSBOOK_OK; // Emptied: the last move completed
+    if (sscanf(line, "#move %d %d %15s %15s", &from, &to, old_mobile, new_mobile) != 4 ||
+        from < 0 || from >= book->map.count || to < 0 || to >= book->map.count || from == to)
+        return ADDRESSBOOK_IO_ERROR;
+
+    int old_index = find_by_mobile(book->shards[from], old_mobile);
+    if (old_index != -1 && find_by_mobile(book->shards[to], new_mobile) != -1) // Both copies made it: drop the old one
+    {
+        remove_contact(book->shards[from], old_index);
+        if (addressbook_sync(book->shards[from]) != ADDRESSBOOK_OK)
+            return ADDRESSBOOK_IO_ERROR;
+    } // Otherwise the new copy never reached the disk: the contact stays where it was
+    return write_small_file(book->directory, SHARD_JOURNAL, "") == 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_IO_ERROR;
+}
+
+static int move_contact(struct Sharded_book *book, int shard, int index, int target, const struct Contact_data *contact) // Add to 'target', then remove from 'shard', journalled, ADDRESSBOOK_OK or an error
+{
+    char journal[128];
+    snprintf(journal, sizeof(journal), "#move %d %d %s %s\n", shard, target,
+             contact_mobile(book->shards[shard], index), contact->Mobile_number);
+    if (write_small_file(book->directory, SHARD_JOURNAL, journal) != 0)
+        return ADDRESSBOOK_IO_ERROR;
+    if (insert_contact(book->shards[target], contact) == -1)
+    {
+        write_small_file(book->directory, SHARD_JOURNAL, ""); // Nothing moved
+        return ADDRESSBOOK_NO_MEMORY;
+    }
+    int status = addressbook_sync(book->shards[target]); // The new copy is on disk before the old one goes
+    remove_contact(book->shards[shard], index);         // Either way: never two copies in memory
+    if (status == ADDRESSBOOK_OK)
+        status = addressbook_sync(book->shards[shard]);
+    if (status == ADDRESSBOOK_OK && write_small_file(book->directory, SHARD_JOURNAL, "") != 0)
+        status = ADDRESSBOOK_IO_ERROR;
+    return status; // On an error the journal stays, and the next open settles the move
+}
+
+/*------------------- Open / Close / Save -------------------*/
+struct Sharded_book *sharded_open(const char *directory, int *error)
+{
+    struct Sharded_book *book = directory != NULL ? calloc(1, sizeof(*book)) : NULL;
+    int status = directory == NULL ? ADDRESSBOOK_BAD_ARGUMENT : book == NULL ? ADDRESSBOOK_NO_MEMORY : ADDRESSBOOK_OK;
+    if (status == ADDRESSBOOK_OK && snprintf(book->directory, sizeof(book->directory), "%s", directory) >= PATH_MAX)
+        status = ADDRESSBOOK_BAD_ARGUMENT;
+    if (status == ADDRESSBOOK_OK && read_manifest(directory, &book->map) != 0)
+        status = ADDRESSBOOK_IO_ERROR;
+    if (status == ADDRESSBOOK_OK)
+    {
+        struct Fan_out fan = { .task = open_task, .book = book, .directory = directory };
+        status = parallel_shards(&fan); // Each shard maps its snapshot and replays its own log
+        if (status == ADDRESSBOOK_OK)
+            status = finish_move(book);
+        if (status != ADDRESSBOOK_OK)
+        {
+            fan.task = close_task; // Shards that did open
+            parallel_shards(&fan);
+        }
+    }
+    if (status != ADDRESSBOOK_OK)
+    {
+        free(book);
+        book = NULL;
+    }
+    if (error != NULL)
+        *error = status;
+    return book;
+}
+
+int sharded_close(struct Sharded_book *book)
+{
+    if (book == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    struct Fan_out fan = { .task = close_task, .book = book };
+    int status = parallel_shards(&fan);
+    free(book);
+    return status;
+}
+
+int sharded_save(struct Sharded_book *book)
+{
+    if (book == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    struct Fan_out fan = { .task = save_task, .book = book };
+    return parallel_shards(&fan);
+}
+
+/*------------------- Changes -------------------*/
+int sharded_insert(struct Sharded_book *book, const struct Contact_data *contact)
+{
+    if (book == NULL || contact == NULL || contact->Name == NULL || contact->Mail_ID == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int error = check_sharded(book, contact, -1, -1);
+    if (error != VALID)
+        return error;
+    return insert_contact(book->shards[shard_of(&book->map, contact)], contact) >= 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+}
+
+int sharded_update(struct Sharded_book *book, const char *key, const struct Contact_data *contact)
+{
+    if (book == NULL || key == NULL || contact == NULL || contact->Name == NULL || contact->Mail_ID == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int shard, index = locate(book, key, &shard);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    int error = check_sharded(book, contact, shard, index);
+    if (error != VALID)
+        return error;
+    int target = shard_of(&book->map, contact);
+    if (target == shard)
+        return update_contact(book->shards[shard], index, contact) == 0 ? ADDRESSBOOK_OK : ADDRESSBOOK_NO_MEMORY;
+    return move_contact(book, shard, index, target, contact); // New mobile or name belongs elsewhere
+}
+
+int sharded_delete(struct Sharded_book *book, const char *key)
+{
+    if (book == NULL || key == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int shard, index = locate(book, key, &shard);
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    remove_contact(book->shards[shard], index);
+    return ADDRESSBOOK_OK;
+}
+
+/*------------------- Lookups -------------------*/
+int sharded_get_by_mobile(const struct Sharded_book *book, const char *mobile_number, struct Contact_data *contact)
+{
+    if (book == NULL || mobile_number == NULL || contact == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int shard, index = strchr(mobile_number, '@') == NULL ? locate(book, mobile_number, &shard) : -1;
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    get_contact(book->shards[shard], index, contact);
+    return ADDRESSBOOK_OK;
+}
+
+int sharded_get_by_mail(const struct Sharded_book *book, const char *mail_id, struct Contact_data *contact)
+{
+    if (book == NULL || mail_id == NULL || contact == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int shard, index = strchr(mail_id, '@') != NULL ? locate(book, mail_id, &shard) : -1;
+    if (index == -1)
+        return ADDRESSBOOK_NOT_FOUND;
+    get_contact(book->shards[shard], index, contact);
+    return ADDRESSBOOK_OK;
+}
+
+int sharded_count(const struct Sharded_book *book)
+{
+    int count = 0;
+    for (int s = 0; book != NULL && s < book->map.count; s++)
+        count += count_contacts(book->shards[s]);
+    return count;
+}
+
+int sharded_shards(const struct Sharded_book *book, int *counts)
+{
+    if (book == NULL)
+        return 0;
+    for (int s = 0; counts != NULL && s < book->map.count; s++)
+        counts[s] = count_contacts(book->shards[s]);
+    return book->map.count;
+}
+
+int sharded_each(const struct Sharded_book *book, int (*visit)(const struct Contact_data *contact, void *context),
+                 void *context) // Name ranges follow each other; hashed shards are merged by name
+{
+    if (book == NULL || visit == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    int count = book->map.count, visited = 0;
+    int at[SHARDS_MAX]; // Next contact of each shard in its name order
+    for (int s = 0; s < count; s++)
+        at[s] = first_contact(book->shards[s]);
+    while (1)
+    {
+        int best = -1;
+        for (int s = 0; s < count && (best == -1 || book->map.scheme == SHARD_BY_MOBILE); s++) // Few shards: a scan beats a heap
+            if (at[s] != -1 && (best == -1 || strcasecmp(contact_name(book->shards[s], at[s]),
+                                                         contact_name(book->shards[best], at[best])) < 0))
+                best = s;
+        if (best == -1)
+            break;
+        visited++;
+        struct Contact_data contact;
+        get_contact(book->shards[best], at[best], &contact);
+        if (visit(&contact, context) != 0)
+            break;
+        at[best] = next_contact(book->shards[best], at[best]);
+    }
+    return visited;
+}
+
+int sharded_query(struct Sharded_book *book, const char *text, int offset, int limit,
+                  struct Contact_data *contacts, int *total)
+{
+    if (book == NULL || text == NULL || offset < 0 || limit < 0 || offset > INT_MAX - limit ||
+        (limit > 0 && contacts == NULL) || total == NULL)
+        return ADDRESSBOOK_BAD_ARGUMENT;
+    struct Fan_out fan = { .task = query_task, .book = book, .text = text, .wanted = offset + limit };
+    int status = parallel_shards(&fan); // Every shard's top offset + limit, best first
+    int count = book->map.count, written = 0, seen = 0;
+    int at[SHARDS_MAX] = { 0 };
+    *total = 0;
+    for (int s = 0; s < count; s++)
+        *total += fan.found[s] >= 0 ? fan.totals[s] : 0;
+    while (status == ADDRESSBOOK_OK && written < limit) // Merge by rank, then name, as text_search orders one book
+    {
+        int best = -1;
+        for (int s = 0; s < count; s++)
+        {
+            if (at[s] >= fan.found[s])
+                continue;
+            if (best != -1)
+            {
+                const struct Search_hit *x = &fan.hits[s][at[s]], *y = &fan.hits[best][at[best]];
+                if (x->rank > y->rank || (x->rank == y->rank &&
+                    strcasecmp(contact_name(book->shards[s], x->index),
+                               contact_name(book->shards[best], y->index)) >= 0))
+                    continue;
+            }
+            best = s;
+        }
+        if (best == -1)
+            break;
+        if (seen++ >= offset)
+            get_contact(book->shards[best], fan.hits[best][at[best]].index, &contacts[written++]);
+        at[best]++;
+    }
+    for (int s = 0; s < count; s++)
+        free(fan.hits[s]);
+    return status == ADDRESSBOOK_OK ? written : status;
+}
@@ -0,0 +1,43 @@
+#ifndef SHARD_H             // Header guard start, prevents multiple inclusion
+#define SHARD_H
+
+#include "addressbook.h"    // Result codes and struct Contact_data
+
+/* Sharded books (shard.c), part of libaddressbook. A sharded book is a directory
+   holding a manifest and one ordinary book per shard ("shard.0" ...), each with its
+   own data.snap, data.wal and indexes. Results are those of addressbook.h. One
+   thread at a time per sharded book; the library spreads the shards over threads. */
+
+#define SHARD_BY_MOBILE 0           // Shard = hash of the mobile number
+#define SHARD_BY_NAME 1             // Shard = range of folded names (split points in the manifest)
+#define SHARDS_MAX 64               // Most shards in one book
+#define SHARD_MANIFEST "shards"     // Shard count, scheme and split points, written last
+#define SHARD_JOURNAL "shards.move" // Contact being moved between shards, empty when none
+#define SHARD_DIRECTORY "shard.%d"  // Directory of shard i
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Sharded_book;        // Opaque, defined in shard.c
+
+/*------------------ Function Declarations ------------------*/
+
+int shard_scheme(const char *name); // "mobile" or "name" to SHARD_BY_MOBILE ..., or -1
+int sharded_split(const struct Address_book *addressbook, const char *directory, int shards, int scheme); // Write the book as a new sharded book in 'directory', shards in parallel; ADDRESSBOOK_OK or an error
+struct Sharded_book *sharded_open(const char *directory, int *error); // Open every shard in parallel, NULL and *error on failure
+int sharded_close(struct Sharded_book *book); // Make every change durable and free the book, shards in parallel
+int sharded_save(struct Sharded_book *book); // Compact every shard and write it as a fresh snapshot, in parallel
+
+int sharded_insert(struct Sharded_book *book, const struct Contact_data *contact); // Add to the contact's shard (unique across all), ADDRESSBOOK_OK, a validate.h code or an error
+int sharded_update(struct Sharded_book *book, const char *key, const struct Contact_data *contact); // Replace the contact with this mobile or mail, moving it if its shard changes
+int sharded_delete(struct Sharded_book *book, const char *key); // Delete the contact with this mobile or mail, ADDRESSBOOK_OK or ADDRESSBOOK_NOT_FOUND
+
+int sharded_get_by_mobile(const struct Sharded_book *book, const char *mobile_number, struct Contact_data *contact); // Fill in the contact (pointing into its shard), ADDRESSBOOK_OK or ADDRESSBOOK_NOT_FOUND
+int sharded_get_by_mail(const struct Sharded_book *book, const char *mail_id, struct Contact_data *contact); // Same, by mail ID
+int sharded_count(const struct Sharded_book *book); // Contacts in all shards
+int sharded_shards(const struct Sharded_book *book, int *counts); // Number of shards; their contact counts in 'counts' unless NULL
+int sharded_each(const struct Sharded_book *book, int (*visit)(const struct Contact_data *contact, void *context),
+                 void *context); // Visit all contacts in name order (shards merged) until 'visit' returns non-zero, contacts visited
+int sharded_query(struct Sharded_book *book, const char *text, int offset, int limit,
+                  struct Contact_data *contacts, int *total); // addressbook_query on every shard in parallel, merged best first; written or an error
+
+#endif // SHARD_H            // End of header guard
@@ -0,0 +1,418 @@
+/*------------------------------------------------------------------------------
+-> File         : shared.c
+-> Description  : Thread-safe access to one address book: any number of
+                  reader threads, one writer at a time.
+
+                  The book is kept twice (left-right). Readers use the
+                  published copy and never wait: entering a read is one
+                  atomic increment on a per-thread stripe of counters. The
+                  writer changes the idle copy with the ordinary store
+                  functions (insert_contact, update_contact, ...), publishes
+                  it, waits for the grace period (every read still inside
+                  the old copy finishes), then applies the same change to
+                  the old copy, which becomes the idle one. Memory the
+                  store frees or reallocates is never touched by a reader,
+                  so there is nothing to reclaim later.
+
+                  Reads copy contacts out before they leave, because a
+                  contact index is only meaningful inside one copy; their
+                  names and mail IDs go to a buffer of the reading thread,
+                  kept until that thread's next read. Writes
+                  name contacts by mobile number or mail ID. The change log
+                  records every change once, from the first copy it is
+                  applied to. Memory is twice that of one book.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (aligned_alloc, malloc, free)
+#include <string.h>     // Include string handling functions (memset, strcmp)
+#include <strings.h>    // Include strcasecmp for names in any case
+#include <sched.h>      // Include sched_yield for the grace period
+#include "shared.h"     // Include the shared book declarations
+
+#define SHARED_INSERT 1 // Change kinds, applied the same way to both copies
+#define SHARED_UPDATE 2
+#define SHARED_REMOVE 3
+#define SHARED_REMOVE_ALL 4
+
+struct Shared_change        // One write, replayed on the second copy
+{
+    int kind;               // SHARED_INSERT ...
+    const char *key;        // Mobile number or mail ID (update, remove)
+    const struct Contact_data *contact; // New values (insert, update)
+    const char *const *keys; // Keys and their count (remove all)
+    int count;
+};
+
+struct Read_buffer          // Names and mail IDs of the contacts a thread last read
+{
+    char *bytes;
+    size_t capacity;
+};
+
+static _Thread_local int thread_stripe = -1; // Counter stripe of this thread
+static atomic_int next_stripe;              // Hands out stripes round-robin
+static pthread_key_t buffer_key;            // Each thread's struct Read_buffer, freed when the thread ends
+static pthread_once_t buffer_once = PTHREAD_ONCE_INIT;
+
+/*------------------- Copies -------------------*/
+static int prepare_reads(struct Address_book *book) // Readers must not build anything lazily, 0 or -1
+{
+    if (book->text_index == NULL)
+        book->text_index = text_index_build(book);
+    if (book->phonetic_index == NULL)
+        book->phonetic_index = phonetic_index_build(book);
+    return book->text_index == NULL || book->phonetic_index == NULL ? -1 : 0;
+}
+
+static int copy_book(struct Address_book *copy, const struct Address_book *book) // Fresh copy of the live contacts, 0 or -1
+{
+    struct Contact_record *records;
+    int *order;
+    init_address_book(copy);
+    int count = copy_contacts(book, &records, &order, &copy->strings);
+    if (count < 0)
+        return -1;
+    copy->contact_details = records;
+    copy->contact_count = count;
+    copy->capacity = count;
+    int status = rebuild_indexes_in_order(copy, order);
+    free(order);
+    if (status != 0)
+        destroy_address_book(copy);
+    else
+        prepare_reads(copy); // Best effort, see shared_search
+    return status;
+}
+
+/*------------------- Open / Close -------------------*/
+struct Shared_book *shared_book_open(struct Address_book *addressbook) // The caller's book becomes copies[0]
+{
+    size_t size = (sizeof(struct Shared_book) + 63) / 64 * 64; // aligned_alloc wants a multiple of the alignment
+    struct Shared_book *shared = aligned_alloc(64, size); // Stripes on their own cache lines
+    if (shared == NULL)
+        return NULL;
+    memset(shared, 0, size);
+    if (prepare_reads(addressbook) != 0 || copy_book(&shared->copies[1], addressbook) != 0)
+    {
+        free(shared);
+        return NULL;
+    }
+    shared->copies[0] = *addressbook;
+    shared->wal = shared->copies[0].wal; // Lent per change from now on
+    shared->copies[0].wal = NULL;
+    atomic_init(&shared->published, 0);
+    pthread_mutex_init(&shared->writer, NULL);
+    init_address_book(addressbook); // Owned by 'shared' until close
+    return shared;
+}
+
+void shared_book_close(struct Shared_book *shared, struct Address_book *addressbook) // Hand back the published copy with the change log
+{
+    int published = atomic_load(&shared->published);
+    *addressbook = shared->copies[published];
+    addressbook->wal = shared->wal;
+    destroy_address_book(&shared->copies[1 - published]);
+    pthread_mutex_destroy(&shared->writer);
+    free(shared);
+}
+
+/*------------------- Readers -------------------*/
+static int enter(struct Shared_book *shared) // Announce a read, return the copy it may use
+{
+    if (thread_stripe < 0)
+        thread_stripe = atomic_fetch_add(&next_stripe, 1) % READER_STRIPES;
+    struct Reader_stripe *stripe = &shared->stripes[thread_stripe];
+    for (;;)
+    {
+        int copy = atomic_load(&shared->published);
+        atomic_fetch_add(&stripe->inside[copy], 1);
+        if (atomic_load(&shared->published) == copy) // Still published: the writer will wait for us
+            return copy;
+        atomic_fetch_sub(&stripe->inside[copy], 1); // Writer switched copies meanwhile, take the new one
+    }
+}
+
+static void free_buffer(void *buffer)
+{
+    free(((struct Read_buffer *)buffer)->bytes);
+    free(buffer);
+}
+
+static void make_buffer_key(void)
+{
+    pthread_key_create(&buffer_key, free_buffer);
+}
+
+static int copy_strings(struct Contact_data *contacts, int count) // Point the contacts at this thread's copy of their strings, 0 or -1
+{
+    pthread_once(&buffer_once, make_buffer_key);
+    struct Read_buffer *buffer = pthread_getspecific(buffer_key);
+    if (buffer == NULL)
+    {
+        buffer = calloc(1, sizeof(*buffer));
+        if (buffer == NULL || pthread_setspecific(buffer_key, buffer) != 0)
+        {
+            free(buffer);
+            return -1;
+        }
+    }
+    size_t size = 0;
+    for (int i = 0; i < count; i++)
+        size += strlen(contacts[i].Name) + strlen(contacts[i].Mail_ID) + 2;
+    if (size > buffer->capacity) // The previous read's strings are given up here
+    {
+        char *bytes = realloc(buffer->bytes, size);
+        if (bytes == NULL)
+            return -1;
+        buffer->bytes = bytes;
+        buffer->capacity = size;
+    }
+    char *at = buffer->bytes;
+    for (int i = 0; i < count; i++)
+    {
+        size_t name = strlen(contacts[i].Name) + 1, mail = strlen(contacts[i].Mail_ID) + 1;
+        contacts[i].Name = memcpy(at, contacts[i].Name, name);
+        contacts[i].Mail_ID = memcpy(at + name, contacts[i].Mail_ID, mail);
+        at += name + mail;
+    }
+    return 0;
+}
+
+static void leave(struct Shared_book *shared, int copy) // Read finished, nothing of 'copy' is used any more
+{
+    atomic_fetch_sub_explicit(&shared->stripes[thread_stripe].inside[copy], 1, memory_order_release);
+}
+
+int shared_find_by_mobile(struct Shared_book *shared, const char *mobile_number, struct Contact_data *contact)
+{
+    int copy = enter(shared);
+    const struct Address_book *book = &shared->copies[copy];
+    int index = find_by_mobile(book, mobile_number);
+    if (index != -1)
+    {
+        get_contact(book, index, contact);
+        if (copy_strings(contact, 1) != 0)
+            index = -2;
+    }
+    leave(shared, copy);
+    return index == -2 ? -1 : index != -1;
+}
+
+int shared_find_by_mail(struct Shared_book *shared, const char *mail_id, struct Contact_data *contact)
+{
+    int copy = enter(shared);
+    const struct Address_book *book = &shared->copies[copy];
+    int index = find_by_mail(book, mail_id);
+    if (index != -1)
+    {
+        get_contact(book, index, contact);
+        if (copy_strings(contact, 1) != 0)
+            index = -2;
+    }
+    leave(shared, copy);
+    return index == -2 ? -1 : index != -1;
+}
+
+int shared_find_by_name(struct Shared_book *shared, const char *name, struct Contact_data *contacts, int limit)
+{
+    int copy = enter(shared);
+    const struct Address_book *book = &shared->copies[copy];
+    int total = 0;
+    int first = find_by_name(book, name);
+    if (first != -1)
+    {
+        const char *found = contact_name(book, first); // Every contact with this name (any case) sits together
+        for (int i = first; i != -1 && strcasecmp(contact_name(book, i), found) == 0;
+             i = next_contact(book, i))
+        {
+            if (total < limit)
+                get_contact(book, i, &contacts[total]);
+            total++;
+        }
+    }
+    if (copy_strings(contacts, total < limit ? total : limit) != 0)
+        total = -1;
+    leave(shared, copy);
+    return total;
+}
+
+int shared_search(struct Shared_book *shared, const char *query, int fields, int offset, int limit,
+                  struct Contact_data *contacts, int *total)
+{
+    struct Search_hit *hits = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(*hits));
+    if (hits == NULL)
+        return -1;
+    int copy = enter(shared);
+    struct Address_book *book = &shared->copies[copy];
+    int found = -1;
+    *total = 0;
+    if (book->text_index != NULL) // Built by the writer; building it here would race with other readers
+        found = text_search(book, query, fields, offset, limit, hits, total);
+    for (int i = 0; i < found; i++)
+        get_contact(book, hits[i].index, &contacts[i]);
+    if (found > 0 && copy_strings(contacts, found) != 0)
+        found = -1;
+    leave(shared, copy);
+    free(hits);
+    return found;
+}
+
+int shared_fuzzy(struct Shared_book *shared, const char *name, int max_distance, int limit,
+                 struct Contact_data *contacts, int *total)
+{
+    struct Search_hit *hits = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(*hits));
+    if (hits == NULL)
+        return -1;
+    int copy = enter(shared);
+    struct Address_book *book = &shared->copies[copy];
+    int found = -1;
+    *total = 0;
+    if (book->text_index != NULL) // Same trigram index as shared_search
+        found = fuzzy_search(book, name, max_distance, 0, limit, hits, total);
+    for (int i = 0; i < found; i++)
+        get_contact(book, hits[i].index, &contacts[i]);
+    if (found > 0 && copy_strings(contacts, found) != 0)
+        found = -1;
+    leave(shared, copy);
+    free(hits);
+    return found;
+}
+
+int shared_sounds_like(struct Shared_book *shared, const char *name, int max_distance, int limit,
+                       struct Contact_data *contacts, int *total)
+{
+    struct Search_hit *hits = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(*hits));
+    if (hits == NULL)
+        return -1;
+    int copy = enter(shared);
+    struct Address_book *book = &shared->copies[copy];
+    int found = -1;
+    *total = 0;
+    if (book->phonetic_index != NULL) // Built by the writer, like the trigram index
+        found = phonetic_search(book, name, max_distance, 0, limit, hits, total);
+    for (int i = 0; i < found; i++)
+        get_contact(book, hits[i].index, &contacts[i]);
+    if (found > 0 && copy_strings(contacts, found) != 0)
+        found = -1;
+    leave(shared, copy);
+    free(hits);
+    return found;
+}
+
+int shared_count(struct Shared_book *shared)
+{
+    int copy = enter(shared);
+    int count = count_contacts(&shared->copies[copy]);
+    leave(shared, copy);
+    return count;
+}
+
+/*------------------- Writer -------------------*/
+static int apply_change(struct Address_book *book, const struct Shared_change *change, int *changed) // Same result on either copy
+{
+    *changed = 0;
+    if (change->kind == SHARED_INSERT)
+    {
+        int error = check_change(book, change->contact, -1); // Same rules as addressbook_insert
+        if (error != VALID)
+            return error;
+        if (insert_contact(book, change->contact) == -1)
+            return -1; // Out of memory, nothing changed
+        *changed = 1;
+        return VALID;
+    }
+    if (change->kind == SHARED_UPDATE)
+    {
+        int index = find_by_key(book, change->key);
+        if (index == -1)
+            return -1;
+        int error = check_change(book, change->contact, index);
+        if (error != VALID)
+            return error;
+        if (update_contact(book, index, change->contact) != 0)
+            return -1; // Out of memory, nothing changed
+        *changed = 1;
+        return VALID;
+    }
+    if (change->kind == SHARED_REMOVE)
+    {
+        int index = find_by_key(book, change->key);
+        if (index == -1)
+            return 0;
+        remove_contact(book, index);
+        *changed = 1;
+        return 1;
+    }
+    int removed = remove_contacts(book, change->keys, change->count);
+    *changed = removed > 0;
+    return removed;
+}
+
+static void wait_for_readers(struct Shared_book *shared, int copy) // Grace period: every read inside 'copy' has left
+{
+    for (int s = 0; s < READER_STRIPES; s++)
+        while (atomic_load(&shared->stripes[s].inside[copy]) != 0)
+            sched_yield();
+}
+
+static int write_change(struct Shared_book *shared, const struct Shared_change *change) // Apply to the idle copy, publish, then catch up the other
+{
+    pthread_mutex_lock(&shared->writer);
+    if (shared->broken)
+    {
+        pthread_mutex_unlock(&shared->writer);
+        return -1;
+    }
+    int published = atomic_load(&shared->published), idle = 1 - published;
+    int changed;
+    shared->copies[idle].wal = shared->wal; // Logged once, by the copy readers see first
+    int result = apply_change(&shared->copies[idle], change, &changed);
+    shared->copies[idle].wal = NULL;
+    if (changed)
+    {
+        prepare_reads(&shared->copies[idle]);
+        atomic_store(&shared->published, idle);
+        wait_for_readers(shared, published);
+        int again = apply_change(&shared->copies[published], change, &changed);
+        prepare_reads(&shared->copies[published]);
+        if (again != result) // Out of memory half way: rebuild the stale copy from the published one
+        {
+            destroy_address_book(&shared->copies[published]);
+            if (copy_book(&shared->copies[published], &shared->copies[idle]) != 0)
+            {
+                report_problem("Error: not enough memory to keep the shared book in step, writes are refused\n");
+                shared->broken = 1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&shared->writer);
+    return result;
+}
+
+int shared_insert(struct Shared_book *shared, const struct Contact_data *contact)
+{
+    if (contact->Name == NULL || contact->Mail_ID == NULL)
+        return -1;
+    struct Shared_change change = { SHARED_INSERT, NULL, contact, NULL, 0 };
+    return write_change(shared, &change);
+}
+
+int shared_update(struct Shared_book *shared, const char *key, const struct Contact_data *contact)
+{
+    if (contact->Name == NULL || contact->Mail_ID == NULL)
+        return -1;
+    struct Shared_change change = { SHARED_UPDATE, key, contact, NULL, 0 };
+    return write_change(shared, &change);
+}
+
+int shared_remove(struct Shared_book *shared, const char *key)
+{
+    struct Shared_change change = { SHARED_REMOVE, key, NULL, NULL, 0 };
+    return write_change(shared, &change);
+}
+
+int shared_remove_all(struct Shared_book *shared, const char *const *keys, int count)
+{
+    struct Shared_change change = { SHARED_REMOVE_ALL, NULL, NULL, keys, count };
+    return write_change(shared, &change);
+}
@@ -0,0 +1,52 @@
+#ifndef SHARED_H            // Header guard start, prevents multiple inclusion
+#define SHARED_H
+
+#include <pthread.h>        // Writer lock
+#include <stdatomic.h>      // Published copy and reader counters
+#include "contact.h"        // struct Address_book, struct Contact_data
+
+#define READER_STRIPES 64   // Reader counters, one cache line each, picked per thread
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Reader_stripe        // Readers currently inside each copy (one cache line, so threads do not share it)
+{
+    atomic_long inside[2];
+    char padding[64 - 2 * sizeof(atomic_long)];
+};
+
+struct Shared_book          // Two copies of one book: readers use the published one, the writer changes the other
+{
+    struct Address_book copies[2]; // copies[0] starts as the book handed to shared_book_open
+    struct Wal *wal;        // Its change log, lent to whichever copy a change is applied to first
+    atomic_int published;   // Copy new readers enter
+    pthread_mutex_t writer; // Serializes writers
+    int broken;             // Copies could not be brought back in step (out of memory), writes refused
+    struct Reader_stripe stripes[READER_STRIPES];
+};
+
+/*------------------ Function Declarations ------------------*/
+
+struct Shared_book *shared_book_open(struct Address_book *addressbook); // Take over an indexed book and build its second copy, NULL if out of memory
+void shared_book_close(struct Shared_book *shared, struct Address_book *addressbook); // Give the current copy back (no thread may still use 'shared'), free the rest
+
+/* Readers: never block, and see every write that returned before they started. The names and mail IDs
+   of the contacts copied out stay valid until the same thread reads again */
+int shared_find_by_mobile(struct Shared_book *shared, const char *mobile_number, struct Contact_data *contact); // Copy out the contact, 1 if found, 0 if not, -1 out of memory
+int shared_find_by_mail(struct Shared_book *shared, const char *mail_id, struct Contact_data *contact); // Copy out the contact, 1 if found, 0 if not, -1 out of memory
+int shared_find_by_name(struct Shared_book *shared, const char *name, struct Contact_data *contacts, int limit); // Every contact with this name (any case), up to 'limit' copied, total returned or -1 (out of memory)
+int shared_search(struct Shared_book *shared, const char *query, int fields, int offset, int limit,
+                  struct Contact_data *contacts, int *total); // Ranked partial search (text_search), contacts written or -1 (out of memory)
+int shared_fuzzy(struct Shared_book *shared, const char *name, int max_distance, int limit,
+                 struct Contact_data *contacts, int *total); // Closest names (fuzzy_search), contacts written or -1 (out of memory)
+int shared_sounds_like(struct Shared_book *shared, const char *name, int max_distance, int limit,
+                       struct Contact_data *contacts, int *total); // Sound-alike names (phonetic_search), contacts written or -1 (out of memory)
+int shared_count(struct Shared_book *shared); // Number of contacts
+
+/* Writers: one at a time, each change is applied to both copies */
+int shared_insert(struct Shared_book *shared, const struct Contact_data *contact); // VALID, a validate.h error code, or -1 out of memory
+int shared_update(struct Shared_book *shared, const char *key, const struct Contact_data *contact); // Replace the contact with this mobile or mail, VALID, error code, or -1 if missing/out of memory
+int shared_remove(struct Shared_book *shared, const char *key); // Delete the contact with this mobile or mail, 1 if deleted else 0
+int shared_remove_all(struct Shared_book *shared, const char *const *keys, int count); // Bulk delete (remove_contacts), how many deleted
+
+#endif // SHARED_H           // End of header guard
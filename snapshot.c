@@ -0,0 +1,318 @@
+/*------------------------------------------------------------------------------
+-> File         : snapshot.c
+-> Description  : Binary snapshot of the address book (data.snap).
+                  Layout: an 80-byte header, the contact records exactly as
+                  struct Contact_record lays them out in memory, the name
+                  order as one int per contact, then the string arena the
+                  records' long names and mail IDs point into. Only live
+                  strings are written (copy_contacts packs them), so a
+                  snapshot or change log compaction also drops the arena's
+                  garbage. A 64-bit checksum covers records, order and
+                  strings. The header also carries the generation of the
+                  change log the snapshot was folded from (wal.c).
+
+                  open_snapshot maps the file copy-on-write and points
+                  contact_details and the book's arena straight into the
+                  mapping, so nothing is parsed or copied: the only O(n)
+                  work is the checksum, the bounds check of every string
+                  and building the indexes, and the name index is linked
+                  in O(n) from the stored order. Edits only dirty the
+                  pages they touch; the first append that needs room
+                  copies the records to the heap, and the first long
+                  string stored copies the arena (see store.c).
+
+                  save_snapshot writes a temporary file and renames it over
+                  the old one, so a book still mapped from the old file keeps
+                  valid pages and a failed save leaves the old file intact.
+                  How hard it is flushed follows the durability level.
+                  data.txt stays the import/export format (loader.c,
+                  export_contacts).
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (fopen, fwrite, rename)
+#include <stdlib.h>     // Include memory functions (malloc, free)
+#include <string.h>     // Include string handling functions (memcmp, memcpy, memchr)
+#include <stdint.h>     // Include fixed-width integers for the on-disk header
+#include <fcntl.h>      // Include open
+#include <unistd.h>     // Include close
+#include <sys/mman.h>   // Include mmap
+#include <sys/stat.h>   // Include fstat to size the file
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "durability.h" // Include sync_file / replace_file
+#include "stats.h"      // Include operation counters
+
+#define SNAPSHOT_MAGIC "ABKSNAP"   // First 8 bytes of every snapshot (with the NUL)
+#define SNAPSHOT_VERSION 2         // Bumped whenever the layout changes
+#define SNAPSHOT_BYTE_ORDER 0x01020304u // Reads back differently on a machine of the other endianness
+
+struct Snapshot_header          // First 80 bytes of the file
+{
+    char magic[8];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t byte_order;        // SNAPSHOT_BYTE_ORDER as written by this machine
+    uint32_t record_size;       // sizeof(struct Contact_record) of the writer
+    uint32_t count;             // Number of contacts
+    uint64_t records_offset;    // Where the records start
+    uint64_t order_offset;      // Where the name order starts (count ints)
+    uint64_t strings_offset;    // Where the string arena starts, right after the order
+    uint64_t strings_size;      // Its length in bytes
+    uint64_t file_size;         // Total size, catches truncated files
+    uint64_t checksum;          // snapshot_checksum of records, order, then strings
+    uint64_t generation;        // Change log records older than this are already in the records
+};
+
+/*------------------- Checksum -------------------*/
+uint64_t snapshot_checksum(uint64_t state, const void *data, size_t length) // Mix 'length' bytes into 'state'
+{
+    const unsigned char *p = data;
+    uint64_t lane[4] = { state, state ^ 0x9e3779b97f4a7c15ull, state + 1, ~state }; // Four independent lanes
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) // 8 bytes per lane per step, multiply-xor mixing
+    {
+        for (int l = 0; l < 4; l++)
+        {
+            uint64_t word;
+            memcpy(&word, p + i + 8 * l, 8);
+            lane[l] = (lane[l] ^ word) * 0x100000001b3ull;
+            lane[l] ^= lane[l] >> 29;
+        }
+    }
+    uint64_t hash = lane[0] ^ (lane[1] * 3) ^ (lane[2] * 5) ^ (lane[3] * 7) ^ length;
+    for (; i < length; i++) // Tail, FNV-1a
+        hash = (hash ^ p[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+static uint64_t records_offset(void) // Records start right after the header
+{
+    return sizeof(struct Snapshot_header);
+}
+
+static uint64_t order_offset(uint64_t count) // Order starts after the records, int-aligned
+{
+    uint64_t end = records_offset() + count * sizeof(struct Contact_record);
+    return (end + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+/*------------------- Save Snapshot -------------------*/
+int write_snapshot(const char *path, const struct Contact_record *records, const int *order, int count,
+                   const struct Text_arena *strings, uint64_t generation) // 0 or -1
+{
+    struct Snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.record_size = sizeof(struct Contact_record);
+    header.count = (uint32_t)count;
+    header.records_offset = records_offset();
+    header.order_offset = order_offset(count);
+    header.strings_offset = header.order_offset + (uint64_t)count * sizeof(int);
+    header.strings_size = strings->used;
+    header.file_size = header.strings_offset + header.strings_size;
+    header.generation = generation;
+    size_t records_size = (size_t)count * sizeof(struct Contact_record);
+    size_t gap = (size_t)(header.order_offset - header.records_offset - records_size); // Alignment padding
+    static const char zeros[sizeof(int)];
+    header.checksum = snapshot_checksum(snapshot_checksum(snapshot_checksum(0, records, records_size),
+                                                          order, (size_t)count * sizeof(int)),
+                                        strings->bytes, strings->used);
+
+    char temp[4096];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return -1;
+    FILE *fp = fopen(temp, "wb");
+    if (fp == NULL)
+        return -1;
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             (count == 0 || fwrite(records, records_size, 1, fp) == 1) &&
+             (gap == 0 || fwrite(zeros, gap, 1, fp) == 1) &&
+             (count == 0 || fwrite(order, (size_t)count * sizeof(int), 1, fp) == 1) &&
+             (strings->used == 0 || fwrite(strings->bytes, strings->used, 1, fp) == 1);
+    ok = fflush(fp) == 0 && ok;
+    ok = sync_file(fileno(fp)) == 0 && ok; // The change log is trimmed once this file is in place
+    ok = fclose(fp) == 0 && ok;
+
+    if (!ok || replace_file(temp, path) != 0) // Replace the old snapshot in one step
+    {
+        remove(temp);
+        return -1;
+    }
+    stats_add(COUNT_BYTES_WRITTEN, header.file_size);
+    return 0;
+}
+
+int *name_order(const struct Address_book *addressbook) // Contacts in name order, malloc'd, NULL if out of memory
+{
+    int count = count_contacts(addressbook); // Deleted slots are not in the name index
+    int *order = malloc((size_t)(count ? count : 1) * sizeof(int));
+    if (order == NULL)
+        return NULL;
+    int k = 0;
+    for (int i = first_contact(addressbook); i != -1 && k < count; i = next_contact(addressbook, i))
+        order[k++] = i;
+    if (k != count) // Index out of step with the records: store array order, it is re-sorted on open
+    {
+        k = 0;
+        for (int i = 0; i < addressbook->contact_count && k < count; i++)
+            if (!contact_deleted(addressbook, i))
+                order[k++] = i;
+    }
+    return order;
+}
+
+int copy_contacts(const struct Address_book *addressbook, struct Contact_record **records, int **order,
+                  struct Text_arena *strings) // Dense copy of the live contacts, count or -1
+{
+    int count = count_contacts(addressbook);
+    *order = name_order(addressbook);
+    *records = malloc((size_t)(count ? count : 1) * sizeof(struct Contact_record));
+    if (*order == NULL || *records == NULL)
+    {
+        free(*order);
+        free(*records);
+        return -1;
+    }
+    if (addressbook->deleted_count == 0) // Same layout as the book
+        memcpy(*records, addressbook->contact_details, (size_t)count * sizeof(struct Contact_record));
+    else
+        for (int k = 0; k < count; k++) // Tombstones to skip: copy in name order, which makes the order trivial
+        {
+            (*records)[k] = addressbook->contact_details[(*order)[k]];
+            (*order)[k] = k;
+        }
+    if (pack_strings(*records, count, &addressbook->strings, strings) != 0) // Only the strings of live contacts
+    {
+        free(*order);
+        free(*records);
+        return -1;
+    }
+    return count;
+}
+
+static int save_live_records(const struct Address_book *addressbook, const char *path, uint64_t generation) // Write the whole book, 0 or -1
+{
+    if (addressbook->deleted_count > 0 || addressbook->strings.garbage > 0) // Deleted slots and dropped strings must not reach the file
+    {
+        struct Contact_record *records;
+        int *order;
+        struct Text_arena strings;
+        int count = copy_contacts(addressbook, &records, &order, &strings);
+        if (count < 0)
+            return -1;
+        int status = write_snapshot(path, records, order, count, &strings, generation);
+        free(records);
+        free(order);
+        arena_free(&strings);
+        return status;
+    }
+    int *order = name_order(addressbook);
+    if (order == NULL)
+        return -1;
+    int status = write_snapshot(path, addressbook->contact_details, order, addressbook->contact_count,
+                                &addressbook->strings, generation);
+    free(order);
+    return status;
+}
+
+int save_snapshot(const struct Address_book *addressbook, const char *path, uint64_t generation) // Timed save_live_records
+{
+    uint64_t start = stats_begin();
+    int status = save_live_records(addressbook, path, generation);
+    stats_end(STAT_SAVE_SNAPSHOT, start);
+    return status;
+}
+
+/*------------------- Open Snapshot -------------------*/
+static int check_slot(const union Text_slot *slot, const char *strings, uint64_t size) // String inside the arena, NUL where its length says?
+{
+    if (!slot->far.tag) // Inline: the tag byte is its NUL
+        return 0;
+    uint64_t length = arena_length(slot);
+    if (slot->far.offset + length >= size || strings[slot->far.offset + length] != '\0' ||
+        memchr(strings + slot->far.offset, '\0', (size_t)length) != NULL)
+        return -1;
+    return 0;
+}
+
+static int check_fields(const struct Contact_record *records, int count, const char *strings, uint64_t size) // Every field NUL-terminated where it is kept?
+{
+    for (int i = 0; i < count; i++)
+        if (memchr(records[i].Mobile_number, '\0', sizeof(records[i].Mobile_number)) == NULL ||
+            check_slot(&records[i].name, strings, size) != 0 || check_slot(&records[i].mail, strings, size) != 0)
+            return -1;
+    return 0;
+}
+
+static int map_snapshot(const char *path, struct Address_book *addressbook, uint64_t *generation) // Serve an empty book from a mapped snapshot, 0 or -1
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size < sizeof(struct Snapshot_header))
+    {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0); // Private: edits never reach the file
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    madvise(map, size, MADV_WILLNEED);
+
+    struct Snapshot_header header;
+    memcpy(&header, map, sizeof(header));
+    int valid = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+                header.version == SNAPSHOT_VERSION &&
+                header.byte_order == SNAPSHOT_BYTE_ORDER &&
+                header.record_size == sizeof(struct Contact_record) &&
+                header.count <= (uint32_t)(INT32_MAX) &&
+                header.records_offset == records_offset() &&
+                header.order_offset == order_offset(header.count) &&
+                header.strings_offset == header.order_offset + (uint64_t)header.count * sizeof(int) &&
+                header.strings_size <= UINT32_MAX &&
+                header.file_size == header.strings_offset + header.strings_size &&
+                header.file_size == (uint64_t)size;
+    int count = (int)header.count;
+    struct Contact_record *records = (struct Contact_record *)(map + header.records_offset);
+    const int *order = (const int *)(map + header.order_offset);
+    char *strings = map + header.strings_offset;
+
+    if (valid)
+        valid = snapshot_checksum(snapshot_checksum(snapshot_checksum(0, records, (size_t)count * sizeof(struct Contact_record)),
+                                                    order, (size_t)count * sizeof(int)),
+                                  strings, (size_t)header.strings_size) == header.checksum &&
+                check_fields(records, count, strings, header.strings_size) == 0;
+    for (int k = 0; valid && k < count; k++) // name_index_build trusts the order to name real contacts
+        valid = order[k] >= 0 && order[k] < count;
+    if (!valid)
+    {
+        munmap(map, size);
+        return -1;
+    }
+    stats_add(COUNT_BYTES_READ, size);
+
+    addressbook->contact_details = count > 0 ? records : NULL; // Borrowed from the mapping, no copy (an empty book would point past its end)
+    addressbook->contact_count = count;
+    addressbook->capacity = count;       // First append moves the records to the heap
+    if (header.strings_size > 0)         // So do the strings, on the first long one stored
+        addressbook->strings = (struct Text_arena){ strings, (size_t)header.strings_size, (size_t)header.strings_size, 0, 1 };
+    addressbook->mapping = map;
+    addressbook->mapping_size = size;
+    if (rebuild_indexes_in_order(addressbook, order) != 0)
+    {
+        destroy_address_book(addressbook); // Also unmaps
+        return -1;
+    }
+    *generation = header.generation;
+    return 0;
+}
+
+int open_snapshot(const char *path, struct Address_book *addressbook, uint64_t *generation) // Timed map_snapshot
+{
+    uint64_t start = stats_begin();
+    int status = map_snapshot(path, addressbook, generation);
+    stats_end(STAT_OPEN_SNAPSHOT, start);
+    return status;
+}
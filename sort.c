@@ -0,0 +1,257 @@
+/*------------------------------------------------------------------------------
+-> File         : sort.c
+-> Description  : Sort contacts alphabetically (case-insensitive) by Name.
+                  Names are case-folded once into one buffer, then a stable
+                  merge sort orders small (prefix, index) items instead of
+                  the records. Large books sort runs on several
+                  threads and merge them pairwise in parallel, both
+                  phases through run_workers (workers.c). The final
+                  permutation is applied to the records in one O(n) pass.
+                  A book that is already in order (data.txt is saved
+                  sorted) is detected in one O(n) pass and left alone.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, free)
+#include <string.h>     // Include string handling functions (strcmp)
+#include <ctype.h>      // Include tolower for case folding
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "workers.h"    // Include the thread-count knob and fork/join helper
+#include "stats.h"      // Include operation counters
+
+#define INSERTION_RUN 32            // Runs sorted by insertion sort before merging
+#define PARALLEL_SORT_MIN 100000    // Books smaller than this sort on one thread
+#define MAX_SORT_THREADS 16         // Upper bound on sort worker threads
+
+struct Sort_item                    // One contact as seen by the sort
+{
+    unsigned long long prefix;      // First 8 folded name bytes, big-endian, for fast compares
+    int index;                      // Position of the contact in contact_details
+};
+
+struct Sort_job                     // Work handed to one sort thread
+{
+    struct Sort_item *items;        // Items to sort or merge
+    struct Sort_item *tmp;          // Scratch buffer of the same size
+    int begin, middle, end;         // Range [begin, end), split at middle when merging
+    const char *const *keys;        // Folded name of every contact
+};
+
+/*------------------- Compare Two Items -------------------*/
+static int item_compare(const struct Sort_item *a, const struct Sort_item *b, const char *const *keys) // <0, 0, >0 like strcmp
+{
+    if (a->prefix != b->prefix)     // Most comparisons end here
+        return a->prefix < b->prefix ? -1 : 1;
+    if ((a->prefix & 0xff) == 0)    // Both names ended inside the prefix
+        return 0;
+    return strcmp(keys[a->index] + 8, keys[b->index] + 8); // Both are 8 or more characters: compare the rest
+}
+
+/*------------------- Merge Two Runs -------------------*/
+static void merge_runs(const struct Sort_item *src, struct Sort_item *dst, int begin, int middle, int end, const char *const *keys)
+{
+    int i = begin, j = middle, k = begin;
+    while (i < middle && j < end) // Take from the left run on ties to stay stable
+        dst[k++] = item_compare(&src[j], &src[i], keys) < 0 ? src[j++] : src[i++];
+    stats_add(COUNT_SORT_COMPARES, (uint64_t)(k - begin)); // One comparison per item placed so far
+    while (i < middle)
+        dst[k++] = src[i++];
+    while (j < end)
+        dst[k++] = src[j++];
+}
+
+/*------------------- Merge Sort -------------------*/
+static void merge_sort(struct Sort_item *items, struct Sort_item *tmp, int begin, int end, const char *const *keys) // Stable sort of [begin, end)
+{
+    for (int run = begin; run < end; run += INSERTION_RUN) // Short runs: insertion sort
+    {
+        int run_end = run + INSERTION_RUN < end ? run + INSERTION_RUN : end;
+        for (int i = run + 1; i < run_end; i++)
+        {
+            struct Sort_item item = items[i];
+            int j = i - 1;
+            while (j >= run && item_compare(&items[j], &item, keys) > 0)
+            {
+                items[j + 1] = items[j];
+                j--;
+            }
+            items[j + 1] = item;
+            stats_add(COUNT_SORT_COMPARES, (uint64_t)(i - 1 - j) + (j >= run)); // Shifts, plus the compare that stopped them
+        }
+    }
+
+    struct Sort_item *src = items, *dst = tmp;
+    for (int width = INSERTION_RUN; width < end - begin; width *= 2) // Bottom-up merge passes
+    {
+        for (int left = begin; left < end; left += 2 * width)
+        {
+            int middle = left + width < end ? left + width : end;
+            int right = middle + width < end ? middle + width : end;
+            merge_runs(src, dst, left, middle, right, keys);
+        }
+        struct Sort_item *swap = src; // Next pass reads what this pass wrote
+        src = dst;
+        dst = swap;
+    }
+    if (src != items) // Result ended in the scratch buffer
+        memcpy(items + begin, src + begin, (size_t)(end - begin) * sizeof(struct Sort_item));
+}
+
+static void *sort_worker(void *arg) // Worker job: sort one chunk
+{
+    struct Sort_job *job = arg;
+    merge_sort(job->items, job->tmp, job->begin, job->end, job->keys);
+    return NULL;
+}
+
+static void *merge_worker(void *arg) // Worker job: merge two neighbouring sorted chunks into tmp
+{
+    struct Sort_job *job = arg;
+    merge_runs(job->items, job->tmp, job->begin, job->middle, job->end, job->keys);
+    return NULL;
+}
+
+static int sort_thread_count(int count) // Number of threads worth using for 'count' contacts
+{
+    if (count < PARALLEL_SORT_MIN)
+        return 1;
+    int threads = worker_threads();
+    return threads > MAX_SORT_THREADS ? MAX_SORT_THREADS : threads;
+}
+
+/*------------------- Parallel Sort -------------------*/
+static void parallel_sort(struct Sort_item *items, struct Sort_item *tmp, int count, const char *const *keys, int threads)
+{
+    struct Sort_job job[MAX_SORT_THREADS];
+    int bounds[MAX_SORT_THREADS + 1]; // Chunk boundaries
+
+    for (int t = 0; t <= threads; t++)
+        bounds[t] = (int)((long long)count * t / threads);
+
+    // Phase 1: every worker sorts its own chunk
+    for (int t = 0; t < threads; t++)
+        job[t] = (struct Sort_job){ items, tmp, bounds[t], bounds[t], bounds[t + 1], keys };
+    run_workers(sort_worker, job, sizeof(job[0]), threads);
+
+    // Phase 2: merge neighbouring chunks pairwise, in parallel, until one remains
+    int runs = threads;
+    struct Sort_item *src = items, *dst = tmp;
+    while (runs > 1)
+    {
+        int merges = 0;
+        for (int r = 0; r < runs; r += 2)
+        {
+            int end = r + 2 <= runs ? bounds[r + 2] : bounds[r + 1];
+            int middle = r + 1 < runs ? bounds[r + 1] : end; // Odd run out is just copied
+            job[merges++] = (struct Sort_job){ src, dst, bounds[r], middle, end, keys };
+        }
+        run_workers(merge_worker, job, sizeof(job[0]), merges);
+
+        for (int r = 0; r < merges; r++) // Merged runs now span two old runs each
+            bounds[r] = bounds[2 * r];
+        bounds[merges] = count;
+        runs = merges;
+
+        struct Sort_item *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != items)
+        memcpy(items, src, (size_t)count * sizeof(struct Sort_item));
+}
+
+/*---------------- Sort contacts by Name (dictionary order) ----------------*/
+static void sort_records(struct Address_book *addressbook) // Sort contacts alphabetically by Name
+{
+    int count = addressbook->contact_count;
+    if (count < 2)
+        return;
+
+    size_t bytes = 0;
+    for (int i = 0; i < count; i++)
+        bytes += strlen(contact_name(addressbook, i)) + 1;
+    char *folded = malloc(bytes);                                               // Folded names, back to back
+    const char **keys = malloc((size_t)count * sizeof(char *));                 // Where each one starts
+    struct Sort_item *items = malloc((size_t)count * sizeof(struct Sort_item)); // Permutation being sorted
+    struct Sort_item *tmp = malloc((size_t)count * sizeof(struct Sort_item));   // Merge scratch space
+    if (folded == NULL || keys == NULL || items == NULL || tmp == NULL)
+    {
+        report_problem("Error: not enough memory to sort contacts\n");
+        free(folded);
+        free(keys);
+        free(items);
+        free(tmp);
+        return;
+    }
+
+    // Fold every name to lower case exactly once
+    int sorted = 1;
+    char *key = folded;
+    for (int i = 0; i < count; i++)
+    {
+        const char *name = contact_name(addressbook, i);
+        size_t length = 0;
+        for (; name[length] != '\0'; length++)
+            key[length] = (char)tolower((unsigned char)name[length]);
+        key[length] = '\0';
+        keys[i] = key;
+        if (i > 0 && strcmp(keys[i - 1], key) > 0)
+            sorted = 0; // Found a pair out of order
+
+        unsigned long long prefix = 0;
+        for (size_t b = 0; b < 8; b++) // Big-endian so integer order == string order, zero past the end
+            prefix = (prefix << 8) | (b <= length ? (unsigned char)key[b] : 0);
+        key += length + 1;
+        items[i].prefix = prefix;
+        items[i].index = i;
+    }
+
+    if (sorted) // Nothing to do: no sort pass, no record moves
+    {
+        free(folded);
+        free(keys);
+        free(items);
+        free(tmp);
+        return;
+    }
+
+    int threads = sort_thread_count(count);
+    if (threads > 1)
+        parallel_sort(items, tmp, count, keys, threads);
+    else
+        merge_sort(items, tmp, 0, count, keys);
+
+    // Apply the permutation: follow each cycle once, moving every record a single time
+    int *order = (int *)tmp; // Reuse scratch space (an int is smaller than a Sort_item)
+    for (int i = 0; i < count; i++)
+        order[i] = items[i].index; // Slot i receives contact order[i]
+
+    struct Contact_record *details = addressbook->contact_details;
+    for (int i = 0; i < count; i++)
+    {
+        if (order[i] == i)
+            continue; // Already in place (or placed by an earlier cycle)
+        struct Contact_record first = details[i];
+        int j = i;
+        while (order[j] != i)
+        {
+            int next = order[j];
+            details[j] = details[next];
+            order[j] = j; // Mark slot as done
+            j = next;
+        }
+        details[j] = first;
+        order[j] = j;
+    }
+
+    free(folded);
+    free(keys);
+    free(items);
+    free(tmp);
+}
+
+void sort_contacts_by_name(struct Address_book *addressbook) // Timed sort_records
+{
+    uint64_t start = stats_begin();
+    sort_records(addressbook);
+    stats_end(STAT_SORT, start);
+}
@@ -0,0 +1,197 @@
+/*------------------------------------------------------------------------------
+-> File         : stats.c
+-> Description  : Operation counters and latency histograms.
+                  Every thread counts into its own shard (no shared cache
+                  lines, no locked instructions): calls, total and largest
+                  time, and a log-linear histogram per operation, plus plain
+                  counters (index hits and misses, comparisons, scans,
+                  bytes). stats_report adds all shards up when asked, so
+                  counting stays a few plain stores. The shard of a thread
+                  that exits is handed to the next new thread, so the
+                  short-lived sort and load workers do not add up.
+
+                  Percentiles come from the histogram: 8 buckets per power
+                  of two keep them within 12.5% of the true value.
+
+                  Building with -DNO_STATS removes the counting entirely
+                  (stats.h turns every call into nothing); the report then
+                  only says so.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include snprintf, fopen, rename
+#include <stdlib.h>     // Include calloc, free
+#include <string.h>     // Include memset
+#include "stats.h"      // Include stats declarations
+
+#ifndef NO_STATS
+#include <pthread.h>    // Include pthread_once and a key whose destructor frees the shard for reuse
+
+static const char *operation_names[STAT_OPERATIONS] = {
+    "load_contact", "sort_contacts_by_name", "find_by_mobile", "find_by_mail", "find_by_name",
+    "find_by_mobile_prefix", "text_search", "fuzzy_search", "phonetic_search", "insert_contact",
+    "update_contact", "remove_contact", "save_contacts", "save_snapshot", "open_snapshot", "export_contacts", "wal_sync" };
+static const char *counter_names[STAT_COUNTERS] = {
+    "mobile_index_hits", "mobile_index_misses", "mail_index_hits", "mail_index_misses",
+    "name_index_hits", "name_index_misses", "sort_compares", "search_candidates",
+    "mobile_values_scanned", "bytes_read", "bytes_written" };
+
+_Thread_local struct Stats_shard *stats_shard;
+static struct Stats_shard *_Atomic shards;  // Every shard, newest first (never freed)
+static pthread_key_t shard_key;             // Its destructor runs when a counting thread exits
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+/*------------------- Shards -------------------*/
+static void release_shard(void *shard) // Thread exit: the next new thread takes over the shard and its counts
+{
+    stats_shard = NULL;
+    atomic_store_explicit(&((struct Stats_shard *)shard)->owned, 0, memory_order_release);
+}
+
+static void create_key(void)
+{
+    pthread_key_create(&shard_key, release_shard);
+}
+
+struct Stats_shard *stats_attach(void)
+{
+    pthread_once(&key_once, create_key);
+    struct Stats_shard *shard;
+    for (shard = atomic_load(&shards); shard != NULL; shard = shard->next) // Reuse one left by an exited thread
+    {
+        int free_shard = 0;
+        if (atomic_compare_exchange_strong(&shard->owned, &free_shard, 1))
+            break;
+    }
+    if (shard == NULL)
+    {
+        shard = calloc(1, sizeof(*shard));
+        if (shard == NULL)
+            return NULL; // Not counted
+        atomic_init(&shard->owned, 1);
+        shard->next = atomic_load(&shards);
+        while (!atomic_compare_exchange_weak(&shards, &shard->next, shard))
+            ; // Another thread pushed first: shard->next now holds the new head, try again
+    }
+    pthread_setspecific(shard_key, shard);
+    stats_shard = shard;
+    return shard;
+}
+
+/*------------------- Merge -------------------*/
+struct Stats_totals         // Every shard added up
+{
+    uint64_t calls[STAT_OPERATIONS];
+    uint64_t total_ns[STAT_OPERATIONS];
+    uint64_t max_ns[STAT_OPERATIONS];
+    uint64_t buckets[STAT_OPERATIONS][STATS_BUCKETS];
+    uint64_t counters[STAT_COUNTERS];
+};
+
+static void merge_shards(struct Stats_totals *totals) // Racy with counting threads, but each value read is whole
+{
+    memset(totals, 0, sizeof(*totals));
+    for (struct Stats_shard *shard = atomic_load(&shards); shard != NULL; shard = shard->next)
+    {
+        for (int op = 0; op < STAT_OPERATIONS; op++)
+        {
+            totals->calls[op] += atomic_load_explicit(&shard->calls[op], memory_order_relaxed);
+            if (atomic_load_explicit(&shard->calls[op], memory_order_relaxed) == 0)
+                continue; // Nothing in its histogram either
+            totals->total_ns[op] += atomic_load_explicit(&shard->total_ns[op], memory_order_relaxed);
+            uint64_t max = atomic_load_explicit(&shard->max_ns[op], memory_order_relaxed);
+            if (max > totals->max_ns[op])
+                totals->max_ns[op] = max;
+            for (int b = 0; b < STATS_BUCKETS; b++)
+                totals->buckets[op][b] += atomic_load_explicit(&shard->buckets[op][b], memory_order_relaxed);
+        }
+        for (int c = 0; c < STAT_COUNTERS; c++)
+            totals->counters[c] += atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
+    }
+}
+
+static double bucket_value(int bucket) // Middle of a histogram bucket, nanoseconds
+{
+    if (bucket < STATS_SUB_BUCKETS)
+        return bucket;
+    int top = bucket / STATS_SUB_BUCKETS + 2, sub = bucket % STATS_SUB_BUCKETS;
+    double width = (double)(1ULL << (top - 3));
+    return (STATS_SUB_BUCKETS + sub) * width + width / 2;
+}
+
+static double percentile(const uint64_t *buckets, uint64_t calls, uint64_t max, double fraction) // Nanoseconds below which 'fraction' of calls took
+{
+    uint64_t rank = (uint64_t)(fraction * (double)(calls - 1)) + 1, seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++)
+        if ((seen += buckets[b]) >= rank)
+            return bucket_value(b) < (double)max ? bucket_value(b) : (double)max; // The top bucket's middle may pass the largest call
+    return 0;
+}
+
+/*------------------- Report -------------------*/
+int stats_report(char *buffer, size_t size)
+{
+    struct Stats_totals *totals = malloc(sizeof(*totals));
+    if (totals == NULL)
+        return snprintf(buffer, size, "Error: not enough memory for statistics\n");
+    merge_shards(totals);
+
+    size_t used = 0;
+#define APPEND(...) (used += (size_t)snprintf(buffer + (used < size ? used : size), used < size ? size - used : 0, __VA_ARGS__))
+    APPEND("%-22s %10s %12s %10s %10s %10s %10s %10s %10s\n",
+           "operation", "calls", "total_ms", "mean_us", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+    for (int op = 0; op < STAT_OPERATIONS; op++)
+    {
+        uint64_t calls = totals->calls[op];
+        if (calls == 0)
+        {
+            APPEND("%-22s %10d %12.3f %10s %10s %10s %10s %10s %10s\n", operation_names[op], 0, 0.0, "-", "-", "-", "-", "-", "-");
+            continue;
+        }
+        APPEND("%-22s %10llu %12.3f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", operation_names[op],
+               (unsigned long long)calls, totals->total_ns[op] / 1e6, totals->total_ns[op] / 1e3 / calls,
+               percentile(totals->buckets[op], calls, totals->max_ns[op], 0.50) / 1e3,
+               percentile(totals->buckets[op], calls, totals->max_ns[op], 0.90) / 1e3,
+               percentile(totals->buckets[op], calls, totals->max_ns[op], 0.99) / 1e3,
+               percentile(totals->buckets[op], calls, totals->max_ns[op], 0.999) / 1e3, totals->max_ns[op] / 1e3);
+    }
+    APPEND("%-22s %10s\n", "counter", "value");
+    for (int c = 0; c < STAT_COUNTERS; c++)
+        APPEND("%-22s %10llu\n", counter_names[c], (unsigned long long)totals->counters[c]);
+#undef APPEND
+    free(totals);
+    return (int)(used < size ? used : size - 1);
+}
+
+void stats_reset(void)
+{
+    for (struct Stats_shard *shard = atomic_load(&shards); shard != NULL; shard = shard->next)
+        memset(shard, 0, offsetof(struct Stats_shard, owned)); // Counts only, keep 'owned' and the list
+}
+#else
+int stats_report(char *buffer, size_t size)
+{
+    return snprintf(buffer, size, "Statistics were compiled out (built with -DNO_STATS)\n");
+}
+
+void stats_reset(void)
+{
+}
+#endif
+
+int stats_write(const char *path) // Whole report under a temporary name, then renamed over 'path'
+{
+    char temp[4096], report[STATS_REPORT_SIZE];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return -1;
+    int length = stats_report(report, sizeof(report));
+    FILE *fp = fopen(temp, "w");
+    if (fp == NULL)
+        return -1;
+    int ok = fwrite(report, 1, (size_t)length, fp) == (size_t)length;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(temp, path) != 0) // Readers see the old dump or the new one, never half of one
+    {
+        remove(temp);
+        return -1;
+    }
+    return 0;
+}
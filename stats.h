@@ -0,0 +1,115 @@
+#ifndef STATS_H             // Header guard start, prevents multiple inclusion
+#define STATS_H
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint64_t counts and nanoseconds
+
+#define STAT_LOAD 0             // Timed operations (latency histogram each)
+#define STAT_SORT 1
+#define STAT_FIND_MOBILE 2
+#define STAT_FIND_MAIL 3
+#define STAT_FIND_NAME 4
+#define STAT_MOBILE_PREFIX 5
+#define STAT_TEXT_SEARCH 6
+#define STAT_FUZZY_SEARCH 7
+#define STAT_PHONETIC_SEARCH 8
+#define STAT_INSERT 9
+#define STAT_UPDATE 10
+#define STAT_REMOVE 11
+#define STAT_SAVE 12
+#define STAT_SAVE_SNAPSHOT 13
+#define STAT_OPEN_SNAPSHOT 14
+#define STAT_EXPORT 15
+#define STAT_WAL_SYNC 16
+#define STAT_OPERATIONS 17
+
+#define COUNT_MOBILE_HITS 0     // Plain counters
+#define COUNT_MOBILE_MISSES 1
+#define COUNT_MAIL_HITS 2
+#define COUNT_MAIL_MISSES 3
+#define COUNT_NAME_HITS 4
+#define COUNT_NAME_MISSES 5
+#define COUNT_SORT_COMPARES 6   // Name comparisons made by sort_contacts_by_name
+#define COUNT_CANDIDATES 7      // Contacts checked by text_search / fuzzy_search after the trigram filter, and by phonetic_search
+#define COUNT_SCANNED 8         // Mobile column values read by range queries
+#define COUNT_BYTES_READ 9      // Data file, snapshot and change log bytes
+#define COUNT_BYTES_WRITTEN 10
+#define STAT_COUNTERS 11
+
+#define STATS_SUB_BUCKETS 8     // Histogram buckets per power of two (values within 12.5%)
+#define STATS_BUCKETS (62 * STATS_SUB_BUCKETS) // Covers every uint64_t nanosecond count
+#define STATS_INTERVAL 10       // Seconds between dumps of the server's stats file
+#define STATS_REPORT_SIZE 8192  // Bytes of a formatted report
+
+/*------------------ Function Declarations ------------------*/
+
+int stats_report(char *buffer, size_t size); // Merge every thread's counts into a text table, its length
+int stats_write(const char *path); // Write the report to 'path' (replaced whole), 0 or -1
+void stats_reset(void); // Zero every count (no other thread may be counting)
+
+#ifndef NO_STATS
+#include <stdatomic.h>      // Relaxed loads and stores: one writer per shard, readers merge any time
+#include <time.h>           // clock_gettime
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Stats_shard          // Counts of one thread; only that thread writes them, stats_report sums all shards
+{
+    _Atomic uint64_t calls[STAT_OPERATIONS];
+    _Atomic uint64_t total_ns[STAT_OPERATIONS];
+    _Atomic uint64_t max_ns[STAT_OPERATIONS];
+    _Atomic uint64_t buckets[STAT_OPERATIONS][STATS_BUCKETS]; // Log-linear latency histogram (HDR style)
+    _Atomic uint64_t counters[STAT_COUNTERS];
+    atomic_int owned;       // A live thread writes here; a shard left by an exited thread is reused
+    struct Stats_shard *next; // Every shard ever made
+};
+
+extern _Thread_local struct Stats_shard *stats_shard; // This thread's shard, NULL until it first counts
+struct Stats_shard *stats_attach(void); // Give this thread a shard, NULL if out of memory
+
+static inline void stats_bump(_Atomic uint64_t *slot, uint64_t amount) // Single writer: no locked add needed
+{
+    atomic_store_explicit(slot, atomic_load_explicit(slot, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+static inline void stats_add(int counter, uint64_t amount)
+{
+    struct Stats_shard *shard = stats_shard != NULL ? stats_shard : stats_attach();
+    if (shard != NULL)
+        stats_bump(&shard->counters[counter], amount);
+}
+
+static inline uint64_t stats_begin(void) // Start of a timed operation, pass it to stats_end
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline int stats_bucket(uint64_t ns) // 0..7 exact, then STATS_SUB_BUCKETS per power of two
+{
+    if (ns < STATS_SUB_BUCKETS)
+        return (int)ns;
+    int top = 63 - __builtin_clzll(ns); // Highest set bit, 3 or more
+    return (top - 2) * STATS_SUB_BUCKETS + (int)((ns >> (top - 3)) & (STATS_SUB_BUCKETS - 1));
+}
+
+static inline void stats_end(int operation, uint64_t start)
+{
+    struct Stats_shard *shard = stats_shard != NULL ? stats_shard : stats_attach();
+    if (shard == NULL)
+        return;
+    uint64_t ns = stats_begin() - start;
+    stats_bump(&shard->calls[operation], 1);
+    stats_bump(&shard->total_ns[operation], ns);
+    stats_bump(&shard->buckets[operation][stats_bucket(ns)], 1);
+    if (ns > atomic_load_explicit(&shard->max_ns[operation], memory_order_relaxed))
+        atomic_store_explicit(&shard->max_ns[operation], ns, memory_order_relaxed);
+}
+#else // Compiled out: no clock reads, no counts
+#define stats_add(counter, amount) ((void)0)
+#define stats_begin() ((uint64_t)0)
+#define stats_end(operation, start) ((void)(start))
+#endif
+
+#endif // STATS_H            // End of header guard
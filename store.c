@@ -0,0 +1,533 @@
+/*------------------------------------------------------------------------------
+-> File         : store.c
+-> Description  : Growable contact store behind struct Address_book.
+                  Contacts live in one heap array that doubles when it runs
+                  out of room, so appending is amortized O(1). load_contact
+                  reserves the whole array up front from the #N header.
+                  A book opened from a snapshot borrows its records from the
+                  file mapping until the first append needs more room.
+
+                  A record keeps the mobile number and two 8-byte string
+                  slots: a name or mail ID of up to 7 characters sits in
+                  its slot, a longer one (of any length) in the book's
+                  string arena (arena.c). Edits store the new strings and
+                  leave the old ones as garbage; once garbage is half the
+                  arena, compact_strings copies the live strings into a
+                  fresh one. Snapshot writes and change log compaction
+                  copy just the live strings (snapshot.c).
+                  insert/update/remove keep the Mobile_number and Mail_ID
+                  hash indexes in step with the array so lookups and
+                  duplicate checks are O(1) expected, and relink the
+                  contact in the ordered name index in O(log n). When a
+                  change log is attached, every change is also appended to
+                  it (wal.c).
+
+                  remove_contact does not shift the array: it unindexes the
+                  contact and zeroes its slot (a tombstone), so no other
+                  contact is renumbered. Once COMPACT_MIN_DELETED tombstones
+                  make up 1/COMPACT_FRACTION of the slots, compact_contacts
+                  slides the survivors down and rebuilds the indexes in one
+                  O(n) pass, which keeps deletes amortized O(1).
+                  The packed mobile column (mobile_column.c) and the
+                  sound-alike index (phonetic.c), once built, are updated
+                  the same way.
+
+                  remove_contacts deletes a whole set of keys and compacts
+                  at most once. Whole-array readers skip tombstones
+                  (contact_deleted) or compact first.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, realloc, free)
+#include <string.h>     // Include string handling functions (memset, memcpy)
+#include <strings.h>    // Include strcasecmp for names in any case
+#include <limits.h>     // Include INT_MAX for capacity overflow checks
+#include <sys/mman.h>   // Include munmap for books opened from a snapshot
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "stats.h"      // Include operation counters
+
+#define MIN_CAPACITY 16 // Smallest array allocated once the first contact is added
+#define COMPACT_MIN_DELETED 1024 // Tombstones tolerated before compaction is considered
+#define COMPACT_FRACTION 4       // ... and then only once 1 in 4 slots is a tombstone
+
+/*------------------- Contact Fields -------------------*/
+const char *contact_name(const struct Address_book *addressbook, int index) // Slot text or arena string
+{
+    return arena_text(&addressbook->strings, &addressbook->contact_details[index].name);
+}
+
+const char *contact_mail(const struct Address_book *addressbook, int index)
+{
+    return arena_text(&addressbook->strings, &addressbook->contact_details[index].mail);
+}
+
+const char *contact_mobile(const struct Address_book *addressbook, int index)
+{
+    return addressbook->contact_details[index].Mobile_number;
+}
+
+void get_contact(const struct Address_book *addressbook, int index, struct Contact_data *contact) // Strings are not copied
+{
+    contact->Name = contact_name(addressbook, index);
+    memcpy(contact->Mobile_number, addressbook->contact_details[index].Mobile_number, sizeof(contact->Mobile_number));
+    contact->Mail_ID = contact_mail(addressbook, index);
+}
+
+/*------------------- Initialise Address Book -------------------*/
+void init_address_book(struct Address_book *addressbook) // Start with an empty store
+{
+    memset(addressbook, 0, sizeof(*addressbook)); // No array, zero contacts, zero capacity
+    hash_index_init(&addressbook->mobile_index, contact_mobile);
+    hash_index_init(&addressbook->mail_index, contact_mail);
+    name_index_init(&addressbook->name_index);
+    arena_init(&addressbook->strings);
+}
+
+/*------------------- Snapshot Mapping -------------------*/
+static int in_mapping(const struct Address_book *addressbook, const void *data) // Does 'data' point into the snapshot mapping?
+{
+    const char *map = addressbook->mapping;
+    return map != NULL && (const char *)data >= map && (const char *)data < map + addressbook->mapping_size;
+}
+
+static void release_mapping(struct Address_book *addressbook) // Unmap once neither the records nor the strings are read from it
+{
+    if (addressbook->mapping == NULL || in_mapping(addressbook, addressbook->contact_details) ||
+        addressbook->strings.borrowed)
+        return;
+    munmap(addressbook->mapping, addressbook->mapping_size);
+    addressbook->mapping = NULL;
+    addressbook->mapping_size = 0;
+}
+
+/*------------------- Reserve Capacity -------------------*/
+int reserve_contacts(struct Address_book *addressbook, int capacity) // Make room for at least 'capacity' contacts
+{
+    if (capacity <= addressbook->capacity) // Already large enough
+        return 0;
+
+    if (in_mapping(addressbook, addressbook->contact_details)) // Records still live in a snapshot mapping: copy them out once
+    {
+        struct Contact_record *details = malloc((size_t)capacity * sizeof(struct Contact_record));
+        if (details == NULL)
+            return -1;
+        memcpy(details, addressbook->contact_details, (size_t)addressbook->contact_count * sizeof(struct Contact_record));
+        addressbook->contact_details = details;
+        addressbook->capacity = capacity;
+        release_mapping(addressbook);
+        return 0;
+    }
+
+    struct Contact_record *details = realloc(addressbook->contact_details,
+                                             (size_t)capacity * sizeof(struct Contact_record)); // Grow the array
+    if (details == NULL) // Out of memory, keep the old array untouched
+        return -1;
+
+    addressbook->contact_details = details; // Use the new array
+    addressbook->capacity = capacity;       // Remember how many slots it holds
+    return 0;
+}
+
+/*------------------- Append Contact -------------------*/
+static int store_strings(struct Address_book *addressbook, struct Contact_record *record, const struct Contact_data *contact,
+                         int name, int mail) // Give the record its new name and/or mail ID, 0 or -1 with the record unchanged
+{
+    const char *texts[2] = { contact->Name, contact->Mail_ID }; // Either may point into the arena
+    size_t name_length = name ? strlen(texts[0]) : 0, mail_length = mail ? strlen(texts[1]) : 0;
+    if (name_length > TEXT_MAX_LENGTH || mail_length > TEXT_MAX_LENGTH ||
+        arena_reserve(&addressbook->strings, arena_need(name_length) + arena_need(mail_length), texts, 2) != 0)
+        return -1;
+    if (name) // Cannot fail now: the room is reserved
+        arena_store(&addressbook->strings, &record->name, texts[0], name_length);
+    if (mail)
+        arena_store(&addressbook->strings, &record->mail, texts[1], mail_length);
+    release_mapping(addressbook); // The arena may just have left it
+    return 0;
+}
+
+int reserve_strings(struct Address_book *addressbook, size_t bytes) // Grow the arena once for a bulk append
+{
+    if (arena_reserve(&addressbook->strings, bytes, NULL, 0) != 0)
+        return -1;
+    release_mapping(addressbook);
+    return 0;
+}
+
+static void drop_strings(struct Address_book *addressbook, int index) // The slot's strings become garbage
+{
+    arena_drop(&addressbook->strings, &addressbook->contact_details[index].name);
+    arena_drop(&addressbook->strings, &addressbook->contact_details[index].mail);
+}
+
+int append_contact(struct Address_book *addressbook, const struct Contact_data *contact) // Add contact at the end, return its index or -1
+{
+    struct Contact_record record;
+    memset(&record, 0, sizeof(record)); // Zero padding keeps saved records byte-identical
+    if (store_strings(addressbook, &record, contact, 1, 1) != 0) // Strings first: the contact may point into the records
+        return -1;
+    memcpy(record.Mobile_number, contact->Mobile_number, sizeof(record.Mobile_number));
+
+    if (addressbook->contact_count == addressbook->capacity) // Array is full
+    {
+        int capacity = addressbook->capacity < MIN_CAPACITY ? MIN_CAPACITY
+                     : addressbook->capacity > INT_MAX / 2 ? INT_MAX
+                     : addressbook->capacity * 2;      // Double the size for amortized O(1) appends
+        if (addressbook->capacity == INT_MAX || reserve_contacts(addressbook, capacity) != 0) // Cannot grow any further
+        {
+            arena_drop(&addressbook->strings, &record.name);
+            arena_drop(&addressbook->strings, &record.mail);
+            return -1;
+        }
+    }
+
+    addressbook->contact_details[addressbook->contact_count] = record; // Copy contact into next free slot
+    return addressbook->contact_count++; // Return its index and count it
+}
+
+/*------------------- Destroy Address Book -------------------*/
+void destroy_address_book(struct Address_book *addressbook) // Release all memory held by the store
+{
+    if (addressbook->wal != NULL) // Commit and detach the change log first
+        wal_close(addressbook);
+    if (!in_mapping(addressbook, addressbook->contact_details)) // Not borrowed from a snapshot file
+        free(addressbook->contact_details); // Free the contact array
+    arena_free(&addressbook->strings); // Leaves borrowed bytes alone
+    if (addressbook->mapping != NULL)
+        munmap(addressbook->mapping, addressbook->mapping_size);
+    hash_index_free(&addressbook->mobile_index); // Free the lookup indexes
+    hash_index_free(&addressbook->mail_index);
+    name_index_free(&addressbook->name_index);
+    text_index_free(addressbook->text_index);
+    mobile_column_free(addressbook->mobile_column);
+    phonetic_index_free(addressbook->phonetic_index);
+    init_address_book(addressbook);     // Leave the book empty and reusable
+}
+
+/*------------------- Compact Contacts -------------------*/
+static int squeeze_contacts(struct Address_book *addressbook, int *slot) // Slide live contacts down over tombstones, slot[old] = new
+{
+    struct Contact_record *details = addressbook->contact_details;
+    int kept = 0;
+    for (int i = 0; i < addressbook->contact_count; i++)
+    {
+        if (contact_deleted(addressbook, i))
+            continue;
+        if (slot != NULL)
+            slot[i] = kept;
+        if (kept != i)
+            details[kept] = details[i];
+        kept++;
+    }
+    addressbook->contact_count = kept;
+    addressbook->deleted_count = 0;
+    return kept;
+}
+
+int compact_contacts(struct Address_book *addressbook) // One O(n) pass, then every index is rebuilt from the known name order
+{
+    if (addressbook->deleted_count == 0)
+        return 0;
+    int *slot = malloc((size_t)addressbook->contact_count * sizeof(int)); // New index of each old one
+    int *order = name_order(addressbook); // Live contacts in name order, by old index
+    if (slot == NULL || order == NULL)
+    {
+        free(slot);
+        free(order);
+        return -1;
+    }
+    int count = squeeze_contacts(addressbook, slot);
+    for (int k = 0; k < count; k++) // Sliding keeps relative order, so the name order stays sorted
+        order[k] = slot[order[k]];
+    int status = rebuild_indexes_in_order(addressbook, order); // Also drops the trigram index
+    free(slot);
+    free(order);
+    if (status == 0 && arena_wasteful(&addressbook->strings))
+        compact_strings(addressbook); // Best effort: the garbage just stays
+    return status;
+}
+
+int pack_strings(struct Contact_record *records, int count, const struct Text_arena *from, struct Text_arena *to) // Live strings only, in record order
+{
+    size_t live = 0;
+    for (int i = 0; i < count; i++)
+        live += arena_need(arena_length(&records[i].name)) + arena_need(arena_length(&records[i].mail));
+    arena_init(to);
+    if (arena_reserve(to, live, NULL, 0) != 0)
+        return -1;
+    for (int i = 0; i < count; i++)
+    {
+        arena_move(to, from, &records[i].name);
+        arena_move(to, from, &records[i].mail);
+    }
+    return 0;
+}
+
+int compact_strings(struct Address_book *addressbook) // One O(n) pass; contact indexes do not change
+{
+    struct Text_arena fresh;
+    if (pack_strings(addressbook->contact_details, addressbook->contact_count, &addressbook->strings, &fresh) != 0)
+        return -1;
+    arena_free(&addressbook->strings);
+    addressbook->strings = fresh;
+    release_mapping(addressbook);
+    return 0;
+}
+
+/*------------------- Rebuild Indexes -------------------*/
+int rebuild_indexes(struct Address_book *addressbook) // Index every contact from scratch (after load or reorder)
+{
+    if (addressbook->deleted_count > 0) // The old name order may be stale here, so just drop the tombstones
+        squeeze_contacts(addressbook, NULL);
+    return rebuild_indexes_in_order(addressbook, NULL);
+}
+
+int rebuild_indexes_in_order(struct Address_book *addressbook, const int *order) // Same, with a known name order (snapshot)
+{
+    if (hash_index_build(&addressbook->mobile_index, addressbook, addressbook->contact_count) != 0 ||
+        hash_index_build(&addressbook->mail_index, addressbook, addressbook->contact_count) != 0 ||
+        name_index_build(&addressbook->name_index, addressbook, addressbook->contact_count, order) != 0)
+        return -1;
+    text_index_free(addressbook->text_index); // Rebuilt on the next partial search
+    addressbook->text_index = NULL;
+    mobile_column_free(addressbook->mobile_column); // Rebuilt on the next range query
+    addressbook->mobile_column = NULL;
+    phonetic_index_free(addressbook->phonetic_index); // Rebuilt on the next sound-alike search
+    addressbook->phonetic_index = NULL;
+    return 0;
+}
+
+/*------------------- Insert Contact -------------------*/
+static int insert_indexed(struct Address_book *addressbook, const struct Contact_data *contact) // Append and index, return index or -1
+{
+    int index = append_contact(addressbook, contact);
+    if (index == -1)
+        return -1;
+
+    if (hash_index_insert(&addressbook->mobile_index, addressbook, index) != 0)
+    {
+        drop_strings(addressbook, index); // Undo the append
+        addressbook->contact_count--;
+        return -1;
+    }
+    if (hash_index_insert(&addressbook->mail_index, addressbook, index) != 0)
+    {
+        hash_index_remove(&addressbook->mobile_index, addressbook, index);
+        drop_strings(addressbook, index);
+        addressbook->contact_count--;
+        return -1;
+    }
+    if (name_index_insert(&addressbook->name_index, addressbook, index) != 0)
+    {
+        hash_index_remove(&addressbook->mobile_index, addressbook, index);
+        hash_index_remove(&addressbook->mail_index, addressbook, index);
+        drop_strings(addressbook, index);
+        addressbook->contact_count--;
+        return -1;
+    }
+    if (addressbook->text_index && text_index_add(addressbook->text_index, addressbook, index) != 0)
+    {
+        text_index_free(addressbook->text_index); // Out of memory: drop it, it is rebuilt when next needed
+        addressbook->text_index = NULL;
+    }
+    if (addressbook->mobile_column &&
+        mobile_column_set(addressbook->mobile_column, index, pack_mobile(contact_mobile(addressbook, index))) != 0)
+    {
+        mobile_column_free(addressbook->mobile_column); // Same: rebuilt when next needed
+        addressbook->mobile_column = NULL;
+    }
+    if (addressbook->phonetic_index &&
+        phonetic_index_set(addressbook->phonetic_index, index, contact_name(addressbook, index)) != 0)
+    {
+        phonetic_index_free(addressbook->phonetic_index); // Same
+        addressbook->phonetic_index = NULL;
+    }
+    if (addressbook->wal)
+        wal_log_change(addressbook, WAL_ADD, NULL, index);
+    return index;
+}
+
+int insert_contact(struct Address_book *addressbook, const struct Contact_data *contact) // Timed insert_indexed
+{
+    uint64_t start = stats_begin();
+    int index = insert_indexed(addressbook, contact);
+    stats_end(STAT_INSERT, start);
+    return index;
+}
+
+/*------------------- Update Contact -------------------*/
+static void reclaim_strings_if_due(struct Address_book *addressbook) // Amortized O(1): at least as many garbage bytes as live ones
+{
+    if (arena_wasteful(&addressbook->strings))
+        compact_strings(addressbook); // Best effort: if the copy cannot be allocated the garbage just stays
+}
+
+static int update_indexed(struct Address_book *addressbook, int index, const struct Contact_data *contact) // Overwrite contact at index
+{
+    if (index < 0 || index >= addressbook->contact_count || contact_deleted(addressbook, index))
+        return -1;
+
+    struct Contact_record *old = &addressbook->contact_details[index];
+    char key[sizeof(old->Mobile_number)]; // Mobile number the change log knows this contact by
+    memcpy(key, old->Mobile_number, sizeof(key));
+    int mobile_changed = strcmp(old->Mobile_number, contact->Mobile_number) != 0;
+    int mail_changed = strcmp(contact_mail(addressbook, index), contact->Mail_ID) != 0;
+    int name_changed = strcmp(contact_name(addressbook, index), contact->Name) != 0;
+
+    struct Contact_record fresh = *old; // New strings are stored first: without memory nothing has changed yet
+    if (store_strings(addressbook, &fresh, contact, name_changed, mail_changed) != 0)
+        return -1;
+
+    // Drop index entries for keys that change (while the old key is still in the record)
+    if (mobile_changed)
+        hash_index_remove(&addressbook->mobile_index, addressbook, index);
+    if (mail_changed)
+        hash_index_remove(&addressbook->mail_index, addressbook, index);
+    if (name_changed)
+        name_index_remove(&addressbook->name_index, addressbook, index);
+
+    if (name_changed) // Store the new values, the old strings become garbage
+        arena_drop(&addressbook->strings, &old->name);
+    if (mail_changed)
+        arena_drop(&addressbook->strings, &old->mail);
+    memcpy(fresh.Mobile_number, contact->Mobile_number, sizeof(fresh.Mobile_number));
+    *old = fresh;
+
+    // Re-insert never grows anything because an entry was just removed
+    if (mobile_changed)
+        hash_index_insert(&addressbook->mobile_index, addressbook, index);
+    if (mail_changed)
+        hash_index_insert(&addressbook->mail_index, addressbook, index);
+    if (name_changed) // Relink at the new place in name order, reusing the node
+        name_index_insert(&addressbook->name_index, addressbook, index);
+    if ((name_changed || mail_changed) && addressbook->text_index &&
+        text_index_add(addressbook->text_index, addressbook, index) != 0) // Old trigrams stay, the search re-checks every hit
+    {
+        text_index_free(addressbook->text_index);
+        addressbook->text_index = NULL;
+    }
+    if (mobile_changed && addressbook->mobile_column) // Existing slot, never grows
+        mobile_column_set(addressbook->mobile_column, index, pack_mobile(old->Mobile_number));
+    if (name_changed && addressbook->phonetic_index &&
+        phonetic_index_set(addressbook->phonetic_index, index, contact_name(addressbook, index)) != 0) // Re-chained under the new key
+    {
+        phonetic_index_free(addressbook->phonetic_index); // Out of memory: rebuilt on the next sound-alike search
+        addressbook->phonetic_index = NULL;
+    }
+    if (addressbook->wal)
+        wal_log_change(addressbook, WAL_EDIT, key, index);
+    reclaim_strings_if_due(addressbook);
+    return 0;
+}
+
+int update_contact(struct Address_book *addressbook, int index, const struct Contact_data *contact) // Timed update_indexed
+{
+    uint64_t start = stats_begin();
+    int status = update_indexed(addressbook, index, contact);
+    stats_end(STAT_UPDATE, start);
+    return status;
+}
+
+/*------------------- Remove Contact -------------------*/
+int contact_deleted(const struct Address_book *addressbook, int index) // Tombstones are zeroed records
+{
+    return addressbook->contact_details[index].Mobile_number[0] == '\0'; // No live contact has an empty mobile number
+}
+
+int count_contacts(const struct Address_book *addressbook) // Live contacts only
+{
+    return addressbook->contact_count - addressbook->deleted_count;
+}
+
+static void bury_contact(struct Address_book *addressbook, int index) // Unindex a contact and leave a tombstone in its slot
+{
+    struct Contact_record *details = addressbook->contact_details;
+    char key[sizeof(details->Mobile_number)]; // Mobile number the change log knows this contact by
+    memcpy(key, details[index].Mobile_number, sizeof(key));
+    hash_index_remove(&addressbook->mobile_index, addressbook, index);
+    hash_index_remove(&addressbook->mail_index, addressbook, index);
+    name_index_remove(&addressbook->name_index, addressbook, index); // Slot stays, nothing is renumbered
+    drop_strings(addressbook, index);
+    memset(&details[index], 0, sizeof(details[index])); // Trigram postings to it stop matching (text_index.c)
+    if (addressbook->mobile_column)
+        mobile_column_set(addressbook->mobile_column, index, MOBILE_NONE);
+    if (addressbook->phonetic_index)
+        phonetic_index_set(addressbook->phonetic_index, index, NULL); // Unchained
+    addressbook->deleted_count++;
+    if (addressbook->wal) // After the change, so a compaction it starts copies the book without the contact
+        wal_log_change(addressbook, WAL_DELETE, key, -1);
+}
+
+static void reclaim_if_due(struct Address_book *addressbook) // Threshold compaction: amortized O(1) per delete
+{
+    if (addressbook->deleted_count >= COMPACT_MIN_DELETED &&
+        addressbook->deleted_count >= addressbook->contact_count / COMPACT_FRACTION)
+        compact_contacts(addressbook); // Best effort: if the copies cannot be allocated the tombstones just stay
+    else
+        reclaim_strings_if_due(addressbook);
+}
+
+void remove_contact(struct Address_book *addressbook, int index) // Delete contact, later ones keep their index
+{
+    if (index < 0 || index >= addressbook->contact_count || contact_deleted(addressbook, index))
+        return;
+    uint64_t start = stats_begin();
+    bury_contact(addressbook, index);
+    reclaim_if_due(addressbook);
+    stats_end(STAT_REMOVE, start);
+}
+
+int remove_contacts(struct Address_book *addressbook, const char *const *keys, int count) // Bulk delete in one pass, return how many
+{
+    int removed = 0;
+    for (int k = 0; k < count; k++) // Indexes stay valid until the single compaction at the end
+    {
+        int index = strchr(keys[k], '@') != NULL ? find_by_mail(addressbook, keys[k])
+                                                 : find_by_mobile(addressbook, keys[k]);
+        if (index == -1) // Unknown, or named twice in 'keys'
+            continue;
+        bury_contact(addressbook, index);
+        removed++;
+    }
+    reclaim_if_due(addressbook);
+    return removed;
+}
+
+/*------------------- Find Contact -------------------*/
+int find_by_mobile(const struct Address_book *addressbook, const char *mobile_number) // O(1) expected lookup
+{
+    uint64_t start = stats_begin();
+    int index = hash_index_find(&addressbook->mobile_index, addressbook, mobile_number);
+    stats_add(index != -1 ? COUNT_MOBILE_HITS : COUNT_MOBILE_MISSES, 1);
+    stats_end(STAT_FIND_MOBILE, start);
+    return index;
+}
+
+int find_by_mail(const struct Address_book *addressbook, const char *mail_id) // O(1) expected lookup
+{
+    uint64_t start = stats_begin();
+    int index = hash_index_find(&addressbook->mail_index, addressbook, mail_id);
+    stats_add(index != -1 ? COUNT_MAIL_HITS : COUNT_MAIL_MISSES, 1);
+    stats_end(STAT_FIND_MAIL, start);
+    return index;
+}
+
+int find_by_name(const struct Address_book *addressbook, const char *name) // O(log n) seek in the name index
+{
+    uint64_t start = stats_begin();
+    int index = name_index_seek(&addressbook->name_index, addressbook, name);
+    if (index != -1 && strcasecmp(contact_name(addressbook, index), name) != 0)
+        index = -1;
+    stats_add(index != -1 ? COUNT_NAME_HITS : COUNT_NAME_MISSES, 1);
+    stats_end(STAT_FIND_NAME, start);
+    return index;
+}
+
+/*------------------- Walk In Name Order -------------------*/
+int first_contact(const struct Address_book *addressbook) // Start of the sorted listing
+{
+    return name_index_first(&addressbook->name_index);
+}
+
+int next_contact(const struct Address_book *addressbook, int index) // Next contact of the sorted listing
+{
+    return name_index_next(&addressbook->name_index, index);
+}
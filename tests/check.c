@@ -0,0 +1,213 @@
+/*------------------------------------------------------------------------------
+-> File         : check.c
+-> Description  : Helpers shared by the randomized tests: the seeded
+                  generator, contacts of every length (names short enough
+                  to sit inline in their slot and far longer than the old
+                  fixed fields), failure counting, comparing the contacts
+                  two books hold, and scratch directories for books kept
+                  on disk.
+------------------------------------------------------------------------------*/
+#define _XOPEN_SOURCE 700   // nftw
+#include <stdio.h>          // Include standard input/output functions (printf, snprintf)
+#include <stdlib.h>         // Include memory functions (malloc, realloc, free, qsort, getenv)
+#include <string.h>         // Include string handling functions (strcmp, strlen)
+#include <strings.h>        // Include strcasecmp for name order
+#include <stdarg.h>         // Include va_list for check_failed
+#include <unistd.h>         // Include rmdir
+#include <ftw.h>            // Include nftw to remove scratch directories
+#include "check.h"          // Include test helper declarations
+
+#define DEFAULT_SEED 88172645463325252ULL // Seed when $TEST_SEED is not set
+
+static const char *const first_names[] = { "Ravi", "Meena", "Emma", "Arjun", "Zoe", "Bharath", "Laxmi",
+                                           "Kiran", "Anil", "Yusuf", "Olga", "Priya" };
+static const char *const last_names[] = { "patel", "mehta", "smith", "rao", "khan", "iyer", "zhou", "brown" };
+#define FIRST_COUNT (int)(sizeof(first_names) / sizeof(first_names[0]))
+#define LAST_COUNT (int)(sizeof(last_names) / sizeof(last_names[0]))
+
+static uint64_t state = DEFAULT_SEED, seed = DEFAULT_SEED;
+static const char *test_name = "test";
+static int failures;
+
+/*------------------- Start / Fail / Finish -------------------*/
+void check_start(const char *test)
+{
+    const char *env = getenv("TEST_SEED");
+    if (env != NULL && *env != '\0')
+        seed = strtoull(env, NULL, 0);
+    state = seed != 0 ? seed : DEFAULT_SEED; // xorshift never leaves 0
+    test_name = test;
+}
+
+int check_failed(const char *file, int line, const char *format, ...)
+{
+    va_list args;
+    printf("%s:%d: ", file, line);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+    failures++;
+    return 1;
+}
+
+int check_finish(void)
+{
+    if (failures == 0)
+        printf("%s: ok\n", test_name);
+    else
+        printf("%s: %d failures (TEST_SEED=%llu)\n", test_name, failures, (unsigned long long)seed);
+    return failures == 0 ? 0 : 1;
+}
+
+/*------------------- Random Contacts -------------------*/
+uint32_t random_next(void) // xorshift64
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint32_t)(state >> 32);
+}
+
+int random_below(int bound)
+{
+    return (int)(random_next() % (uint32_t)bound);
+}
+
+static void mail_of(char *mail_id, int size, int number) // The same mail ID every time for one number
+{
+    if (number % 5 != 0)
+    {
+        snprintf(mail_id, size, "user%d@mail.com", number);
+        return;
+    }
+    int length = snprintf(mail_id, size, "user%d", number); // Every fifth one far longer than Mail_ID[35] was
+    for (int i = 0; i < 40 + number % 300 && length < size - 16; i++)
+        mail_id[length++] = (char)('a' + (number + i) % 26);
+    snprintf(mail_id + length, size - length, "@long-domain.mail.com");
+}
+
+void random_contact(struct Contact_data *contact, struct Contact_text *text, int mobiles, int mail_ids)
+{
+    int length = snprintf(text->name, sizeof(text->name), "%s", first_names[random_below(FIRST_COUNT)]);
+    switch (random_below(4))
+    {
+    case 0: // First name alone: short enough to stay inline in its slot
+        break;
+    case 3: // Many words, up to several hundred characters
+        for (int words = random_below(80); words > 0 && length < (int)sizeof(text->name) - 16; words--)
+            length += snprintf(text->name + length, sizeof(text->name) - length, " %s", last_names[random_below(LAST_COUNT)]);
+        break;
+    default:
+        snprintf(text->name + length, sizeof(text->name) - length, " %s", last_names[random_below(LAST_COUNT)]);
+    }
+    snprintf(contact->Mobile_number, sizeof(contact->Mobile_number), "9%09d", random_below(mobiles));
+    mail_of(text->mail_id, sizeof(text->mail_id), random_below(mail_ids));
+    contact->Name = text->name;
+    contact->Mail_ID = text->mail_id;
+}
+
+void random_key(char *key, int size, int mobiles, int mail_ids)
+{
+    if (random_below(2))
+        snprintf(key, size, "9%09d", random_below(mobiles));
+    else
+        mail_of(key, size, random_below(mail_ids));
+}
+
+/*------------------- Rows -------------------*/
+int collect_row(const struct Contact_data *contact, void *context)
+{
+    struct Rows *rows = context;
+    if (rows->count == rows->capacity)
+    {
+        int capacity = rows->capacity ? rows->capacity * 2 : 256;
+        char **grown = realloc(rows->rows, (size_t)capacity * sizeof(char *));
+        if (grown == NULL)
+            return 1; // Stop: the counts will differ
+        rows->rows = grown;
+        rows->capacity = capacity;
+    }
+    size_t size = strlen(contact->Name) + strlen(contact->Mail_ID) + 16;
+    char *row = malloc(size);
+    if (row == NULL)
+        return 1;
+    snprintf(row, size, "%s|%s|%s", contact->Name, contact->Mobile_number, contact->Mail_ID);
+    rows->rows[rows->count++] = row;
+    return 0;
+}
+
+void rows_free(struct Rows *rows)
+{
+    for (int i = 0; i < rows->count; i++)
+        free(rows->rows[i]);
+    free(rows->rows);
+    memset(rows, 0, sizeof(*rows));
+}
+
+static int compare_names(const char *a, const char *b) // Names of two rows, in any case
+{
+    size_t a_length = strcspn(a, "|"), b_length = strcspn(b, "|");
+    int cmp = strncasecmp(a, b, a_length < b_length ? a_length : b_length);
+    if (cmp != 0)
+        return cmp;
+    return (a_length > b_length) - (a_length < b_length);
+}
+
+int rows_in_name_order(const struct Rows *rows)
+{
+    for (int i = 1; i < rows->count; i++)
+        if (compare_names(rows->rows[i - 1], rows->rows[i]) > 0)
+            return 0;
+    return 1;
+}
+
+static int compare_rows(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int same_rows(struct Rows *a, struct Rows *b, const char *where)
+{
+    if (CHECK(a->count == b->count, "%s: %d contacts against %d", where, a->count, b->count))
+        return 0;
+    qsort(a->rows, a->count, sizeof(char *), compare_rows);
+    qsort(b->rows, b->count, sizeof(char *), compare_rows);
+    for (int i = 0; i < a->count; i++)
+        if (CHECK(strcmp(a->rows[i], b->rows[i]) == 0, "%s: row %d differs:\n  %s\n  %s", where, i, a->rows[i], b->rows[i]))
+            return 0;
+    return 1;
+}
+
+/*------------------- Scratch Directories -------------------*/
+char *scratch_directory(void)
+{
+    const char *base = getenv("TMPDIR");
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/addressbook-test.XXXXXX", base != NULL && *base != '\0' ? base : "/tmp");
+    if (mkdtemp(path) == NULL)
+        return NULL;
+    char data[4200];
+    snprintf(data, sizeof(data), "%s/data.txt", path);
+    FILE *file = fopen(data, "w"); // An empty book to open
+    if (file == NULL)
+        return NULL;
+    fclose(file);
+    size_t size = strlen(path) + 1;
+    char *copy = malloc(size);
+    if (copy != NULL)
+        memcpy(copy, path, size);
+    return copy;
+}
+
+static int remove_entry(const char *path, const struct stat *info, int type, struct FTW *walk)
+{
+    (void)info;
+    (void)walk;
+    return type == FTW_DP ? rmdir(path) : remove(path);
+}
+
+void remove_directory(const char *path)
+{
+    nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
@@ -0,0 +1,51 @@
+#ifndef CHECK_H             // Header guard start, prevents multiple inclusion
+#define CHECK_H
+
+#include <stdint.h>         // uint32_t random numbers
+#include "addressbook.h"    // struct Contact_data
+
+/* Helpers shared by the randomized tests (tests/check.c). Each test runs a seeded
+   random workload against the library and against a plainer reference (a
+   brute-force model or an in-memory book) and counts every difference. 'make test'
+   builds them and the library with AddressSanitizer and UBSan. $TEST_SEED
+   repeats a run; the seed is printed when a test fails. */
+
+#define LONGEST_TEXT 1200           // Room for the longest generated name or mail ID
+
+#define CHECK(condition, ...) ((condition) ? 0 : check_failed(__FILE__, __LINE__, __VA_ARGS__)) // printf-style note when false
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Contact_text         // Strings a generated contact points into
+{
+    char name[LONGEST_TEXT];
+    char mail_id[LONGEST_TEXT];
+};
+
+struct Rows                 // Contacts flattened to "Name|Mobile|Mail" lines
+{
+    char **rows;            // malloc'd lines
+    int count;              // Lines stored
+    int capacity;           // Lines allocated
+};
+
+/*------------------ Function Declarations ------------------*/
+
+void check_start(const char *test); // Seed the generator from $TEST_SEED (or a fixed default)
+int check_failed(const char *file, int line, const char *format, ...); // Count and print one failure, returns 1
+int check_finish(void); // Print the result, exit status for main
+
+uint32_t random_next(void); // Next number of the seeded xorshift generator
+int random_below(int bound); // Uniform in 0 .. bound - 1
+void random_contact(struct Contact_data *contact, struct Contact_text *text, int mobiles, int mail_ids); // Valid contact: short, medium or very long name; mobile and mail from pools of that size
+void random_key(char *key, int size, int mobiles, int mail_ids); // Mobile number or mail ID from the same pools
+
+int collect_row(const struct Contact_data *contact, void *rows); // *_each visitor appending to a struct Rows
+void rows_free(struct Rows *rows); // Release the lines, leave it empty
+int rows_in_name_order(const struct Rows *rows); // Collected in name order (any case)?
+int same_rows(struct Rows *a, struct Rows *b, const char *where); // Same contacts in any order (sorts both), a failure noted if not
+
+char *scratch_directory(void); // malloc'd fresh directory under $TMPDIR (or /tmp), holding an empty data.txt
+void remove_directory(const char *path); // Delete a scratch directory and everything in it
+
+#endif // CHECK_H            // End of header guard
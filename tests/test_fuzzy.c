@@ -0,0 +1,178 @@
+/*------------------------------------------------------------------------------
+-> File         : test_fuzzy.c
+-> Description  : fuzzy_search against a linear scan. Queries are stored
+                  names with random typos (changed, missing, extra and
+                  swapped letters); the scan measures every live name with
+                  name_distance, and both must list the same names at the
+                  same distances in the same order, while contacts are
+                  added, renamed and deleted underneath.
+------------------------------------------------------------------------------*/
+#include <stdio.h>          // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>         // Include memory functions (malloc, free, qsort)
+#include <string.h>         // Include string handling functions (strcmp, strlen)
+#include <strings.h>        // Include strcasecmp
+#include <ctype.h>          // Include tolower
+#include "contact.h"        // Include the book's internals (contact_name)
+#include "text_index.h"     // Include fuzzy_search and name_distance
+#include "check.h"          // Include test helpers
+
+#define CONTACTS 2000       // Contacts added before the first query
+#define ROUNDS 40           // Rounds of changes followed by queries
+#define CHANGES 100         // Random changes per round
+#define QUERIES 25          // Queries per round
+#define MOBILES 3000        // Pool of mobile numbers
+#define MAIL_IDS 3000       // Pool of mail IDs
+#define QUERY_SIZE 64       // name_distance takes up to 63 characters
+
+struct Fuzzy_hit            // A name and its distance from the query
+{
+    int distance;
+    const char *name;
+};
+
+struct Scan                 // Linear scan state for addressbook_each
+{
+    const char *query;
+    struct Fuzzy_hit *hits;
+    int count;
+    int max_distance;
+};
+
+static int scan_name(const struct Contact_data *contact, void *context)
+{
+    struct Scan *scan = context;
+    int distance = name_distance(scan->query, contact->Name);
+    if (distance >= 0 && distance <= scan->max_distance)
+        scan->hits[scan->count++] = (struct Fuzzy_hit){ distance, contact->Name };
+    return 0;
+}
+
+static int compare_fuzzy_hits(const void *a, const void *b) // Closest first, then name
+{
+    const struct Fuzzy_hit *x = a, *y = b;
+    if (x->distance != y->distance)
+        return x->distance - y->distance;
+    return strcasecmp(x->name, y->name);
+}
+
+static int allowed_distance(const char *query, int max_distance) // What fuzzy_search allows a query this short (text_index.h)
+{
+    int length = (int)strlen(query), grams = 0;
+    char padded[QUERY_SIZE + 4];
+    snprintf(padded, sizeof(padded), "\001\001%s\001\001", query); // Names are indexed with two pads on each side
+    for (int i = 0; i + 3 <= length + 4; i++)
+    {
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++)
+            seen = strncmp(padded + i, padded + j, 3) == 0;
+        grams += !seen;
+    }
+    if (max_distance > FUZZY_MAX_DISTANCE)
+        max_distance = FUZZY_MAX_DISTANCE;
+    while (max_distance > 0 && grams - 4 * max_distance < 1) // A typo can spoil four trigrams
+        max_distance--;
+    return max_distance;
+}
+
+static void make_typos(char *query, int typos) // Random edits inside a folded name
+{
+    for (; typos > 0; typos--)
+    {
+        int length = (int)strlen(query), at = random_below(length);
+        char letter = (char)('a' + random_below(26));
+        switch (random_below(4))
+        {
+        case 0:
+            query[at] = letter;
+            break;
+        case 1:
+            if (length > 1)
+                memmove(query + at, query + at + 1, (size_t)(length - at));
+            break;
+        case 2:
+            if (length < QUERY_SIZE - 1)
+            {
+                memmove(query + at + 1, query + at, (size_t)(length - at + 1));
+                query[at] = letter;
+            }
+            break;
+        default:
+            if (at + 1 < length)
+            {
+                char swap = query[at];
+                query[at] = query[at + 1];
+                query[at + 1] = swap;
+            }
+        }
+    }
+}
+
+static void check_fuzzy(struct Address_book *book, const char *query, int max_distance, struct Fuzzy_hit *expected,
+                        struct Search_hit *hits)
+{
+    struct Scan scan = { query, expected, 0, allowed_distance(query, max_distance) };
+    addressbook_each(book, scan_name, &scan);
+    qsort(expected, scan.count, sizeof(*expected), compare_fuzzy_hits);
+
+    int total = -1, found = fuzzy_search(book, query, max_distance, 0, addressbook_count(book), hits, &total);
+    if (CHECK(found == scan.count && total == scan.count, "fuzzy \"%s\" within %d: %d of %d, scan finds %d", query,
+              scan.max_distance, found, total, scan.count))
+        return;
+    for (int i = 0; i < found; i++)
+        if (CHECK(hits[i].rank == expected[i].distance && strcmp(contact_name(book, hits[i].index), expected[i].name) == 0,
+                  "fuzzy \"%s\" hit %d: %s at %d, scan has %s at %d", query, i, contact_name(book, hits[i].index), hits[i].rank,
+                  expected[i].name, expected[i].distance))
+            return;
+}
+
+int main(void)
+{
+    check_start("test_fuzzy");
+    int error;
+    struct Address_book *book = addressbook_open(NULL, NULL, &error);
+    struct Fuzzy_hit *expected = malloc((MOBILES + 1) * sizeof(*expected));
+    struct Search_hit *hits = malloc((MOBILES + 1) * sizeof(*hits));
+    if (CHECK(book != NULL && expected != NULL && hits != NULL, "open: %s", addressbook_message(error)))
+        return check_finish();
+
+    struct Contact_text text;
+    struct Contact_data contact, picked;
+    char key[LONGEST_TEXT], query[QUERY_SIZE];
+    for (int i = 0; i < CONTACTS; i++)
+    {
+        random_contact(&contact, &text, MOBILES, MAIL_IDS);
+        addressbook_insert(book, &contact); // Duplicates are refused, that is fine
+    }
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (int change = 0; change < CHANGES; change++) // Renames and deletes leave stale postings the search must skip
+        {
+            random_contact(&contact, &text, MOBILES, MAIL_IDS);
+            random_key(key, sizeof(key), MOBILES, MAIL_IDS);
+            switch (random_below(3))
+            {
+            case 0: addressbook_insert(book, &contact); break;
+            case 1: addressbook_update(book, key, &contact); break;
+            default: addressbook_delete(book, key);
+            }
+        }
+        for (int q = 0; q < QUERIES; q++)
+        {
+            char mobile_number[11];
+            snprintf(mobile_number, sizeof(mobile_number), "9%09d", random_below(MOBILES));
+            if (addressbook_get_by_mobile(book, mobile_number, &picked) != ADDRESSBOOK_OK || strlen(picked.Name) >= QUERY_SIZE)
+                continue;
+            int length = 0;
+            for (; picked.Name[length] != '\0'; length++)
+                query[length] = (char)tolower((unsigned char)picked.Name[length]);
+            query[length] = '\0';
+            int max_distance = 1 + random_below(FUZZY_MAX_DISTANCE);
+            make_typos(query, random_below(max_distance + 1));
+            check_fuzzy(book, query, max_distance, expected, hits);
+        }
+    }
+    addressbook_close(book);
+    free(expected);
+    free(hits);
+    return check_finish();
+}
@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------------
+-> File         : test_journal.c
+-> Description  : A book kept in a directory against the same changes made
+                  to an in-memory book. The directory book is closed and
+                  reopened every few thousand changes, so its contacts
+                  come back through the snapshot, the string arena and the
+                  change log (compacted along the way), and must still
+                  match.
+------------------------------------------------------------------------------*/
+#include <stdio.h>          // Include standard input/output functions (snprintf)
+#include <stdlib.h>         // Include memory functions (free)
+#include <string.h>         // Include string handling functions (strcmp)
+#include "addressbook.h"    // Include the library interface
+#include "check.h"          // Include test helpers
+
+#define OPERATIONS 30000    // Random changes applied to both books
+#define MOBILES 1500        // Pool of mobile numbers
+#define MAIL_IDS 1500       // Pool of mail IDs
+#define REOPEN_EVERY 6000   // Changes between reopening the directory book
+
+static void compare(const struct Address_book *expected, const struct Address_book *book, const char *where)
+{
+    struct Rows a = { 0 }, b = { 0 };
+    addressbook_each(expected, collect_row, &a);
+    addressbook_each(book, collect_row, &b);
+    CHECK(rows_in_name_order(&b), "%s: not in name order", where);
+    same_rows(&a, &b, where);
+    rows_free(&a);
+    rows_free(&b);
+}
+
+int main(void)
+{
+    check_start("test_journal");
+    char *directory = scratch_directory();
+    int error;
+    struct Address_book *memory = addressbook_open(NULL, NULL, &error);
+    struct Address_book *book = directory != NULL ? addressbook_open(directory, NULL, &error) : NULL;
+    if (memory == NULL || book == NULL)
+    {
+        check_failed(__FILE__, __LINE__, "open %s: %s", directory != NULL ? directory : "(no directory)", addressbook_message(error));
+        return check_finish();
+    }
+
+    struct Contact_text text;
+    struct Contact_data contact, got;
+    char key[LONGEST_TEXT];
+    for (int op = 0; op < OPERATIONS && book != NULL; op++)
+    {
+        random_contact(&contact, &text, MOBILES, MAIL_IDS);
+        random_key(key, sizeof(key), MOBILES, MAIL_IDS);
+        int expected, result;
+        switch (random_below(5))
+        {
+        case 0:
+        case 1:
+            expected = addressbook_insert(memory, &contact);
+            result = addressbook_insert(book, &contact);
+            break;
+        case 2:
+        case 3:
+            expected = addressbook_update(memory, key, &contact);
+            result = addressbook_update(book, key, &contact);
+            break;
+        default:
+            expected = addressbook_delete(memory, key);
+            result = addressbook_delete(book, key);
+        }
+        CHECK(result == expected, "operation %d on %.40s: %d, expected %d", op, key, result, expected);
+
+        if (addressbook_get_by_mobile(book, key, &got) == ADDRESSBOOK_OK) // Logged edit that hands the book its own strings
+        {
+            struct Contact_data same = got;
+            char mobile_number[11];
+            memcpy(mobile_number, got.Mobile_number, sizeof(mobile_number));
+            CHECK(addressbook_update(book, mobile_number, &same) == ADDRESSBOOK_OK, "self update of %s", mobile_number);
+        }
+
+        if (op % REOPEN_EVERY == REOPEN_EVERY - 1)
+        {
+            compare(memory, book, "before reopening");
+            if (op % (2 * REOPEN_EVERY) == 2 * REOPEN_EVERY - 1)
+                CHECK(addressbook_sync(book) == ADDRESSBOOK_OK, "sync");
+            CHECK(addressbook_close(book) == ADDRESSBOOK_OK, "close");
+            book = addressbook_open(directory, NULL, &error);
+            if (CHECK(book != NULL, "reopen: %s", addressbook_message(error)))
+                break;
+            compare(memory, book, "after reopening");
+        }
+    }
+    if (book != NULL)
+    {
+        CHECK(addressbook_close(book) == ADDRESSBOOK_OK, "close");
+        book = addressbook_open(directory, NULL, &error);
+        if (!CHECK(book != NULL, "final open: %s", addressbook_message(error)))
+        {
+            compare(memory, book, "final");
+            addressbook_close(book);
+        }
+    }
+    addressbook_close(memory);
+    remove_directory(directory);
+    free(directory);
+    return check_finish();
+}
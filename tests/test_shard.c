@@ -0,0 +1,133 @@
+/*------------------------------------------------------------------------------
+-> File         : test_shard.c
+-> Description  : A sharded book against an in-memory book, for both
+                  schemes: split, then random inserts, edits (moving
+                  contacts between shards), deletes and lookups, a save
+                  half way, merged name order, merged and paged queries,
+                  and a reopen at the end.
+------------------------------------------------------------------------------*/
+#include <stdio.h>          // Include standard input/output functions (snprintf)
+#include <stdlib.h>         // Include memory functions (malloc, free)
+#include <string.h>         // Include string handling functions (strcmp)
+#include "addressbook.h"    // Include the library interface
+#include "shard.h"          // Include sharded books
+#include "check.h"          // Include test helpers
+
+#define FIRST_CONTACTS 3000 // Contacts in the book that is split
+#define OPERATIONS 6000     // Random changes applied to both books
+#define MOBILES 4000        // Pool of mobile numbers
+#define MAIL_IDS 4000       // Pool of mail IDs
+#define SHARDS 5            // Shards of the split book
+#define CHECK_EVERY 1500    // Changes between full comparisons
+#define PAGE 7              // Page checked against the full answer
+
+static void compare(struct Address_book *expected, struct Sharded_book *book, const char *where)
+{
+    struct Rows a = { 0 }, b = { 0 };
+    addressbook_each(expected, collect_row, &a);
+    CHECK(sharded_each(book, collect_row, &b) == sharded_count(book), "%s: each stopped early", where);
+    CHECK(sharded_count(book) == a.count, "%s: count %d, expected %d", where, sharded_count(book), a.count);
+    CHECK(rows_in_name_order(&b), "%s: shards not merged in name order", where);
+    same_rows(&a, &b, where);
+    rows_free(&a);
+    rows_free(&b);
+
+    const char *queries[] = { "patel", "emma", "ravi meh", "user12@", "zzz", "ar" };
+    int limit = addressbook_count(expected);
+    struct Contact_data *all = malloc((size_t)(2 * limit + 1) * sizeof(*all)), *merged = all + limit;
+    for (int q = 0; all != NULL && q < (int)(sizeof(queries) / sizeof(queries[0])); q++)
+    {
+        int total = -1, merged_total = -2;
+        int found = addressbook_query(expected, queries[q], 0, limit, all, &total);
+        int merged_found = sharded_query(book, queries[q], 0, limit, merged, &merged_total);
+        if (CHECK(found == merged_found && total == merged_total, "%s: query %s %d/%d, expected %d/%d", where, queries[q],
+                  merged_found, merged_total, found, total))
+            continue;
+        for (int i = 0; i < found; i++) // Same names best first (contacts sharing a name may come in either order)
+            if (CHECK(strcmp(all[i].Name, merged[i].Name) == 0, "%s: query %s hit %d", where, queries[q], i))
+                break;
+        struct Contact_data page[PAGE];
+        int offset = found > PAGE ? random_below(found - PAGE) : 0;
+        int paged = sharded_query(book, queries[q], offset, PAGE, page, &merged_total);
+        for (int i = 0; i < paged; i++)
+            if (CHECK(strcmp(page[i].Mobile_number, merged[offset + i].Mobile_number) == 0, "%s: query %s page at %d", where, queries[q], offset))
+                break;
+    }
+    free(all);
+}
+
+static void run(int scheme)
+{
+    int error;
+    struct Address_book *memory = addressbook_open(NULL, NULL, &error);
+    char *directory = scratch_directory();
+    char path[4200];
+    snprintf(path, sizeof(path), "%s/sharded", directory != NULL ? directory : "");
+    struct Contact_text text;
+    struct Contact_data contact, got, got_sharded;
+    for (int i = 0; memory != NULL && i < FIRST_CONTACTS; i++)
+    {
+        random_contact(&contact, &text, MOBILES, MAIL_IDS);
+        addressbook_insert(memory, &contact); // Duplicates are refused, that is fine
+    }
+    if (CHECK(memory != NULL && directory != NULL, "scheme %d: no book or scratch directory", scheme) ||
+        CHECK(sharded_split(memory, path, SHARDS, scheme) == ADDRESSBOOK_OK, "scheme %d: split", scheme))
+        goto done;
+    CHECK(sharded_split(memory, path, SHARDS, scheme) != ADDRESSBOOK_OK, "scheme %d: split over an existing book", scheme);
+    struct Sharded_book *book = sharded_open(path, &error);
+    if (CHECK(book != NULL, "scheme %d: open %s", scheme, addressbook_message(error)))
+        goto done;
+    compare(memory, book, "split");
+
+    char key[LONGEST_TEXT];
+    for (int op = 0; op < OPERATIONS; op++)
+    {
+        random_contact(&contact, &text, MOBILES, MAIL_IDS);
+        random_key(key, sizeof(key), MOBILES, MAIL_IDS);
+        int expected, result;
+        switch (random_below(4))
+        {
+        case 0:
+            expected = addressbook_insert(memory, &contact);
+            result = sharded_insert(book, &contact);
+            break;
+        case 1:
+        case 2:
+            expected = addressbook_update(memory, key, &contact);
+            result = sharded_update(book, key, &contact);
+            break;
+        default:
+            expected = addressbook_delete(memory, key);
+            result = sharded_delete(book, key);
+        }
+        CHECK(result == expected, "scheme %d operation %d on %.40s: %d, expected %d", scheme, op, key, result, expected);
+        CHECK(addressbook_get_by_mobile(memory, key, &got) == sharded_get_by_mobile(book, key, &got_sharded) &&
+                  addressbook_get_by_mail(memory, key, &got) == sharded_get_by_mail(book, key, &got_sharded),
+              "scheme %d: lookup %.40s", scheme, key);
+        if (op % CHECK_EVERY == 0)
+            compare(memory, book, "workload");
+        if (op == OPERATIONS / 2)
+            CHECK(sharded_save(book) == ADDRESSBOOK_OK, "scheme %d: save", scheme);
+    }
+    compare(memory, book, "end");
+    CHECK(sharded_close(book) == ADDRESSBOOK_OK, "scheme %d: close", scheme);
+    book = sharded_open(path, &error);
+    if (!CHECK(book != NULL, "scheme %d: reopen %s", scheme, addressbook_message(error)))
+    {
+        compare(memory, book, "reopen");
+        sharded_close(book);
+    }
+done:
+    addressbook_close(memory);
+    if (directory != NULL)
+        remove_directory(directory);
+    free(directory);
+}
+
+int main(void)
+{
+    check_start("test_shard");
+    run(SHARD_BY_MOBILE);
+    run(SHARD_BY_NAME);
+    return check_finish();
+}
@@ -0,0 +1,239 @@
+/*------------------------------------------------------------------------------
+-> File         : test_store.c
+-> Description  : An in-memory book against a brute-force model: random
+                  inserts, edits and deletes (including edits that hand the
+                  book its own strings back), lookups by mobile and mail,
+                  name order, and ranked partial search checked against a
+                  linear scan with the documented ranks.
+------------------------------------------------------------------------------*/
+#include <stdio.h>          // Include standard input/output functions (snprintf)
+#include <stdlib.h>         // Include memory functions (malloc, free, qsort)
+#include <string.h>         // Include string handling functions (strcmp, strdup)
+#include <strings.h>        // Include strcasecmp / strncasecmp
+#include <ctype.h>          // Include tolower for the model's search
+#include "addressbook.h"    // Include the library interface
+#include "check.h"          // Include test helpers
+
+#define OPERATIONS 20000    // Random changes applied
+#define MOBILES 1500        // Pool of mobile numbers (collisions exercise DUPLICATE_MOBILE)
+#define MAIL_IDS 1500       // Pool of mail IDs
+#define CHECK_EVERY 2500    // Changes between full comparisons
+#define PAGE 16             // Query page compared in full
+
+/*------------------ Model ------------------*/
+struct Model_contact        // One contact of the brute-force model
+{
+    char *name;
+    char mobile_number[11];
+    char *mail_id;
+};
+
+static struct Model_contact model[MOBILES]; // Never more contacts than mobile numbers
+static int model_count;
+
+static int model_find(const char *key) // Slot holding this mobile or mail, or -1
+{
+    for (int i = 0; i < model_count; i++)
+        if (strcmp(model[i].mobile_number, key) == 0 || strcmp(model[i].mail_id, key) == 0)
+            return i;
+    return -1;
+}
+
+static int model_check(const struct Contact_data *contact, int slot) // Uniqueness as the library states it
+{
+    for (int i = 0; i < model_count; i++)
+        if (i != slot && strcmp(model[i].mobile_number, contact->Mobile_number) == 0)
+            return DUPLICATE_MOBILE;
+    for (int i = 0; i < model_count; i++)
+        if (i != slot && strcmp(model[i].mail_id, contact->Mail_ID) == 0)
+            return DUPLICATE_MAIL;
+    return VALID;
+}
+
+static void model_set(int slot, const struct Contact_data *contact)
+{
+    char *name = strdup(contact->Name), *mail_id = strdup(contact->Mail_ID); // Copy first: 'contact' may point at the old strings
+    if (slot == model_count)
+        model_count++;
+    else
+    {
+        free(model[slot].name);
+        free(model[slot].mail_id);
+    }
+    model[slot].name = name;
+    model[slot].mail_id = mail_id;
+    memcpy(model[slot].mobile_number, contact->Mobile_number, sizeof(model[slot].mobile_number));
+}
+
+static void model_delete(int slot)
+{
+    free(model[slot].name);
+    free(model[slot].mail_id);
+    model[slot] = model[--model_count];
+}
+
+/*------------------ Search By Hand ------------------*/
+static const char *find_any_case(const char *text, const char *query) // strstr ignoring case
+{
+    size_t length = strlen(query);
+    for (; *text != '\0'; text++)
+        if (strncasecmp(text, query, length) == 0)
+            return text;
+    return NULL;
+}
+
+static int model_rank(const struct Model_contact *contact, const char *query) // The ranks text_index.h documents, -1 if no match
+{
+    size_t length = strlen(query);
+    if (strncasecmp(contact->name, query, length) == 0)
+        return contact->name[length] == '\0' ? 0 : 1;
+    if (length < 3)
+        return -1; // Short queries match name prefixes only
+    const char *hit = find_any_case(contact->name, query);
+    if (hit != NULL)
+    {
+        for (; hit != NULL; hit = find_any_case(hit + 1, query))
+            if (hit > contact->name && hit[-1] == ' ')
+                return 2;
+        return 3;
+    }
+    if (strncasecmp(contact->mail_id, query, length) == 0)
+        return 4;
+    return find_any_case(contact->mail_id, query) != NULL ? 5 : -1;
+}
+
+struct Model_hit
+{
+    int rank;
+    const struct Model_contact *contact;
+};
+
+static int compare_model_hits(const void *a, const void *b) // Best rank, then name
+{
+    const struct Model_hit *x = a, *y = b;
+    if (x->rank != y->rank)
+        return x->rank - y->rank;
+    return strcasecmp(x->contact->name, y->contact->name);
+}
+
+static void check_query(struct Address_book *book, const char *query)
+{
+    static struct Model_hit hits[MOBILES];
+    int expected = 0;
+    for (int i = 0; i < model_count; i++)
+    {
+        int rank = model_rank(&model[i], query);
+        if (rank >= 0)
+            hits[expected++] = (struct Model_hit){ rank, &model[i] };
+    }
+    qsort(hits, expected, sizeof(hits[0]), compare_model_hits);
+
+    struct Contact_data found[PAGE];
+    int total = -1, offset = expected > PAGE ? random_below(expected - PAGE + 1) : 0;
+    int written = addressbook_query(book, query, offset, PAGE, found, &total);
+    int wanted = expected - offset < PAGE ? expected - offset : PAGE;
+    if (CHECK(total == expected && written == wanted, "query \"%.40s\": %d of %d, expected %d of %d", query, written, total, wanted, expected))
+        return;
+    for (int i = 0; i < written; i++)
+    {
+        const struct Model_hit *hit = &hits[offset + i];
+        int slot = model_find(found[i].Mobile_number);
+        if (CHECK(strcmp(found[i].Name, hit->contact->name) == 0, "query \"%.40s\" hit %d: %.60s, expected %.60s", query, offset + i,
+                  found[i].Name, hit->contact->name) ||
+            CHECK(slot != -1 && model_rank(&model[slot], query) == hit->rank, "query \"%.40s\" hit %d out of rank", query, offset + i))
+            return;
+    }
+}
+
+/*------------------ Full Comparison ------------------*/
+static void compare(struct Address_book *book, const char *where)
+{
+    struct Rows listed = { 0 }, expected = { 0 };
+    CHECK(addressbook_count(book) == model_count, "%s: count %d, model %d", where, addressbook_count(book), model_count);
+    CHECK(addressbook_each(book, collect_row, &listed) == model_count, "%s: each stopped early", where);
+    CHECK(rows_in_name_order(&listed), "%s: not in name order", where);
+    for (int i = 0; i < model_count; i++)
+    {
+        struct Contact_data contact = { model[i].name, "", model[i].mail_id };
+        memcpy(contact.Mobile_number, model[i].mobile_number, sizeof(contact.Mobile_number));
+        collect_row(&contact, &expected);
+    }
+    same_rows(&listed, &expected, where);
+    rows_free(&listed);
+    rows_free(&expected);
+
+    const char *queries[] = { "patel", "Emma", "ravi meh", "user12", "mail.com", "ZZZ", "ra", "z", "n k" };
+    for (int q = 0; q < (int)(sizeof(queries) / sizeof(queries[0])); q++)
+        check_query(book, queries[q]);
+    if (model_count > 0) // A whole stored name or mail ID, long ones included (longer than any query buffer)
+    {
+        const struct Model_contact *contact = &model[random_below(model_count)];
+        check_query(book, contact->name);
+        check_query(book, contact->mail_id + strlen(contact->mail_id) / 2);
+    }
+}
+
+/*------------------ Random Workload ------------------*/
+int main(void)
+{
+    check_start("test_store");
+    int error;
+    struct Address_book *book = addressbook_open(NULL, NULL, &error);
+    if (book == NULL)
+    {
+        check_failed(__FILE__, __LINE__, "open: %s", addressbook_message(error));
+        return check_finish();
+    }
+
+    struct Contact_text text;
+    struct Contact_data contact, got;
+    char key[LONGEST_TEXT];
+    for (int op = 0; op < OPERATIONS; op++)
+    {
+        random_contact(&contact, &text, MOBILES, MAIL_IDS);
+        random_key(key, sizeof(key), MOBILES, MAIL_IDS);
+        int slot = model_find(key), result, expected;
+        switch (random_below(5))
+        {
+        case 0:
+        case 1:
+            expected = model_check(&contact, -1);
+            result = addressbook_insert(book, &contact);
+            if (expected == VALID)
+                model_set(model_count, &contact);
+            break;
+        case 2:
+        case 3:
+            expected = slot == -1 ? ADDRESSBOOK_NOT_FOUND : model_check(&contact, slot);
+            result = addressbook_update(book, key, &contact);
+            if (expected == VALID)
+                model_set(slot, &contact);
+            break;
+        default:
+            expected = slot == -1 ? ADDRESSBOOK_NOT_FOUND : ADDRESSBOOK_OK;
+            result = addressbook_delete(book, key);
+            if (slot != -1)
+                model_delete(slot);
+        }
+        CHECK(result == expected, "operation %d on %.40s: %d, expected %d", op, key, result, expected);
+
+        slot = model_find(key);
+        int by_mobile = addressbook_get_by_mobile(book, key, &got), by_mail = addressbook_get_by_mail(book, key, &got);
+        int found = by_mobile == ADDRESSBOOK_OK ? by_mobile : by_mail;
+        CHECK((found == ADDRESSBOOK_OK) == (slot != -1), "lookup %.40s: %d, model slot %d", key, found, slot);
+        if (found == ADDRESSBOOK_OK && slot != -1)
+        {
+            CHECK(strcmp(got.Name, model[slot].name) == 0 && strcmp(got.Mail_ID, model[slot].mail_id) == 0 &&
+                      strcmp(got.Mobile_number, model[slot].mobile_number) == 0, "lookup %.40s: wrong contact", key);
+            struct Contact_data same = got; // Its own strings handed back: the book must copy before it drops them
+            CHECK(addressbook_update(book, got.Mobile_number, &same) == ADDRESSBOOK_OK, "self update of %.40s", key);
+        }
+        if (op % CHECK_EVERY == CHECK_EVERY - 1)
+            compare(book, "workload");
+    }
+    compare(book, "end");
+    addressbook_close(book);
+    while (model_count > 0)
+        model_delete(0);
+    return check_finish();
+}
@@ -0,0 +1,597 @@
+/*------------------------------------------------------------------------------
+-> File         : text_index.c
+-> Description  : Type-ahead search over Name and Mail_ID.
+                  Every lower-cased Name and Mail_ID is cut into trigrams
+                  ("red", "edd", "ddy") and each trigram keeps a sorted list
+                  of the contacts containing it. A substring query
+                  intersects the lists of its own trigrams, shortest first,
+                  and only the survivors are checked with strstr. Queries
+                  shorter than three characters are name prefixes and use
+                  the ordered name index instead. Results are ranked
+                  (exact, prefix, word start, substring, mail) and paged.
+
+                  Names are also indexed with their edge trigrams ("  r",
+                  " ra" ... "i  ", the pad has its own code), which serve
+                  the typo-tolerant search. A name within k edits of the
+                  query shares at least G - 4k of the query's G padded
+                  trigrams (one edit touches at most four), so candidates
+                  come from counting trigrams over the shortest lists only
+                  and the survivors are checked with a bit-parallel edit
+                  distance (Myers / Hyyro, with adjacent transpositions).
+                  Short queries get a smaller k so that G - 4k stays
+                  positive: without a shared trigram nothing limits the
+                  candidates.
+                  The same kernel ranks the sound-alike search (phonetic.c)
+                  through name_distance.
+
+                  The index is built on the first partial search, then kept
+                  current by insert_contact and update_contact. Entries left
+                  behind by an edit are filtered out by the strstr check,
+                  and those of a deleted contact by contact_deleted.
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (FILE used in contact.h)
+#include <stdlib.h>     // Include memory functions (malloc, calloc, free, qsort)
+#include <string.h>     // Include string handling functions (strlen, strncmp)
+#include <strings.h>    // Include strcasecmp / strncasecmp for names in any case
+#include <ctype.h>      // Include tolower for case folding
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "text_index.h" // Include text index declarations
+#include "stats.h"      // Include operation counters
+
+#define CODE_BITS 6                             // Bits per character code
+#define TRIGRAM_COUNT (1 << (3 * CODE_BITS))   // Number of distinct trigram codes
+#define MAX_QUERY 64                            // Longest query accepted (folded)
+#define MAX_GRAMS (MAX_QUERY + 2)              // Trigrams in any folded field or query, padded names included
+#define PAD_CODE 0                              // Code of the padding around a name (no character maps to it)
+#define GRAMS_PER_EDIT 4                        // Padded trigrams one edit can destroy (a transposition touches four)
+
+struct List_cursor          // Position in one posting list while several are merged
+{
+    int id;                 // Contact id at the cursor
+    int at;                 // Its position in the list
+    const struct Posting_list *list;
+};
+
+struct Ranked_hit           // Hit plus the key it is ordered by
+{
+    int index;              // Contact index
+    int rank;               // Match quality class
+    const char *key;        // Name, ties within a rank go by name order (any case)
+};
+
+static int char_code(unsigned char c) // Map a folded character to a 6-bit code
+{
+    if (c >= 'a' && c <= 'z') return 1 + (c - 'a');   // 1..26
+    if (c >= '0' && c <= '9') return 27 + (c - '0');  // 27..36
+    switch (c)
+    {
+        case ' ': return 37;
+        case '.': return 38;
+        case '-': return 39;
+        case '@': return 40;
+        case '_': return 41;
+        default:  return 42; // Anything else shares one code
+    }
+}
+
+static int fold_text(char *out, const char *in, int size) // Lower-case copy of in, returns its length
+{
+    int len = 0;
+    for (; len < size - 1 && in[len] != '\0'; len++)
+        out[len] = tolower((unsigned char)in[len]);
+    out[len] = '\0';
+    return len;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int collect_trigrams(const char *folded, int len, int *grams, int padded) // Sorted, distinct trigram codes of a folded string
+{
+    int count = 0;
+    for (int i = padded ? -2 : 0; i + 2 < len + (padded ? 2 : 0); i++) // Padded: two pad codes before and after
+    {
+        int code = 0;
+        for (int k = i; k < i + 3; k++)
+            code = code << CODE_BITS | (k < 0 || k >= len ? PAD_CODE : char_code(folded[k]));
+        grams[count++] = code;
+    }
+    if (padded && len == 0)
+        count = 0;
+    qsort(grams, count, sizeof(int), compare_ints);
+
+    int distinct = 0;
+    for (int i = 0; i < count; i++)
+        if (distinct == 0 || grams[distinct - 1] != grams[i])
+            grams[distinct++] = grams[i];
+    return distinct;
+}
+
+/*------------------- Posting Lists -------------------*/
+static int posting_add(struct Posting_list *list, int id) // Insert id keeping the list sorted and distinct
+{
+    int pos = list->count;
+    if (pos > 0 && list->ids[pos - 1] >= id) // Not an append: binary search the spot (edited contact)
+    {
+        int lo = 0, hi = list->count;
+        while (lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+            if (list->ids[mid] < id)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < list->count && list->ids[lo] == id)
+            return 0; // Already listed
+        pos = lo;
+    }
+
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 4;
+        int *ids = realloc(list->ids, (size_t)capacity * sizeof(int));
+        if (ids == NULL)
+            return -1;
+        list->ids = ids;
+        list->capacity = capacity;
+    }
+    memmove(list->ids + pos + 1, list->ids + pos, (size_t)(list->count - pos) * sizeof(int));
+    list->ids[pos] = id;
+    list->count++;
+    return 0;
+}
+
+static int add_field(struct Posting_list *lists, const char *text, int id, int padded) // Index every trigram of one field
+{
+    char short_folded[MAX_QUERY];
+    int short_grams[MAX_GRAMS];
+    char *folded = short_folded;
+    int *grams = short_grams;
+    size_t length = strlen(text);
+    if (length >= MAX_QUERY) // Long field: every trigram is indexed, so the buffers come from the heap
+    {
+        folded = malloc(length + 1);
+        grams = malloc((length + 2) * sizeof(int));
+        if (folded == NULL || grams == NULL)
+        {
+            free(folded);
+            free(grams);
+            return -1;
+        }
+    }
+    int len = fold_text(folded, text, (int)length + 1);
+    int count = collect_trigrams(folded, len, grams, padded);
+    int result = 0;
+    for (int g = 0; g < count && result == 0; g++)
+        result = posting_add(&lists[grams[g]], id);
+    if (folded != short_folded)
+    {
+        free(folded);
+        free(grams);
+    }
+    return result;
+}
+
+/*------------------- Build / Free / Add -------------------*/
+struct Text_index *text_index_build(const struct Address_book *addressbook) // Index every contact
+{
+    struct Text_index *index = malloc(sizeof(*index));
+    if (index == NULL)
+        return NULL;
+    index->name_lists = calloc(TRIGRAM_COUNT, sizeof(struct Posting_list));
+    index->mail_lists = calloc(TRIGRAM_COUNT, sizeof(struct Posting_list));
+    if (index->name_lists == NULL || index->mail_lists == NULL)
+    {
+        text_index_free(index);
+        return NULL;
+    }
+
+    for (int i = 0; i < addressbook->contact_count; i++) // Ids arrive in ascending order, so every add is an append
+    {
+        if (!contact_deleted(addressbook, i) && text_index_add(index, addressbook, i) != 0)
+        {
+            text_index_free(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+void text_index_free(struct Text_index *index) // Release all posting lists
+{
+    if (index == NULL)
+        return;
+    for (int g = 0; g < TRIGRAM_COUNT; g++)
+    {
+        if (index->name_lists)
+            free(index->name_lists[g].ids);
+        if (index->mail_lists)
+            free(index->mail_lists[g].ids);
+    }
+    free(index->name_lists);
+    free(index->mail_lists);
+    free(index);
+}
+
+int text_index_add(struct Text_index *index, const struct Address_book *addressbook, int contact) // Index Name and Mail_ID of one contact
+{
+    if (add_field(index->name_lists, contact_name(addressbook, contact), contact, 1) != 0 || // Edge trigrams for fuzzy_search
+        add_field(index->mail_lists, contact_mail(addressbook, contact), contact, 0) != 0)
+        return -1;
+    return 0;
+}
+
+/*------------------- Candidate Lookup -------------------*/
+static int gallop(const int *ids, int count, int from, int id) // First position >= from holding a value >= id
+{
+    int step = 1, hi = from;
+    while (hi < count && ids[hi] < id) // Exponential probe ahead
+    {
+        from = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > count)
+        hi = count;
+    while (from < hi) // Binary search inside the last step
+    {
+        int mid = from + (hi - from) / 2;
+        if (ids[mid] < id)
+            from = mid + 1;
+        else
+            hi = mid;
+    }
+    return from;
+}
+
+static int *candidates(const struct Posting_list *lists, const int *grams, int count, int *found) // Ids present in every list
+{
+    int shortest = 0;
+    for (int g = 1; g < count; g++) // Start from the rarest trigram
+        if (lists[grams[g]].count < lists[grams[shortest]].count)
+            shortest = g;
+
+    const struct Posting_list *base = &lists[grams[shortest]];
+    int *ids = malloc((size_t)(base->count + 1) * sizeof(int));
+    if (ids == NULL)
+        return NULL;
+    int n = base->count;
+    if (n > 0)
+        memcpy(ids, base->ids, (size_t)n * sizeof(int));
+
+    for (int g = 0; g < count && n > 0; g++) // Intersect with every other list
+    {
+        if (g == shortest)
+            continue;
+        const struct Posting_list *list = &lists[grams[g]];
+        int kept = 0, pos = 0;
+        for (int i = 0; i < n && pos < list->count; i++)
+        {
+            pos = gallop(list->ids, list->count, pos, ids[i]);
+            if (pos < list->count && list->ids[pos] == ids[i])
+                ids[kept++] = ids[i];
+        }
+        n = kept;
+    }
+    *found = n;
+    return ids;
+}
+
+/*------------------- Ranking -------------------*/
+static const char *find_folded(const char *text, const char *query, int len) // strstr in any case, over the whole text
+{
+    for (; *text != '\0'; text++)
+        if (tolower((unsigned char)*text) == tolower((unsigned char)query[0]) && strncasecmp(text, query, len) == 0)
+            return text;
+    return NULL;
+}
+
+static int name_rank(const char *name, const char *query, int len) // Rank of a name match, -1 if none
+{
+    if (strncasecmp(name, query, len) == 0)
+        return name[len] == '\0' ? 0 : 1; // Exact name, then name prefix
+    const char *hit = find_folded(name, query, len);
+    if (hit == NULL)
+        return -1;
+    for (; hit != NULL; hit = find_folded(hit + 1, query, len))
+        if (hit[-1] == ' ')
+            return 2; // Start of a later word ("reddy" in "sainath reddy")
+    return 3; // Anywhere inside the name
+}
+
+static int mail_rank(const char *mail, const char *query, int len) // Rank of a mail match, -1 if none
+{
+    if (strncasecmp(mail, query, len) == 0)
+        return 4;
+    return find_folded(mail, query, len) != NULL ? 5 : -1;
+}
+
+static int compare_hits(const void *a, const void *b) // Best rank first, then dictionary order
+{
+    const struct Ranked_hit *x = a, *y = b;
+    if (x->rank != y->rank)
+        return x->rank - y->rank;
+    int cmp = strcasecmp(x->key, y->key);
+    if (cmp != 0)
+        return cmp;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/*------------------- Text Search -------------------*/
+static int ranked_search(struct Address_book *addressbook, const char *query, int fields,
+                         int offset, int limit, struct Search_hit *hits, int *total) // Ranked, paged search
+{
+    char folded[MAX_QUERY];
+    int len = fold_text(folded, query, sizeof(folded));
+    const struct Name_index *names = &addressbook->name_index;
+    *total = 0;
+    if (len == 0)
+        return 0;
+
+    struct Ranked_hit *ranked = NULL;
+    int count = 0;
+
+    if (len < 3) // Too short for trigrams: name prefixes straight from the ordered index
+    {
+        if (!(fields & SEARCH_NAME))
+            return 0;
+        int capacity = 0;
+        for (int i = name_index_seek(names, addressbook, folded);
+             i != -1 && strncasecmp(contact_name(addressbook, i), folded, len) == 0;
+             i = name_index_next(names, i))
+        {
+            if (count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 64;
+                struct Ranked_hit *grown = realloc(ranked, (size_t)capacity * sizeof(*ranked));
+                if (grown == NULL)
+                {
+                    free(ranked);
+                    return -1;
+                }
+                ranked = grown;
+            }
+            const char *name = contact_name(addressbook, i);
+            ranked[count++] = (struct Ranked_hit){ i, name[len] == '\0' ? 0 : 1, name };
+        }
+    }
+    else
+    {
+        if (addressbook->text_index == NULL) // First partial search: build the trigram index
+        {
+            addressbook->text_index = text_index_build(addressbook);
+            if (addressbook->text_index == NULL)
+                return -1;
+        }
+
+        int grams[MAX_GRAMS]; // Candidates come from the trigrams of the first MAX_QUERY - 1 characters
+        int gram_count = collect_trigrams(folded, len, grams, 0);
+        int query_len = (int)strnlen(query, TEXT_MAX_LENGTH + 1);
+        int name_found = 0, mail_found = 0;
+        int *name_ids = (fields & SEARCH_NAME) ? candidates(addressbook->text_index->name_lists, grams, gram_count, &name_found) : NULL;
+        int *mail_ids = (fields & SEARCH_MAIL) ? candidates(addressbook->text_index->mail_lists, grams, gram_count, &mail_found) : NULL;
+        ranked = malloc((size_t)(name_found + mail_found + 1) * sizeof(*ranked));
+        if (ranked == NULL || ((fields & SEARCH_NAME) && name_ids == NULL) || ((fields & SEARCH_MAIL) && mail_ids == NULL))
+        {
+            free(name_ids);
+            free(mail_ids);
+            free(ranked);
+            return -1;
+        }
+
+        int a = 0, b = 0;
+        while (a < name_found || b < mail_found) // Merge both sorted id lists, keeping each contact once with its best rank
+        {
+            int id = a < name_found && (b >= mail_found || name_ids[a] <= mail_ids[b]) ? name_ids[a] : mail_ids[b];
+            int rank = -1;
+            if (a < name_found && name_ids[a] == id)
+            {
+                rank = name_rank(contact_name(addressbook, id), query, query_len); // Verify with the whole query: trigrams alone can give false hits
+                a++;
+            }
+            if (b < mail_found && mail_ids[b] == id)
+            {
+                if (rank == -1)
+                    rank = mail_rank(contact_mail(addressbook, id), query, query_len);
+                b++;
+            }
+            if (rank != -1 && !contact_deleted(addressbook, id)) // Postings of a deleted contact stay until compaction
+                ranked[count++] = (struct Ranked_hit){ id, rank, contact_name(addressbook, id) };
+        }
+        free(name_ids);
+        free(mail_ids);
+        stats_add(COUNT_CANDIDATES, (uint64_t)(name_found + mail_found));
+        qsort(ranked, count, sizeof(*ranked), compare_hits);
+    }
+
+    int written = 0;
+    for (int i = offset; i < count && written < limit; i++) // Copy out the requested page
+        hits[written++] = (struct Search_hit){ ranked[i].index, ranked[i].rank };
+    *total = count;
+    free(ranked);
+    return written;
+}
+
+int text_search(struct Address_book *addressbook, const char *query, int fields,
+                int offset, int limit, struct Search_hit *hits, int *total) // Timed ranked_search
+{
+    uint64_t start = stats_begin();
+    int written = ranked_search(addressbook, query, fields, offset, limit, hits, total);
+    stats_end(STAT_TEXT_SEARCH, start);
+    return written;
+}
+
+/*------------------- Fuzzy Search -------------------*/
+static int edit_distance(const uint64_t *peq, int length, const char *text) // Edits from the query (length <= 63, bits in peq) to text
+{
+    // One bit per query character: vp/vn are the +1/-1 steps down the current DP column, the
+    // transposition term carries a match of the previous text character one row further (Hyyro 2003)
+    uint64_t vp = ~0ULL, vn = 0, d0 = 0, previous = 0, last = 1ULL << (length - 1);
+    int distance = length;
+    for (; *text != '\0'; text++)
+    {
+        uint64_t pm = peq[(unsigned char)*text];
+        uint64_t swapped = ((~d0 & pm) << 1) & previous; // "ab" against "ba"
+        d0 = (((pm & vp) + vp) ^ vp) | pm | vn | swapped;
+        uint64_t hp = vn | ~(d0 | vp);
+        uint64_t hn = d0 & vp;
+        distance += (hp & last) != 0;
+        distance -= (hn & last) != 0;
+        hp = hp << 1 | 1;
+        hn <<= 1;
+        vp = hn | ~(d0 | hp);
+        vn = hp & d0;
+        previous = pm;
+    }
+    return distance;
+}
+
+int name_distance(const char *query, const char *name)
+{
+    int len = (int)strlen(query);
+    if (len == 0 || len >= 64)
+        return len == 0 ? (int)strlen(name) : -1;
+    uint64_t peq[256] = { 0 }; // Bit i set in peq[c] when query character i is c, in either case
+    for (int i = 0; i < len; i++)
+    {
+        peq[tolower((unsigned char)query[i])] |= 1ULL << i;
+        peq[toupper((unsigned char)query[i])] |= 1ULL << i;
+    }
+    return edit_distance(peq, len, name);
+}
+
+static void sift_down(struct List_cursor *heap, int size, int i) // Restore the min-heap (by id) below position i
+{
+    struct List_cursor item = heap[i];
+    for (int child = 2 * i + 1; child < size; i = child, child = 2 * i + 1)
+    {
+        if (child + 1 < size && heap[child + 1].id < heap[child].id)
+            child++;
+        if (heap[child].id >= item.id)
+            break;
+        heap[i] = heap[child];
+    }
+    heap[i] = item;
+}
+
+static int closest_names(struct Address_book *addressbook, const char *query, int max_distance,
+                         int offset, int limit, struct Search_hit *hits, int *total) // Names within max_distance edits, closest first
+{
+    char folded[MAX_QUERY];
+    int len = fold_text(folded, query, sizeof(folded));
+    *total = 0;
+    if (len == 0)
+        return 0;
+    if (addressbook->text_index == NULL) // Shares the trigram index with the partial search
+    {
+        addressbook->text_index = text_index_build(addressbook);
+        if (addressbook->text_index == NULL)
+            return -1;
+    }
+
+    int grams[MAX_GRAMS];
+    int gram_count = collect_trigrams(folded, len, grams, 1);
+    if (max_distance > FUZZY_MAX_DISTANCE)
+        max_distance = FUZZY_MAX_DISTANCE;
+    while (max_distance > 0 && gram_count - GRAMS_PER_EDIT * max_distance < 1)
+        max_distance--; // Short query: fewer edits, so every match still shares a trigram
+    if (max_distance < 0)
+        max_distance = 0;
+    int needed = gram_count - GRAMS_PER_EDIT * max_distance; // Query trigrams any match still has
+
+    const struct Posting_list *lists = addressbook->text_index->name_lists;
+    for (int a = 1; a < gram_count; a++) // Shortest lists first (insertion sort, a few dozen grams)
+    {
+        int gram = grams[a], b = a;
+        for (; b > 0 && lists[grams[b - 1]].count > lists[gram].count; b--)
+            grams[b] = grams[b - 1];
+        grams[b] = gram;
+    }
+
+    // A match misses at most gram_count - needed lists, so it is in one of the 'scanned' shortest ones;
+    // the longest lists ("kum", "ar ") are only probed for the contacts found there
+    int scanned = gram_count - needed + 1;
+
+    uint64_t peq[256] = { 0 }; // Bit i set in peq[c] when query character i is c, in either case (names are not folded)
+    for (int i = 0; i < len; i++)
+    {
+        peq[(unsigned char)folded[i]] |= 1ULL << i;
+        peq[toupper((unsigned char)folded[i])] |= 1ULL << i;
+    }
+
+    struct Ranked_hit *ranked = NULL;
+    int count = 0, capacity = 0;
+    struct List_cursor heap[MAX_GRAMS]; // The scanned lists, merged through a min-heap on their next id
+    int heap_size = 0;
+    for (int g = 0; g < scanned; g++)
+        if (lists[grams[g]].count > 0)
+            heap[heap_size++] = (struct List_cursor){ lists[grams[g]].ids[0], 0, &lists[grams[g]] };
+    for (int i = heap_size / 2 - 1; i >= 0; i--)
+        sift_down(heap, heap_size, i);
+
+    int positions[MAX_GRAMS] = { 0 }; // Gallop cursors into the long lists
+    while (heap_size > 0) // Only contacts in a scanned list are visited, in ascending order, so the cursors only move forward
+    {
+        int id = heap[0].id, shared = 0;
+        while (heap_size > 0 && heap[0].id == id) // Scanned lists holding this contact
+        {
+            shared++;
+            if (++heap[0].at < heap[0].list->count)
+                heap[0].id = heap[0].list->ids[heap[0].at];
+            else
+                heap[0] = heap[--heap_size];
+            sift_down(heap, heap_size, 0);
+        }
+        for (int g = scanned; g < gram_count && shared + (gram_count - g) >= needed && shared < needed; g++)
+        {
+            const struct Posting_list *list = &lists[grams[g]];
+            positions[g] = gallop(list->ids, list->count, positions[g], id);
+            if (positions[g] < list->count && list->ids[positions[g]] == id)
+                shared++;
+        }
+        if (shared < needed || contact_deleted(addressbook, id))
+            continue;
+        const char *key = contact_name(addressbook, id);
+        int key_len = (int)strlen(key);
+        if (key_len - len > max_distance || len - key_len > max_distance) // Every edit changes the length by one at most
+            continue;
+        stats_add(COUNT_CANDIDATES, 1);
+        int distance = edit_distance(peq, len, key);
+        if (distance > max_distance)
+            continue; // Shares trigrams but too many edits away, or an entry left by a rename
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            struct Ranked_hit *grown = realloc(ranked, (size_t)capacity * sizeof(*ranked));
+            if (grown == NULL)
+            {
+                free(ranked);
+                return -1;
+            }
+            ranked = grown;
+        }
+        ranked[count++] = (struct Ranked_hit){ id, distance, key };
+    }
+    if (count > 0)
+        qsort(ranked, count, sizeof(*ranked), compare_hits);
+
+    int written = 0;
+    for (int i = offset; i < count && written < limit; i++) // Copy out the requested page
+        hits[written++] = (struct Search_hit){ ranked[i].index, ranked[i].rank };
+    *total = count;
+    free(ranked);
+    return written;
+}
+
+int fuzzy_search(struct Address_book *addressbook, const char *query, int max_distance,
+                 int offset, int limit, struct Search_hit *hits, int *total) // Timed closest_names
+{
+    uint64_t start = stats_begin();
+    int written = closest_names(addressbook, query, max_distance, offset, limit, hits, total);
+    stats_end(STAT_FUZZY_SEARCH, start);
+    return written;
+}
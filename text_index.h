@@ -0,0 +1,43 @@
+#ifndef TEXT_INDEX_H        // Header guard start, prevents multiple inclusion
+#define TEXT_INDEX_H
+
+struct Address_book;        // Defined in contact.h
+
+#define SEARCH_NAME 1       // text_search field flag: match inside Name
+#define SEARCH_MAIL 2       // text_search field flag: match inside Mail_ID
+#define FUZZY_DISTANCE 2    // Edits the menu's name search allows when no name matches exactly
+#define FUZZY_MAX_DISTANCE 3 // Most edits fuzzy_search allows (short queries get fewer)
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Posting_list         // Sorted contact indices containing one trigram
+{
+    int *ids;               // Contact indices, ascending, no repeats
+    int count;              // Number of ids stored
+    int capacity;           // Number of ids allocated
+};
+
+struct Text_index           // Trigram inverted index over folded Name and Mail_ID
+{
+    struct Posting_list *name_lists; // One list per name trigram code
+    struct Posting_list *mail_lists; // One list per mail trigram code
+};
+
+struct Search_hit           // One ranked match returned by text_search
+{
+    int index;              // Contact index in contact_details
+    int rank;               // 0 = exact name ... 5 = inside mail, or edits for fuzzy_search (lower is better)
+};
+
+/*------------------ Function Declarations ------------------*/
+
+struct Text_index *text_index_build(const struct Address_book *addressbook); // Index every contact, NULL if out of memory
+void text_index_free(struct Text_index *index); // Release the index
+int text_index_add(struct Text_index *index, const struct Address_book *addressbook, int contact); // Index a new or edited contact, 0 or -1
+int text_search(struct Address_book *addressbook, const char *query, int fields,
+                int offset, int limit, struct Search_hit *hits, int *total); // Ranked, paged prefix/substring search, hits written or -1
+int fuzzy_search(struct Address_book *addressbook, const char *query, int max_distance,
+                 int offset, int limit, struct Search_hit *hits, int *total); // Whole names within max_distance edits (typos, swapped letters), closest first, hits written or -1
+int name_distance(const char *query, const char *name); // Edits (swaps count as one) from a folded query of up to 63 characters to a name in any case, -1 if longer
+
+#endif // TEXT_INDEX_H       // End of header guard
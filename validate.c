@@ -0,0 +1,222 @@
+/*------------------------------------------------------------------------------
+-> File         : validate.c
+-> Description  : Contact rules as pure functions: no input, no output, an
+                  error code back (validate.h). The menu prompts, the bulk
+                  loader and batch mode all use the same rules.
+
+                  validate_contacts checks a whole array in one pass. With
+                  SSE2 it copies the first 32 bytes of the name and the
+                  mail ID into a zero-padded window, loads each window as
+                  two 16-byte vectors, classifies every byte at once
+                  (digit, lowercase, letter, '.', '-', '@', NUL) into bit
+                  masks, and checks the rules with a few mask operations
+                  per record. Longer fields go to the scalar rules, and so
+                  do rows it rejects (rare), so they get the same error
+                  code as everywhere else.
+------------------------------------------------------------------------------*/
+#include <string.h>     // Include strlen
+#include "contact.h"    // Include structure definitions and function prototypes
+#ifdef __SSE2__
+#include <emmintrin.h>  // Include SSE2 intrinsics
+#endif
+
+static int is_lower(char c) { return c >= 'a' && c <= 'z'; }  // ASCII only, like the "C" locale
+static int is_alpha(char c) { return is_lower(c) || (c >= 'A' && c <= 'Z'); }
+static int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+/*------------------- Single Field Rules -------------------*/
+int check_name(const char *name) // Letters and spaces, starting with a letter
+{
+    if (name[0] == '\0')
+        return NAME_EMPTY;
+    if (strlen(name) > TEXT_MAX_LENGTH)
+        return NAME_TOO_LONG;
+    if (!is_alpha(name[0]))
+        return NAME_FIRST_NOT_ALPHA;
+    for (int i = 1; name[i] != '\0'; i++)
+        if (!is_alpha(name[i]) && name[i] != ' ')
+            return NAME_BAD_CHAR;
+    return VALID;
+}
+
+int check_mobile_number(const char *mobile_number) // Exactly 10 digits
+{
+    if (strlen(mobile_number) != 10)
+        return MOBILE_LENGTH;
+    for (int i = 0; i < 10; i++)
+        if (!is_digit(mobile_number[i]))
+            return MOBILE_NOT_DIGITS;
+    return VALID;
+}
+
+int check_mail_id(const char *mail_id) // local@domain with the project's rules
+{
+    if (strlen(mail_id) > TEXT_MAX_LENGTH)
+        return MAIL_TOO_LONG;
+    int at_count = 0, at_pos = -1;
+    for (int i = 0; mail_id[i] != '\0'; i++)
+        if (mail_id[i] == '@')
+        {
+            at_count++;
+            at_pos = i;
+        }
+    if (at_count != 1)
+        return MAIL_AT_COUNT;
+    if (at_pos < 5)
+        return MAIL_LOCAL_SHORT;
+    if (!is_lower(mail_id[0]))
+        return MAIL_FIRST_NOT_LOWER;
+    for (int i = 0; i < at_pos; i++)
+        if (!is_lower(mail_id[i]) && !is_digit(mail_id[i]))
+            return MAIL_LOCAL_CHARS;
+
+    int has_letter = 0, has_dot = 0;
+    for (int i = at_pos + 1; mail_id[i] != '\0'; i++)
+    {
+        if (!is_alpha(mail_id[i]) && !is_digit(mail_id[i]) && mail_id[i] != '.' && mail_id[i] != '-')
+            return MAIL_DOMAIN_CHARS;
+        has_letter |= is_alpha(mail_id[i]);
+        has_dot |= mail_id[i] == '.';
+    }
+    if (!has_letter)
+        return MAIL_DOMAIN_NO_LETTER;
+    if (!has_dot)
+        return MAIL_DOMAIN_NO_DOT;
+    return VALID;
+}
+
+int check_contact(const struct Contact_data *contact) // First failing rule of any field
+{
+    int error = check_name(contact->Name);
+    if (error == VALID)
+        error = check_mobile_number(contact->Mobile_number);
+    if (error == VALID)
+        error = check_mail_id(contact->Mail_ID);
+    return error;
+}
+
+const char *validation_message(int error) // Shown by the menu and in skipped-line reports
+{
+    switch (error)
+    {
+        case VALID:                 return "Valid";
+        case NAME_EMPTY:            return "Name must not be empty";
+        case NAME_FIRST_NOT_ALPHA:  return "First letter must be an alphabet";
+        case NAME_BAD_CHAR:         return "Name can contain only alphabets and spaces";
+        case MOBILE_LENGTH:         return "Mobile number must be exactly 10 digits";
+        case MOBILE_NOT_DIGITS:     return "Mobile number must contain only digits";
+        case MAIL_AT_COUNT:         return "Mail must contain exactly one '@'";
+        case MAIL_LOCAL_SHORT:      return "At least 5 characters required before '@'";
+        case MAIL_FIRST_NOT_LOWER:  return "First letter must be lowercase";
+        case MAIL_LOCAL_CHARS:      return "Local part can have only lowercase letters or digits";
+        case MAIL_DOMAIN_CHARS:     return "Domain can have only letters, digits, '.' or '-'";
+        case MAIL_DOMAIN_NO_LETTER: return "Domain must have at least one letter";
+        case MAIL_DOMAIN_NO_DOT:    return "Domain must contain '.'";
+        case DUPLICATE_MOBILE:      return "Mobile number already exists";
+        case DUPLICATE_MAIL:        return "Mail ID already exists";
+        case NAME_TOO_LONG:         return "Name can have at most 16777215 characters";
+        case MAIL_TOO_LONG:         return "Mail ID can have at most 16777215 characters";
+    }
+    return "Invalid";
+}
+
+/*------------------- Batch Validator -------------------*/
+#ifdef __SSE2__
+struct Byte_classes             // One bit per byte of a 32-byte window
+{
+    unsigned int nul, lower, upper, digit, dot, dash, space, at;
+};
+
+static unsigned int in_range(__m128i v, char low, char high) // Bytes in [low, high], as a 16-bit mask
+{
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(low)); // Unsigned trick: in range <=> (v - low) <= (high - low)
+    __m128i limit = _mm_set1_epi8((char)(high - low));
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(shifted, limit), shifted));
+}
+
+static unsigned int equal_to(__m128i v, char c)
+{
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+static void classify(const char *p, struct Byte_classes *classes) // Classify 32 bytes starting at p
+{
+    __m128i lo = _mm_loadu_si128((const __m128i *)p);
+    __m128i hi = _mm_loadu_si128((const __m128i *)(p + 16));
+    classes->nul = equal_to(lo, 0) | equal_to(hi, 0) << 16;
+    classes->lower = in_range(lo, 'a', 'z') | in_range(hi, 'a', 'z') << 16;
+    classes->upper = in_range(lo, 'A', 'Z') | in_range(hi, 'A', 'Z') << 16;
+    classes->digit = in_range(lo, '0', '9') | in_range(hi, '0', '9') << 16;
+    classes->dot = equal_to(lo, '.') | equal_to(hi, '.') << 16;
+    classes->dash = equal_to(lo, '-') | equal_to(hi, '-') << 16;
+    classes->space = equal_to(lo, ' ') | equal_to(hi, ' ') << 16;
+    classes->at = equal_to(lo, '@') | equal_to(hi, '@') << 16;
+}
+
+static unsigned int below(int n) // Mask of bits 0 .. n-1 (n <= 32)
+{
+    return n >= 32 ? 0xffffffffu : (1u << n) - 1;
+}
+
+static void classify_text(const char *text, struct Byte_classes *classes) // Classify a string's first 32 bytes, loading nothing past its NUL
+{
+    char window[32] = { 0 };
+    memcpy(window, text, strnlen(text, sizeof(window)));
+    classify(window, classes);
+}
+
+static int name_ok(const struct Contact_data *contact) // First 32 Name bytes in two vectors
+{
+    struct Byte_classes c;
+    classify_text(contact->Name, &c);
+    if (c.nul == 0) // Longer than 31 characters: leave it to the scalar rules
+        return check_name(contact->Name) == VALID;
+    int length = __builtin_ctz(c.nul);
+    unsigned int used = below(length), letters = c.lower | c.upper;
+    return length > 0 && (letters & 1) && (used & ~(letters | c.space)) == 0;
+}
+
+static int mobile_ok(const struct Contact_data *contact) // 10 digits then NUL, one vector (stays inside the record)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)contact->Mobile_number);
+    return (in_range(v, '0', '9') & 0x3ff) == 0x3ff && (equal_to(v, 0) & 0x400);
+}
+
+static int mail_ok(const struct Contact_data *contact) // First 32 Mail_ID bytes in two vectors
+{
+    struct Byte_classes c;
+    classify_text(contact->Mail_ID, &c);
+    if (c.nul == 0) // Longer than 31 characters: leave it to the scalar rules
+        return check_mail_id(contact->Mail_ID) == VALID;
+    int length = __builtin_ctz(c.nul);
+    unsigned int used = below(length), at = c.at & used;
+    if (at == 0 || (at & (at - 1)) != 0) // Exactly one '@'
+        return 0;
+    int at_pos = __builtin_ctz(at);
+    unsigned int local = below(at_pos), domain = used & ~below(at_pos + 1);
+    unsigned int letters = c.lower | c.upper;
+    return at_pos >= 5 && (c.lower & 1) &&
+           (local & ~(c.lower | c.digit)) == 0 &&
+           (domain & ~(letters | c.digit | c.dot | c.dash)) == 0 &&
+           (domain & letters) != 0 && (domain & c.dot) != 0;
+}
+#endif
+
+int validate_contacts(const struct Contact_data *records, int count, unsigned char *errors) // Every row checked, invalid ones counted
+{
+    int invalid = 0;
+    for (int i = 0; i < count; i++)
+    {
+#ifdef __SSE2__
+        // Mobile_number is loaded from the record (bytes 8-23 of 32), the strings through a window
+        if (name_ok(&records[i]) && mobile_ok(&records[i]) && mail_ok(&records[i]))
+        {
+            errors[i] = VALID;
+            continue;
+        }
+#endif
+        errors[i] = (unsigned char)check_contact(&records[i]); // Exact code for rejected rows
+        invalid += errors[i] != VALID;
+    }
+    return invalid;
+}
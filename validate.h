@@ -0,0 +1,36 @@
+#ifndef VALIDATE_H          // Header guard start, prevents multiple inclusion
+#define VALIDATE_H
+
+struct Contact_data;        // Defined in contact.h
+
+/* Validation error codes, 0 = valid (first failing rule is reported) */
+#define VALID                   0
+#define NAME_EMPTY              1   // Name has no characters
+#define NAME_FIRST_NOT_ALPHA    2   // Name does not start with a letter
+#define NAME_BAD_CHAR           3   // Name has something other than letters and spaces
+#define MOBILE_LENGTH           4   // Mobile number is not exactly 10 characters
+#define MOBILE_NOT_DIGITS       5   // Mobile number has a non-digit
+#define MAIL_AT_COUNT           6   // Mail ID does not have exactly one '@'
+#define MAIL_LOCAL_SHORT        7   // Fewer than 5 characters before '@'
+#define MAIL_FIRST_NOT_LOWER    8   // Mail ID does not start with a lowercase letter
+#define MAIL_LOCAL_CHARS        9   // Local part has something other than lowercase letters and digits
+#define MAIL_DOMAIN_CHARS       10  // Domain has something other than letters, digits, '.' and '-'
+#define MAIL_DOMAIN_NO_LETTER   11  // Domain has no letter
+#define MAIL_DOMAIN_NO_DOT      12  // Domain has no '.'
+#define DUPLICATE_MOBILE        13  // Mobile number already belongs to a contact
+#define DUPLICATE_MAIL          14  // Mail ID already belongs to a contact
+#define NAME_TOO_LONG           15  // Name longer than a stored string can be (16 MiB)
+#define MAIL_TOO_LONG           16  // Mail ID longer than a stored string can be
+
+#define INPUT_SIZE 256               // Buffer the menu reads a mobile number or search text into
+
+/*------------------ Function Declarations ------------------*/
+
+int check_name(const char *name); // Name rules, VALID or an error code
+int check_mobile_number(const char *mobile_number); // Mobile rules (uniqueness is the caller's), VALID or an error code
+int check_mail_id(const char *mail_id); // Mail rules (uniqueness is the caller's), VALID or an error code
+int check_contact(const struct Contact_data *contact); // All three, first error or VALID
+const char *validation_message(int error); // Text shown to the user for an error code
+int validate_contacts(const struct Contact_data *records, int count, unsigned char *errors); // Check every record in one pass, errors[i] = code, returns invalid count
+
+#endif // VALIDATE_H         // End of header guard
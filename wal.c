@@ -0,0 +1,602 @@
+/*------------------------------------------------------------------------------
+-> File         : wal.c
+-> Description  : Append-only change log (data.wal) on top of the snapshot.
+                  Every insert, update and remove of a logged book appends
+                  one checksummed record (a fixed head, then the name and
+                  mail ID at their own length), so a save costs what the
+                  change costs instead of rewriting the book. Records
+                  are written at once and a flusher thread makes them
+                  durable: it waits WAL_COMMIT_DELAY_MS after the first
+                  unsynced write, so one sync commits every change that
+                  arrived meanwhile (group commit). The sync used follows
+                  the durability level (durability.c).
+
+                  Each record carries the generation it applies on top of.
+                  Startup replays records whose generation is not older
+                  than the snapshot's; a torn record at the end (crash in
+                  mid-write) ends the replay and is cut off. A book
+                  imported from text starts a new log: an old one still
+                  holding records is renamed to data.wal.N and reported,
+                  never emptied.
+
+                  Once the log holds more records than the book has
+                  contacts (and at least WAL_COMPACT_MIN), the book is
+                  copied and a background thread writes it as a snapshot of
+                  the next generation. New changes keep going to the log
+                  meanwhile, stamped with that generation. When the
+                  snapshot is in place, the older records are dropped by
+                  rewriting the log as just its newer tail. A crash at any
+                  point leaves a snapshot and log that replay correctly.
+                  wal_checkpoint does the same at once, on the caller's
+                  thread, for bulk changes made without logging (merge.c).
+------------------------------------------------------------------------------*/
+#include <stdio.h>      // Include standard input/output functions (snprintf, rename)
+#include <stdlib.h>     // Include memory functions (malloc, free)
+#include <string.h>     // Include string handling functions (memcpy, memset, strdup)
+#include <errno.h>      // Include EINTR, ETIMEDOUT
+#include <fcntl.h>      // Include open
+#include <unistd.h>     // Include write, pread, ftruncate
+#include <time.h>       // Include clock_gettime for the commit delay
+#include <sys/stat.h>   // Include fstat to find a torn end
+#include "contact.h"    // Include structure definitions and function prototypes
+#include "durability.h" // Include sync_file / replace_file
+#include "stats.h"      // Include operation counters
+
+#define WAL_MAGIC "ABKWLOG"         // First 8 bytes of the log (with the NUL)
+#define WAL_VERSION 2               // Bumped whenever the record layout changes
+#define WAL_RECORD_MAGIC 0x7e57c0deu // Start of every record
+#define REPLAY_BLOCK (1 << 17)      // Bytes read per pread() during replay
+#define SMALL_RECORD 512            // Records up to this size are put together on the stack
+#define WAL_KEPT_MAX 100            // Logs an import may set aside (data.wal.1 ...) before it refuses
+
+struct Wal_header               // First 16 bytes of the log
+{
+    char magic[8];              // WAL_MAGIC
+    uint32_t version;           // WAL_VERSION
+    uint32_t record_size;       // sizeof(struct Wal_record) of the writer
+};
+
+struct Wal_record               // Head of one change; the name and mail ID (each with its NUL) follow, then a uint64_t checksum
+{
+    uint32_t magic;             // WAL_RECORD_MAGIC
+    uint32_t op;                // WAL_ADD, WAL_EDIT or WAL_DELETE
+    uint64_t generation;        // Snapshot generation this change applies on top of
+    char key[16];               // Mobile number of the contact edited or deleted
+    char mobile[16];            // New Mobile_number (add, edit)
+    uint32_t name_length;       // strlen of the new Name (add, edit)
+    uint32_t mail_length;       // strlen of the new Mail_ID (add, edit)
+};
+
+/*------------------- Write Helpers -------------------*/
+static int write_all(int fd, const void *data, size_t length) // write() until done, 0 or -1
+{
+    const char *p = data;
+    stats_add(COUNT_BYTES_WRITTEN, length);
+    while (length > 0)
+    {
+        ssize_t done = write(fd, p, length);
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            return -1;
+        p += done;
+        length -= (size_t)done;
+    }
+    return 0;
+}
+
+static size_t record_length(const struct Wal_record *record) // Head, both strings, checksum
+{
+    return sizeof(*record) + record->name_length + 1 + record->mail_length + 1 + sizeof(uint64_t);
+}
+
+static int write_header(int fd) // Log header at the current position, 0 or -1
+{
+    struct Wal_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+    header.version = WAL_VERSION;
+    header.record_size = sizeof(struct Wal_record);
+    return write_all(fd, &header, sizeof(header));
+}
+
+static int create_log(const char *path, const void *tail, size_t tail_length) // Header + tail in a new file renamed over 'path', fd or -1
+{
+    char temp[4096];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return -1;
+    int fd = open(temp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+
+    if (write_header(fd) != 0 || write_all(fd, tail, tail_length) != 0 ||
+        sync_file(fd) != 0 || replace_file(temp, path) != 0)
+    {
+        close(fd);
+        remove(temp);
+        return -1;
+    }
+    return fd;
+}
+
+/*------------------- Group Commit -------------------*/
+static void *flush_log(void *arg) // Flusher thread: one sync for every batch of writes
+{
+    struct Wal *wal = arg;
+    pthread_mutex_lock(&wal->lock);
+    while (1)
+    {
+        while (!wal->stop && wal->synced == wal->written)
+            pthread_cond_wait(&wal->changed, &wal->lock);
+        if (wal->synced == wal->written) // Stopping and nothing left
+            break;
+
+        struct timespec deadline; // Let more changes join this commit, unless someone is blocked on it
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += WAL_COMMIT_DELAY_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!wal->stop && wal->waiters == 0 &&
+               pthread_cond_timedwait(&wal->changed, &wal->lock, &deadline) != ETIMEDOUT)
+            ;
+
+        unsigned long long target = wal->written; // Everything written so far
+        int fd = wal->fd;
+        wal->syncing = 1;
+        pthread_mutex_unlock(&wal->lock);
+        int status = sync_file(fd);
+        pthread_mutex_lock(&wal->lock);
+        wal->syncing = 0;
+        if (status != 0)
+            wal->failed = 1;
+        wal->synced = target;
+        pthread_cond_broadcast(&wal->changed);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    return NULL;
+}
+
+static int append_record(struct Wal *wal, struct Wal_record *record, const char *name, const char *mail) // Stamp, checksum and write one record, 0 or -1
+{
+    size_t length = record_length(record);
+    char small[SMALL_RECORD];
+    char *buffer = length <= sizeof(small) ? small : malloc(length);
+    if (buffer == NULL)
+        return -1;
+    pthread_mutex_lock(&wal->lock);
+    record->generation = wal->generation;
+    char *p = buffer; // One write() per record, so a crash tears at most the last one
+    memcpy(p, record, sizeof(*record));
+    p += sizeof(*record);
+    memcpy(p, name, record->name_length + 1);
+    p += record->name_length + 1;
+    memcpy(p, mail, record->mail_length + 1);
+    p += record->mail_length + 1;
+    uint64_t checksum = snapshot_checksum(0, buffer, (size_t)(p - buffer));
+    memcpy(p, &checksum, sizeof(checksum));
+    int status = write_all(wal->fd, buffer, length);
+    if (status == 0)
+    {
+        wal->size += (off_t)length;
+        wal->records++;
+        if (wal->written++ == wal->synced) // Flusher is idle: start a commit (otherwise it is already pending)
+            pthread_cond_signal(&wal->changed);
+    }
+    else
+    {
+        if (ftruncate(wal->fd, wal->size) == 0) // Drop a partial record so later ones still replay
+            lseek(wal->fd, wal->size, SEEK_SET);
+        wal->failed = 1;
+    }
+    pthread_mutex_unlock(&wal->lock);
+    if (buffer != small)
+        free(buffer);
+    return status;
+}
+
+/*------------------- Compaction -------------------*/
+static void *write_compacted(void *arg) // Compaction thread: write the copied book as the next snapshot
+{
+    struct Wal *wal = arg;
+    int status = write_snapshot(wal->snapshot_path, wal->compact_records, wal->compact_order,
+                                wal->compact_count, &wal->compact_strings, wal->compact_generation);
+    pthread_mutex_lock(&wal->lock);
+    wal->compact_status = status;
+    wal->compact_done = 1;
+    pthread_mutex_unlock(&wal->lock);
+    return NULL;
+}
+
+static void complete_compaction(struct Wal *wal) // Drop log records the new snapshot holds
+{
+    wal->compacting = 0;
+    wal->compact_done = 0;
+    free(wal->compact_records);
+    free(wal->compact_order);
+    arena_free(&wal->compact_strings);
+    wal->compact_records = NULL;
+    wal->compact_order = NULL;
+    if (wal->compact_status != 0)
+    {
+        report_problem("%s: could not write snapshot, change log kept\n", wal->snapshot_path);
+        return; // Replay applies both generations in order, so nothing is lost
+    }
+
+    pthread_mutex_lock(&wal->lock);
+    while (wal->syncing) // The flusher must not be using the old fd
+        pthread_cond_wait(&wal->changed, &wal->lock);
+
+    size_t tail_length = (size_t)(wal->size - wal->compact_from); // Records written since the copy was taken
+    char *tail = malloc(tail_length ? tail_length : 1);
+    int fd = -1;
+    if (tail != NULL && pread(wal->fd, tail, tail_length, wal->compact_from) == (ssize_t)tail_length)
+        fd = create_log(wal->path, tail, tail_length);
+    free(tail);
+    if (fd >= 0)
+    {
+        close(wal->fd);
+        wal->fd = fd;
+        wal->size = sizeof(struct Wal_header) + tail_length;
+        wal->records -= wal->compact_from_records;
+        wal->synced = wal->written; // The new file was synced before the rename
+        lseek(fd, wal->size, SEEK_SET);
+    }
+    else
+        report_problem("%s: could not trim the change log, it is trimmed at the next compaction\n", wal->path);
+    pthread_mutex_unlock(&wal->lock);
+}
+
+static void finish_compaction(struct Wal *wal) // Join the compactor and trim the log
+{
+    pthread_join(wal->compactor, NULL);
+    complete_compaction(wal);
+}
+
+static void start_compaction(struct Address_book *addressbook) // Copy the book and write it out on another thread
+{
+    struct Wal *wal = addressbook->wal;
+    int count = copy_contacts(addressbook, &wal->compact_records, &wal->compact_order,
+                              &wal->compact_strings); // Without deleted slots or dropped strings
+    if (count < 0)
+    {
+        wal->compact_records = NULL;
+        wal->compact_order = NULL;
+        return; // Out of memory: try again at the next change
+    }
+    wal->compact_count = count;
+    if (addressbook->strings.garbage > 0)
+        compact_strings(addressbook); // The book drops them too, best effort
+
+    pthread_mutex_lock(&wal->lock);
+    wal->generation++;                  // Changes from now on are not in the copy
+    wal->compact_generation = wal->generation;
+    wal->compact_from = wal->size;
+    wal->compact_from_records = wal->records;
+    wal->compact_done = 0;
+    pthread_mutex_unlock(&wal->lock);
+
+    if (pthread_create(&wal->compactor, NULL, write_compacted, wal) == 0)
+        wal->compacting = 1;
+    else
+    {
+        write_compacted(wal); // No thread: write it here
+        complete_compaction(wal);
+    }
+}
+
+/*------------------- Log One Change -------------------*/
+void wal_log_change(struct Address_book *addressbook, int op, const char *key, int contact) // Called by store.c after each change
+{
+    struct Wal *wal = addressbook->wal;
+    struct Wal_record record;
+    memset(&record, 0, sizeof(record)); // Padding bytes are checksummed too
+    record.magic = WAL_RECORD_MAGIC;
+    record.op = (uint32_t)op;
+    if (key != NULL)
+        strncpy(record.key, key, sizeof(record.key) - 1);
+    const char *name = "", *mail = "";
+    if (op != WAL_DELETE)
+    {
+        strncpy(record.mobile, contact_mobile(addressbook, contact), sizeof(record.mobile) - 1);
+        name = contact_name(addressbook, contact);
+        mail = contact_mail(addressbook, contact);
+        record.name_length = (uint32_t)strlen(name);
+        record.mail_length = (uint32_t)strlen(mail);
+    }
+    if (append_record(wal, &record, name, mail) != 0)
+        report_problem("%s: could not log change, it will be lost at exit\n", wal->path);
+
+    if (wal->compacting)
+    {
+        pthread_mutex_lock(&wal->lock);
+        int done = wal->compact_done;
+        pthread_mutex_unlock(&wal->lock);
+        if (done)
+            finish_compaction(wal);
+    }
+    if (!wal->compacting && wal->records >= WAL_COMPACT_MIN && wal->records > count_contacts(addressbook))
+        start_compaction(addressbook);
+}
+
+/*------------------- Replay -------------------*/
+static int apply_record(struct Address_book *addressbook, const struct Wal_record *record,
+                        const char *name, const char *mail) // Redo one change, 0 or -1
+{
+    struct Contact_data contact = { name, "", mail };
+    memcpy(contact.Mobile_number, record->mobile, sizeof(contact.Mobile_number) - 1);
+    switch (record->op)
+    {
+        case WAL_ADD:
+            if (find_by_mobile(addressbook, contact.Mobile_number) != -1 || find_by_mail(addressbook, mail) != -1)
+                return -1; // Would break uniqueness
+            return insert_contact(addressbook, &contact) == -1 ? -1 : 0;
+
+        case WAL_EDIT:
+        {
+            int index = find_by_mobile(addressbook, record->key);
+            return index == -1 ? -1 : update_contact(addressbook, index, &contact);
+        }
+
+        case WAL_DELETE:
+        {
+            int index = find_by_mobile(addressbook, record->key);
+            if (index == -1)
+                return -1;
+            remove_contact(addressbook, index);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int check_record(const struct Wal_record *record, const char *bytes) // Whole record as written? (lengths already bounded)
+{
+    const char *name = bytes + sizeof(*record);
+    const char *mail = name + record->name_length + 1;
+    uint64_t checksum;
+    memcpy(&checksum, mail + record->mail_length + 1, sizeof(checksum));
+    return checksum == snapshot_checksum(0, bytes, record_length(record) - sizeof(checksum)) &&
+           name[record->name_length] == '\0' && mail[record->mail_length] == '\0' &&
+           memchr(record->key, '\0', sizeof(record->key)) != NULL &&
+           memchr(record->mobile, '\0', sizeof(record->mobile)) != NULL;
+}
+
+static int replay_log(struct Wal *wal, struct Address_book *addressbook, uint64_t generation) // Apply records not in the snapshot, count or -1
+{
+    struct Wal_header header;
+    ssize_t got = pread(wal->fd, &header, sizeof(header), 0);
+    if (got != 0 && (got != (ssize_t)sizeof(header) || memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 ||
+                     header.version != WAL_VERSION || header.record_size != sizeof(struct Wal_record)))
+    {
+        report_problem("%s: not a change log of this version, ignored\n", wal->path);
+        got = 0;
+        if (ftruncate(wal->fd, 0) != 0)
+            return -1;
+    }
+    if (got == 0) // New (or discarded) file: just the header
+    {
+        if (write_header(wal->fd) != 0)
+            return -1;
+        wal->size = sizeof(header);
+        wal->generation = generation;
+        return 0;
+    }
+
+    size_t capacity = REPLAY_BLOCK, have = 0; // Bytes buffered from 'offset' on
+    char *block = malloc(capacity);
+    if (block == NULL)
+        return -1;
+    off_t offset = sizeof(header); // Start of the first record not yet applied
+    uint64_t newest = generation;
+    int replayed = 0, conflicts = 0, torn = 0;
+    while (!torn)
+    {
+        size_t at = 0;
+        struct Wal_record record;
+        while (have - at >= sizeof(record)) // Every whole record in the buffer
+        {
+            memcpy(&record, block + at, sizeof(record));
+            if (record.magic != WAL_RECORD_MAGIC || record.name_length > TEXT_MAX_LENGTH ||
+                record.mail_length > TEXT_MAX_LENGTH)
+            {
+                torn = 1;
+                break;
+            }
+            size_t length = record_length(&record);
+            if (have - at < length) // Rest of it still on disk
+                break;
+            if (!check_record(&record, block + at))
+            {
+                torn = 1;
+                break;
+            }
+            const char *name = block + at + sizeof(record);
+            at += length;
+            offset += (off_t)length;
+            wal->records++;
+            if (record.generation > newest)
+                newest = record.generation;
+            if (record.generation < generation) // Already folded into the snapshot
+                continue;
+            if (apply_record(addressbook, &record, name, name + record.name_length + 1) == 0)
+                replayed++;
+            else
+                conflicts++;
+        }
+        if (torn)
+            break;
+
+        memmove(block, block + at, have - at); // Keep the partial record, read what follows it
+        have -= at;
+        if (have >= sizeof(record) && record_length(&record) > capacity) // A record longer than the buffer
+        {
+            char *grown = realloc(block, record_length(&record));
+            if (grown == NULL)
+            {
+                free(block);
+                return -1;
+            }
+            block = grown;
+            capacity = record_length(&record);
+        }
+        got = pread(wal->fd, block + have, capacity - have, offset + (off_t)have);
+        if (got <= 0) // End of the log (a partial record left over is cut off below), or an error
+            break;
+        stats_add(COUNT_BYTES_READ, (uint64_t)got);
+        have += (size_t)got;
+    }
+    free(block);
+    if (got < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(wal->fd, &st) == 0 && st.st_size > offset) // Cut off a torn or damaged end
+    {
+        report_problem("%s: incomplete change at the end dropped\n", wal->path);
+        if (ftruncate(wal->fd, offset) != 0)
+            return -1;
+    }
+    if (conflicts > 0)
+        report_problem("%s: %d changes could not be replayed\n", wal->path, conflicts);
+    wal->size = offset;
+    wal->generation = newest; // Keep stamping the newest generation so record order is kept
+    return replayed;
+}
+
+/*------------------- Open / Sync / Close -------------------*/
+static int keep_old_log(const char *path) // Move a log holding records aside before an import starts a new one, 0 or -1
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size <= (off_t)sizeof(struct Wal_header))
+        return 0; // No log, or no records in it: nothing is lost
+    char kept[4096];
+    for (int i = 1; i <= WAL_KEPT_MAX; i++) // data.wal.1, data.wal.2 ...: never over an older one
+    {
+        if (snprintf(kept, sizeof(kept), "%s.%d", path, i) >= (int)sizeof(kept))
+            return -1;
+        if (access(kept, F_OK) == 0)
+            continue;
+        if (rename(path, kept) != 0)
+            break;
+        report_problem("Warning: %s holds changes that are not in the imported book, moved to %s\n", path, kept);
+        return 0;
+    }
+    report_problem("Error: %s holds changes that are not in the imported book and could not be moved aside\n", path);
+    return -1;
+}
+
+int wal_open(struct Address_book *addressbook, const char *path, const char *snapshot_path, long long generation) // Attach a log to the book
+{
+    struct Wal *wal = calloc(1, sizeof(*wal));
+    if (wal == NULL)
+        return -1;
+    wal->path = strdup(path);
+    wal->snapshot_path = strdup(snapshot_path);
+    wal->fd = -1;
+    int replayed = -1;
+
+    if (wal->path != NULL && wal->snapshot_path != NULL)
+    {
+        if (generation >= 0) // Book came from a snapshot: redo what happened since
+        {
+            wal->fd = open(path, O_RDWR | O_CREAT, 0644);
+            if (wal->fd >= 0)
+                replayed = replay_log(wal, addressbook, (uint64_t)generation);
+        }
+        else // Book was imported from text: empty log first, then a snapshot it applies to
+        {
+            wal->fd = keep_old_log(path) == 0 ? create_log(path, NULL, 0) : -1;
+            if (wal->fd >= 0 && save_snapshot(addressbook, snapshot_path, 0) == 0)
+            {
+                wal->size = sizeof(struct Wal_header);
+                replayed = 0;
+            }
+        }
+    }
+    if (replayed < 0 || lseek(wal->fd, wal->size, SEEK_SET) < 0)
+    {
+        if (wal->fd >= 0)
+            close(wal->fd);
+        free(wal->path);
+        free(wal->snapshot_path);
+        free(wal);
+        return -1;
+    }
+
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->changed, NULL);
+    if (pthread_create(&wal->flusher, NULL, flush_log, wal) != 0)
+    {
+        pthread_mutex_destroy(&wal->lock);
+        pthread_cond_destroy(&wal->changed);
+        close(wal->fd);
+        free(wal->path);
+        free(wal->snapshot_path);
+        free(wal);
+        return -1;
+    }
+    addressbook->wal = wal; // From here on every change is logged
+    return replayed;
+}
+
+int wal_checkpoint(struct Address_book *addressbook) // Snapshot the book on this thread and drop the whole log
+{
+    struct Wal *wal = addressbook->wal;
+    if (wal->compacting)
+        finish_compaction(wal);
+    if (addressbook->strings.garbage > 0)
+        compact_strings(addressbook); // Best effort: save_snapshot packs a copy otherwise
+    pthread_mutex_lock(&wal->lock);
+    wal->generation++;                  // Records already logged are older than the snapshot
+    wal->compact_generation = wal->generation;
+    wal->compact_from = wal->size;
+    wal->compact_from_records = wal->records;
+    pthread_mutex_unlock(&wal->lock);
+    wal->compact_status = save_snapshot(addressbook, wal->snapshot_path, wal->compact_generation);
+    complete_compaction(wal); // Trim the log to its (empty) tail
+    return wal->compact_status;
+}
+
+int wal_sync(struct Address_book *addressbook) // Block until the flusher has committed every write so far
+{
+    struct Wal *wal = addressbook->wal;
+    uint64_t start = stats_begin();
+    pthread_mutex_lock(&wal->lock);
+    unsigned long long target = wal->written;
+    wal->waiters++;
+    pthread_cond_signal(&wal->changed);
+    while (wal->synced < target)
+        pthread_cond_wait(&wal->changed, &wal->lock);
+    wal->waiters--;
+    int status = wal->failed ? -1 : 0;
+    pthread_mutex_unlock(&wal->lock);
+    stats_end(STAT_WAL_SYNC, start);
+    return status;
+}
+
+int wal_close(struct Address_book *addressbook) // Detach the log, with every change durable
+{
+    struct Wal *wal = addressbook->wal;
+    if (wal->compacting)
+        finish_compaction(wal);
+
+    pthread_mutex_lock(&wal->lock);
+    wal->stop = 1; // Flusher syncs what is left, then exits
+    pthread_cond_signal(&wal->changed);
+    pthread_mutex_unlock(&wal->lock);
+    pthread_join(wal->flusher, NULL);
+
+    int status = wal->failed ? -1 : 0;
+    if (close(wal->fd) != 0)
+        status = -1;
+    pthread_mutex_destroy(&wal->lock);
+    pthread_cond_destroy(&wal->changed);
+    free(wal->path);
+    free(wal->snapshot_path);
+    free(wal);
+    addressbook->wal = NULL;
+    return status;
+}
@@ -0,0 +1,58 @@
+#ifndef WAL_H               // Header guard start, prevents multiple inclusion
+#define WAL_H
+
+#include <stdint.h>         // uint64_t generations
+#include <pthread.h>        // Flusher and compaction threads
+#include <sys/types.h>      // off_t
+#include "arena.h"          // Strings of the copy being compacted
+
+struct Address_book;        // Defined in contact.h
+struct Contact_record;
+
+#define WAL_ADD 1           // Record: contact appended
+#define WAL_EDIT 2          // Record: contact with 'key' mobile number replaced
+#define WAL_DELETE 3        // Record: contact with 'key' mobile number removed
+
+#define WAL_COMMIT_DELAY_MS 5       // Flusher waits this long so one fsync covers several changes
+#define WAL_COMPACT_MIN 4096        // Log records before compaction is considered
+
+/*------------------ Structure Declarations ------------------*/
+
+struct Wal                  // Append-only change log on top of a snapshot
+{
+    int fd;                 // Log file, positioned at its end
+    char *path;             // Log file name
+    char *snapshot_path;    // Snapshot that compaction replaces
+    uint64_t generation;    // Stamped on new records; snapshots of a higher generation already hold them
+    off_t size;             // Bytes of valid log
+    long records;           // Records in the log
+    pthread_mutex_t lock;   // Guards everything below and the fd while writing
+    pthread_cond_t changed; // Signals new writes to the flusher and finished syncs to waiters
+    pthread_t flusher;      // Group-commit thread
+    unsigned long long written, synced; // Records written / covered by an fsync
+    int syncing;            // Flusher is inside sync_file on 'fd'
+    int waiters;            // Threads blocked in wal_sync, the flusher then syncs without delay
+    int stop;               // Flusher should exit once everything is synced
+    int failed;             // A write or fsync failed since the log was opened
+    pthread_t compactor;    // Background snapshot writer
+    int compacting;         // compactor has been started and not yet joined
+    int compact_done;       // compactor has finished writing
+    int compact_status;     // Its result, 0 or -1
+    uint64_t compact_generation; // Generation of the snapshot being written
+    off_t compact_from;     // Log offset where records of the new generation start
+    long compact_from_records; // Records in the log before that offset
+    struct Contact_record *compact_records; // Copy of the book being written
+    struct Text_arena compact_strings; // Its names and mail IDs
+    int *compact_order;     // Its name order
+    int compact_count;      // Its contact count
+};
+
+/*------------------ Function Declarations ------------------*/
+
+int wal_open(struct Address_book *addressbook, const char *path, const char *snapshot_path, long long generation); // Replay (generation >= 0) or start afresh (< 0), then log every change; records replayed or -1
+int wal_sync(struct Address_book *addressbook); // Wait until every logged change is on disk, 0 or -1
+int wal_checkpoint(struct Address_book *addressbook); // Write the book as the next snapshot now and empty the log (after changes made unlogged), 0 or -1
+int wal_close(struct Address_book *addressbook); // Finish compaction, sync and stop logging, 0 or -1
+void wal_log_change(struct Address_book *addressbook, int op, const char *key, int contact); // Append one change made to contact (-1 for deletes) by store.c, may start a compaction
+
+#endif // WAL_H              // End of header guard
@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------------------
+-> File         : workers.c
+-> Description  : Thread-count knob and a tiny fork/join helper shared by the
+                  parallel loader and the parallel sort.
+                  A phase started from inside another one's job (a shard
+                  loading its file while the other shards load theirs,
+                  shard.c) gets its job's share of the threads instead of
+                  all of them, so nesting never starts threads squared.
+------------------------------------------------------------------------------*/
+#include <stdlib.h>     // Include getenv, atoi
+#include <pthread.h>    // Include POSIX threads
+#include <unistd.h>     // Include sysconf to count CPUs
+#include "workers.h"    // Include worker declarations
+
+static int configured_threads = 0; // 0 = decide automatically
+static _Thread_local int thread_share; // Threads a phase started on this thread may use, 0 = no limit
+
+struct Worker_start         // One job handed to a new thread
+{
+    void *(*work)(void *);
+    void *job;
+    int share;              // Its thread_share
+};
+
+static void *start_worker(void *arg) // Thread entry: take the share, run the job
+{
+    struct Worker_start *start = arg;
+    thread_share = start->share;
+    return start->work(start->job);
+}
+
+void set_worker_threads(int threads) // Knob used by the CLI and benchmarks
+{
+    configured_threads = threads > 0 ? (threads > MAX_WORKERS ? MAX_WORKERS : threads) : 0;
+}
+
+int worker_threads(void) // How many threads parallel phases should use
+{
+    int threads = configured_threads;
+    if (threads <= 0)
+    {
+        const char *env = getenv("ADDRESSBOOK_THREADS"); // Environment override
+        threads = env ? atoi(env) : 0;
+    }
+    if (threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (thread_share > 0 && threads > thread_share)
+        threads = thread_share; // Inside another phase's job, whichever way the count was chosen
+    return threads > MAX_WORKERS ? MAX_WORKERS : threads;
+}
+
+void run_workers(void *(*work)(void *), void *jobs, size_t job_size, int count) // Fork count jobs, join them all
+{
+    int threads = count < MAX_WORKERS ? count : MAX_WORKERS; // Callers size their jobs by worker_threads(); any past MAX_WORKERS run on the calling thread, never dropped
+    pthread_t tid[MAX_WORKERS];
+    struct Worker_start starts[MAX_WORKERS];
+    int started[MAX_WORKERS] = { 0 };
+    char *base = jobs;
+    int share = count > 0 && worker_threads() > count ? worker_threads() / count : 1; // For phases the jobs start
+
+    for (int i = 1; i < threads; i++) // Job 0 runs on the calling thread
+    {
+        starts[i] = (struct Worker_start){ work, base + i * job_size, share };
+        started[i] = pthread_create(&tid[i], NULL, start_worker, &starts[i]) == 0;
+    }
+    int own_share = thread_share;
+    thread_share = share;
+    if (count > 0)
+        work(base);
+    for (int i = threads; i < count; i++)
+        work(base + i * job_size);
+    for (int i = 1; i < threads; i++)
+    {
+        if (started[i])
+            pthread_join(tid[i], NULL);
+        else
+            work(base + i * job_size); // Could not start a thread: do the job here
+    }
+    thread_share = own_share;
+}
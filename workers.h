@@ -0,0 +1,14 @@
+#ifndef WORKERS_H           // Header guard start, prevents multiple inclusion
+#define WORKERS_H
+
+#include <stddef.h>         // size_t
+
+#define MAX_WORKERS 64      // Upper bound on worker threads for any parallel phase
+
+/*------------------ Function Declarations ------------------*/
+
+void set_worker_threads(int threads); // Force the number of worker threads (0 = automatic)
+int worker_threads(void); // Threads to use: set_worker_threads, else $ADDRESSBOOK_THREADS, else CPU count (a share of them inside a worker job)
+void run_workers(void *(*work)(void *), void *jobs, size_t job_size, int count); // Run work(&jobs[i]) for i < count in parallel, wait for all
+
+#endif // WORKERS_H          // End of header guard